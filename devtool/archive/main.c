@@ -0,0 +1,148 @@
+#define _FILE_OFFSET_BITS 64
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <errno.h>
+
+#include "../../process/archive.h" //File format
+
+/* Query columnar archive written by the program, usage: ./archive <prefix> [-t fromMs toMs] [-s minSpeed maxSpeed] [-x minRx maxRx] [-y minRy maxRy]
+ * -t: Unix time (ms) range; -s: Speed (km/h) range; -x, -y: Road-domain location (meter) range. All ranges are inclusive.
+ * Only the index file is scanned. A block is read only if its stats overlap all ranges; in that block, frame and speed columns
+ * are read first, other columns are read only if some samples pass the time and speed filter.
+ * Output: time(ms) frame speed rx,ry sx,sy osy
+ */
+
+#define MAX_BLOCKSIZE 65536
+
+struct range {
+	double min, max;
+};
+
+int main(int argc, char* argv[]) {
+	int statue = EXIT_FAILURE;
+	FILE* fpIndex = NULL;
+	FILE* fpData = NULL;
+	int32_t* frame = NULL;
+	int16_t* speed = NULL;
+	float* rx = NULL, * ry = NULL;
+	uint16_t* sx = NULL, * sy = NULL;
+	int16_t* osy = NULL;
+	uint32_t* match = NULL;
+	char path[4096];
+
+	struct range t = {-1e300, 1e300}, s = t, x = t, y = t;
+	if (argc < 2 || !(argc % 3 == 2)) {
+		fprintf(stderr, "Usage: %s <prefix> [-t fromMs toMs] [-s minSpeed maxSpeed] [-x minRx maxRx] [-y minRy maxRy]\n", argv[0]);
+		goto label_exit;
+	}
+	for (int i = 2; i < argc; i += 3) {
+		struct range r = {atof(argv[i+1]), atof(argv[i+2])};
+		if (!strcmp(argv[i], "-t")) t = r;
+		else if (!strcmp(argv[i], "-s")) s = r;
+		else if (!strcmp(argv[i], "-x")) x = r;
+		else if (!strcmp(argv[i], "-y")) y = r;
+		else {
+			fprintf(stderr, "Unknown filter %s\n", argv[i]);
+			goto label_exit;
+		}
+	}
+
+	snprintf(path, sizeof(path), "%s.idx", argv[1]);
+	fpIndex = fopen(path, "rb");
+	snprintf(path, sizeof(path), "%s.col", argv[1]);
+	fpData = fopen(path, "rb");
+	if (!fpIndex || !fpData) {
+		fprintf(stderr, "Cannot open archive index or data file (errno = %d)\n", errno);
+		goto label_exit;
+	}
+
+	frame = malloc(MAX_BLOCKSIZE * sizeof(int32_t));
+	speed = malloc(MAX_BLOCKSIZE * sizeof(int16_t));
+	rx = malloc(MAX_BLOCKSIZE * sizeof(float));
+	ry = malloc(MAX_BLOCKSIZE * sizeof(float));
+	sx = malloc(MAX_BLOCKSIZE * sizeof(uint16_t));
+	sy = malloc(MAX_BLOCKSIZE * sizeof(uint16_t));
+	osy = malloc(MAX_BLOCKSIZE * sizeof(int16_t));
+	match = malloc(MAX_BLOCKSIZE * sizeof(uint32_t));
+	if (!frame || !speed || !rx || !ry || !sx || !sy || !osy || !match) {
+		fprintf(stderr, "Cannot allocate memory (errno = %d)\n", errno);
+		goto label_exit;
+	}
+
+	unsigned long long int blockCnt = 0, blockRead = 0, sampleRead = 0, sampleMatch = 0;
+	archive_block b;
+	while (fread(&b, sizeof(b), 1, fpIndex)) {
+		blockCnt++;
+		if (b.magic != ARCHIVE_MAGIC || b.count > MAX_BLOCKSIZE) {
+			fprintf(stderr, "Bad index entry %llu\n", blockCnt - 1);
+			goto label_exit;
+		}
+
+		//Skip block by stats
+		if (b.timeMax < t.min || b.timeMin > t.max) continue;
+		if (b.speedMax < s.min || b.speedMin > s.max) continue;
+		if (b.rxMax < x.min || b.rxMin > x.max) continue;
+		if (b.ryMax < y.min || b.ryMin > y.max) continue;
+		blockRead++;
+		sampleRead += b.count;
+
+		//Filter by frame (time) and speed columns first
+		#define readColumn(col, index) ( \
+			!fseeko(fpData, b.offset + (off_t)b.count * (index), SEEK_SET) && \
+			fread(col, sizeof(col[0]), b.count, fpData) == b.count \
+		)
+		off_t offFrame = 0;
+		off_t offSpeed = offFrame + sizeof(int32_t);
+		off_t offRx = offSpeed + sizeof(int16_t);
+		off_t offRy = offRx + sizeof(float);
+		off_t offSx = offRy + sizeof(float);
+		off_t offSy = offSx + sizeof(uint16_t);
+		off_t offOsy = offSy + sizeof(uint16_t);
+		if (!readColumn(frame, offFrame) || !readColumn(speed, offSpeed)) {
+			fprintf(stderr, "Cannot read block %llu (errno = %d)\n", blockCnt - 1, errno);
+			goto label_exit;
+		}
+		uint32_t matchCnt = 0;
+		for (uint32_t i = 0; i < b.count; i++) {
+			double time = b.runStart + (int64_t)(frame[i] * 1000.0 / b.fps);
+			if (time >= t.min && time <= t.max && speed[i] >= s.min && speed[i] <= s.max)
+				match[matchCnt++] = i;
+		}
+		if (!matchCnt)
+			continue;
+
+		//Then location columns and the rest
+		if (!readColumn(rx, offRx) || !readColumn(ry, offRy) || !readColumn(sx, offSx) || !readColumn(sy, offSy) || !readColumn(osy, offOsy)) {
+			fprintf(stderr, "Cannot read block %llu (errno = %d)\n", blockCnt - 1, errno);
+			goto label_exit;
+		}
+		#undef readColumn
+		for (uint32_t j = 0; j < matchCnt; j++) {
+			uint32_t i = match[j];
+			if (rx[i] < x.min || rx[i] > x.max || ry[i] < y.min || ry[i] > y.max)
+				continue;
+			sampleMatch++;
+			fprintf(stdout, "%"PRId64" %d %d %.2f,%.2f %u,%u %d\n", b.runStart + (int64_t)(frame[i] * 1000.0 / b.fps), frame[i], speed[i], rx[i], ry[i], sx[i], sy[i], osy[i]);
+		}
+	}
+	fprintf(stderr, "%llu of %llu blocks read, %llu samples scanned, %llu samples match\n", blockRead, blockCnt, sampleRead, sampleMatch);
+
+	statue = EXIT_SUCCESS;
+
+label_exit:
+	free(match);
+	free(osy);
+	free(sy);
+	free(sx);
+	free(ry);
+	free(rx);
+	free(speed);
+	free(frame);
+	if (fpData)
+		fclose(fpData);
+	if (fpIndex)
+		fclose(fpIndex);
+	return statue;
+}
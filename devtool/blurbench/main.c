@@ -0,0 +1,198 @@
+#define _FILE_OFFSET_BITS 64
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <errno.h>
+
+#include "../../process/gl.h"
+
+/* Benchmark blur filter on recorded video, usage: ./blurbench <video> width height [frames [repeat]]
+ * video: Frames of width * height * RGBA8, e.g. devtool/synth output, or raw video converted by ffmpeg (-pix_fmt rgba -f rawvideo)
+ * frames: Number of frames to use, default 16; repeat: Number of draws of each frame, default 10
+ * Runs blurFilter shader (../../process/shader/blurFilter.glsl) with 9 texel fetches and with 4 bilinear taps (BILINEAR) on the same frames,
+ * reports GPU time of each and the difference of the output, inner px and frame edge px separately (edge px is 0 outside with texel fetch, repeated with bilinear taps).
+ * Edge is 2 px wide: the mediump px index of the shader may be the next px near the right and bottom edge, so the 3*3 of the second last px reads out of frame.
+ * Renders off-screen (EGL surfaceless), works without window system and GPU.
+ * Build: gcc -O2 main.c ../../process/gl.c -lGLEW -lglfw -lEGL -lGL -lm -o blurbench
+ */
+
+#define SHADER "f../../process/shader/blurFilter.glsl"
+#define MAX_DIFF 3 //Histogram of difference: 0, 1, 2, 3 or more
+#define EDGE 2 //Width of frame edge in px
+
+int main(int argc, char* argv[]) {
+	int statue = EXIT_FAILURE;
+	FILE* fp = NULL;
+	uint8_t* data = NULL;
+	uint8_t* result[2] = {NULL, NULL};
+	int glReady = 0;
+	gl_tex texture[2] = {GL_INIT_DEFAULT_TEX, GL_INIT_DEFAULT_TEX}; //Same frame, nearest and linear filter
+	gl_tex target[2] = {GL_INIT_DEFAULT_TEX, GL_INIT_DEFAULT_TEX};
+	gl_fbo fbo[2] = {GL_INIT_DEFAULT_FBO, GL_INIT_DEFAULT_FBO};
+	gl_program program[2] = {GL_INIT_DEFAULT_PROGRAM, GL_INIT_DEFAULT_PROGRAM};
+	gl_param src[2];
+	gl_mesh mesh = GL_INIT_DEFAULT_MESH;
+	gl_timer timer = GL_INIT_DEFAULT_TIMER;
+
+	if (argc != 4 && argc != 5 && argc != 6) {
+		fprintf(stderr, "Usage: %s <video> width height [frames [repeat]]\n", argv[0]);
+		goto label_exit;
+	}
+	const unsigned int size[3] = {atoi(argv[2]), atoi(argv[3]), 0};
+	unsigned int frames = argc >= 5 ? atoi(argv[4]) : 16, repeat = argc >= 6 ? atoi(argv[5]) : 10;
+	if (size[0] <= 2 * EDGE || size[1] <= 2 * EDGE || size[0] > UINT16_MAX || size[1] > UINT16_MAX || !frames || !repeat) {
+		fprintf(stderr, "Bad size, frames or repeat\n");
+		goto label_exit;
+	}
+	const size_t frameSize = (size_t)size[0] * size[1] * 4;
+
+	fp = fopen(argv[1], "rb");
+	if (!fp) {
+		fprintf(stderr, "Cannot open video file (errno = %d)\n", errno);
+		goto label_exit;
+	}
+	data = malloc(frameSize * frames);
+	result[0] = malloc(frameSize);
+	result[1] = malloc(frameSize);
+	if (!data || !result[0] || !result[1]) {
+		fprintf(stderr, "Cannot allocate memory (errno = %d)\n", errno);
+		goto label_exit;
+	}
+	frames = fread(data, frameSize, frames, fp);
+	if (!frames) {
+		fprintf(stderr, "No frame in video file\n");
+		goto label_exit;
+	}
+
+	if (!gl_init((gl_config){.vMajor = 3, .vMinor = 1, .gles = 1, .winWidth = size[0], .winHeight = size[1], .winName = "blurbench", .backend = gl_backend_egl})) {
+		fprintf(stderr, "Cannot init OpenGL\n");
+		goto label_exit;
+	}
+	glReady = 1;
+
+	const gl_vertex_t vertices[] = {1.0f, 0.0f, 1.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f}; //Entire frame, same as the program
+	mesh = gl_mesh_create(4, 0, 0, gl_meshmode_triangleFan, (const gl_index_t[]){2, 0}, NULL, vertices, NULL, NULL);
+	const gl_tex_dim dim[3] = {
+		{.size = size[0], .wrapping = gl_tex_dimWrapping_edge},
+		{.size = size[1], .wrapping = gl_tex_dimWrapping_edge},
+		{.size = 0, .wrapping = gl_tex_dimWrapping_edge}
+	};
+	const char* const header[2] = {"#version 310 es\n", "#version 310 es\n#define BILINEAR\n"};
+	const gl_tex_dimFilter filter[2] = {gl_tex_dimFilter_nearest, gl_tex_dimFilter_linear};
+	for (unsigned int i = 0; i < 2; i++) {
+		texture[i] = gl_texture_create(gl_texformat_RGBA8, gl_textype_2d, filter[i], filter[i], dim);
+		target[i] = gl_texture_create(gl_texformat_RGBA8, gl_textype_2d, gl_tex_dimFilter_nearest, gl_tex_dimFilter_nearest, dim);
+		if (!gl_texture_check(&texture[i]) || !gl_texture_check(&target[i])) {
+			fprintf(stderr, "Cannot create texture\n");
+			goto label_exit;
+		}
+		fbo[i] = gl_frameBuffer_create(1, (const gl_tex[]){target[i]}, (const gl_fboattach[]){gl_fboattach_color0});
+		if (!gl_frameBuffer_check(&fbo[i])) {
+			fprintf(stderr, "Cannot create FBO\n");
+			goto label_exit;
+		}
+		gl_programArg arg[] = {{gl_programArgType_normal, "src"}, {.name = NULL}};
+		gl_program_setCommonHeader(header[i]);
+		if (!( program[i] = gl_program_load(SHADER, arg) )) {
+			fprintf(stderr, "Cannot load shader %s\n", SHADER + 1);
+			goto label_exit;
+		}
+		src[i] = arg[0].id;
+	}
+	if (!gl_mesh_check(&mesh)) {
+		fprintf(stderr, "Cannot create mesh\n");
+		goto label_exit;
+	}
+	timer = gl_timer_create(4, 3);
+	if (!gl_timer_check(&timer)) {
+		fprintf(stderr, "Cannot create GPU timer\n");
+		goto label_exit;
+	}
+	gl_setViewport((const unsigned int[2]){0, 0}, size);
+
+	uint64_t time[2] = {0, 0}, timeCnt = 0;
+	unsigned long long int diff[2][MAX_DIFF + 1] = {{0}}; //Inner and edge px, histogram of max difference of channels
+	unsigned int diffMax = 0;
+	void readTimer(int wait) {
+		unsigned int tag;
+		uint64_t duration[2];
+		while (gl_timer_read(&timer, wait, &tag, duration) == 3) {
+			time[0] += duration[0];
+			time[1] += duration[1];
+			timeCnt++;
+		}
+	}
+	for (unsigned int f = 0; f < frames; f++) {
+		for (unsigned int i = 0; i < 2; i++)
+			gl_texture_update(&texture[i], data + f * frameSize, (const unsigned int[3]){0, 0, 0}, size);
+
+		for (unsigned int r = 0; r < repeat; r++) {
+			gl_timer_stamp(&timer);
+			for (unsigned int i = 0; i < 2; i++) {
+				gl_frameBuffer_bind(&fbo[i], gl_frameBuffer_clearAll);
+				gl_program_use(&program[i]);
+				gl_texture_bind(&texture[i], src[i], 0);
+				gl_mesh_draw(&mesh, 0, 0);
+				gl_timer_stamp(&timer);
+			}
+			gl_timer_frameEnd(&timer, f);
+			readTimer(0);
+		}
+
+		for (unsigned int i = 0; i < 2; i++)
+			gl_frameBuffer_download(&fbo[i], result[i], gl_texformat_RGBA8, 0, (const unsigned int[2]){0, 0}, size);
+		for (unsigned int y = 0; y < size[1]; y++) {
+			for (unsigned int x = 0; x < size[0]; x++) {
+				const size_t idx = ((size_t)y * size[0] + x) * 4;
+				unsigned int d = 0;
+				for (unsigned int c = 0; c < 4; c++) {
+					const unsigned int dc = abs((int)result[0][idx + c] - (int)result[1][idx + c]);
+					if (dc > d)
+						d = dc;
+				}
+				const int edge = x < EDGE || y < EDGE || x >= size[0] - EDGE || y >= size[1] - EDGE;
+				diff[edge][d > MAX_DIFF ? MAX_DIFF : d]++;
+				if (!edge && d > diffMax)
+					diffMax = d;
+			}
+		}
+	}
+	readTimer(1);
+
+	fprintf(stdout, "%u frames of %u*%u, %u draws each\n", frames, size[0], size[1], repeat);
+	const char* const name[2] = {"texel fetch (9)", "bilinear (4)"};
+	for (unsigned int i = 0; i < 2; i++)
+		fprintf(stdout, "%-20s %8.3lf ms/frame\n", name[i], timeCnt ? time[i] / 1e6 / timeCnt : 0.0);
+	for (unsigned int e = 0; e < 2; e++) {
+		unsigned long long int total = 0;
+		for (unsigned int d = 0; d <= MAX_DIFF; d++)
+			total += diff[e][d];
+		fprintf(stdout, "%-20s", e ? "edge px" : "inner px");
+		for (unsigned int d = 0; d <= MAX_DIFF; d++)
+			fprintf(stdout, " %s%u: %.4lf%%", d == MAX_DIFF ? ">=" : "", d, 100.0 * diff[e][d] / total);
+		fprintf(stdout, "\n");
+	}
+	fprintf(stdout, "Max difference of inner px: %u/255\n", diffMax);
+
+	statue = EXIT_SUCCESS;
+
+label_exit:
+	if (glReady) {
+		gl_timer_delete(&timer);
+		for (unsigned int i = 2; i; i--) {
+			gl_program_delete(&program[i-1]);
+			gl_frameBuffer_delete(&fbo[i-1]);
+			gl_texture_delete(&target[i-1]);
+			gl_texture_delete(&texture[i-1]);
+		}
+		gl_mesh_delete(&mesh);
+		gl_destroy();
+	}
+	free(result[1]);
+	free(result[0]);
+	free(data);
+	if (fp)
+		fclose(fp);
+	return statue;
+}
@@ -0,0 +1,111 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <errno.h>
+
+#include "../../process/rollup.h" //File format
+
+/* Print rollup file written by the program, usage: ./rollup <file> [merge]
+ * Histogram of <merge> consecutive intervals are added together (default 1), so the same file can be viewed per minute, per hour...
+ * Output: time(second) lane count mean min max p50 p85 p95
+ */
+
+struct laneStat {
+	uint32_t count, sum;
+	uint8_t min, max;
+	uint32_t histogram[256];
+};
+
+uint8_t quantile(const struct laneStat* const s, const float q) {
+	uint32_t rank = q * s->count + 0.5f;
+	if (!rank)
+		rank = 1;
+	uint32_t accum = 0;
+	for (unsigned int speed = 0; speed < 256; speed++) {
+		accum += s->histogram[speed];
+		if (accum >= rank)
+			return speed;
+	}
+	return 255;
+}
+
+int main(int argc, char* argv[]) {
+	int statue = EXIT_FAILURE;
+	FILE* fp = NULL;
+	struct laneStat* lanes = NULL;
+
+	if (argc < 2) {
+		fprintf(stderr, "Usage: %s <file> [merge]\n", argv[0]);
+		goto label_exit;
+	}
+	unsigned int merge = argc > 2 ? atoi(argv[2]) : 1;
+	if (!merge)
+		merge = 1;
+
+	fp = fopen(argv[1], "rb");
+	if (!fp) {
+		fprintf(stderr, "Cannot open rollup file (errno = %d)\n", errno);
+		goto label_exit;
+	}
+	rollup_fileHeader header;
+	if (!fread(&header, sizeof(header), 1, fp) || memcmp(header.magic, ROLLUP_MAGIC, 4) || header.version != ROLLUP_VERSION) {
+		fprintf(stderr, "Bad rollup file header\n");
+		goto label_exit;
+	}
+	fprintf(stderr, "Rollup file: %u lanes, interval %u frames (%.1f fps), merge %u intervals\n", header.laneCnt, header.interval, header.fps, merge);
+
+	lanes = calloc(header.laneCnt, sizeof(struct laneStat));
+	if (!lanes) {
+		fprintf(stderr, "Cannot allocate memory (errno = %d)\n", errno);
+		goto label_exit;
+	}
+
+	long long int group = -1; //Current merged group index
+	for (;;) {
+		rollup_record record;
+		int eof = !fread(&record, sizeof(record), 1, fp);
+		rollup_bin bins[256];
+		if (!eof && (record.lane >= header.laneCnt || record.binCnt > 256 || fread(bins, sizeof(rollup_bin), record.binCnt, fp) != record.binCnt)) {
+			fprintf(stderr, "Bad record\n");
+			goto label_exit;
+		}
+
+		//New group or end of file, print previous group
+		if (group != -1 && (eof || record.index / merge != group)) {
+			for (unsigned int lane = 0; lane < header.laneCnt; lane++) {
+				struct laneStat* s = &lanes[lane];
+				fprintf(stdout, "%.0f %u %u", group * merge * header.interval / header.fps, lane, s->count);
+				if (s->count)
+					fprintf(stdout, " %.1f %u %u %u %u %u\n", (float)s->sum / s->count, s->min, s->max, quantile(s, 0.5f), quantile(s, 0.85f), quantile(s, 0.95f));
+				else
+					fprintf(stdout, " - - - - - -\n");
+			}
+			memset(lanes, 0, header.laneCnt * sizeof(struct laneStat));
+		}
+		if (eof)
+			break;
+		group = record.index / merge;
+
+		//Merge record into group
+		struct laneStat* s = &lanes[record.lane];
+		if (record.count) {
+			if (!s->count || record.min < s->min)
+				s->min = record.min;
+			if (!s->count || record.max > s->max)
+				s->max = record.max;
+		}
+		s->count += record.count;
+		s->sum += record.sum;
+		for (unsigned int i = 0; i < record.binCnt; i++)
+			s->histogram[bins[i].speed] += bins[i].count;
+	}
+
+	statue = EXIT_SUCCESS;
+
+label_exit:
+	free(lanes);
+	if (fp)
+		fclose(fp);
+	return statue;
+}
@@ -0,0 +1,110 @@
+#define _FILE_OFFSET_BITS 64
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <errno.h>
+
+#include "../../process/common.h" //nanotime()
+#include "../../process/scan.h"
+
+/* Benchmark speed map scan on recorded speed maps, usage: ./scanbench <speedmap> width height [left right top bottom [repeat]]
+ * speedmap: File written by the program with SPEEDMAP_DUMP set, frames of width * height * RG8 (ROI size, logged by the program at start)
+ * left right top bottom: Box of interest in px, inclusive, default is the entire frame
+ * Compares byte-by-byte scan, vectorized scan, and vectorized scan that skips empty rows (as with row occupancy map).
+ * Row occupancy is computed here before timing, the same as the program gets it from GPU.
+ * Build: gcc -O3 -march=native main.c ../../process/scan.c ../../process/common.c -o scanbench
+ */
+
+#define MAX_FRAME 256
+
+int main(int argc, char* argv[]) {
+	int statue = EXIT_FAILURE;
+	FILE* fp = NULL;
+	uint8_t* data = NULL;
+	uint8_t* occupancy = NULL;
+	unsigned int* xs = NULL;
+
+	if (argc != 4 && argc != 8 && argc != 9) {
+		fprintf(stderr, "Usage: %s <speedmap> width height [left right top bottom [repeat]]\n", argv[0]);
+		goto label_exit;
+	}
+	unsigned int width = atoi(argv[2]), height = atoi(argv[3]);
+	unsigned int left = 0, right = width - 1, top = 0, bottom = height - 1, repeat = 10;
+	if (argc >= 8) {
+		left = atoi(argv[4]);
+		right = atoi(argv[5]);
+		top = atoi(argv[6]);
+		bottom = atoi(argv[7]);
+	}
+	if (argc == 9)
+		repeat = atoi(argv[8]);
+	if (!width || !height || left > right || right >= width || top > bottom || bottom >= height || !repeat) {
+		fprintf(stderr, "Bad size or box\n");
+		goto label_exit;
+	}
+	size_t frameSize = (size_t)width * height * 2;
+
+	fp = fopen(argv[1], "rb");
+	if (!fp) {
+		fprintf(stderr, "Cannot open speed map file (errno = %d)\n", errno);
+		goto label_exit;
+	}
+	data = malloc(frameSize * MAX_FRAME);
+	occupancy = malloc((size_t)height * MAX_FRAME);
+	xs = malloc(width * sizeof(unsigned int));
+	if (!data || !occupancy || !xs) {
+		fprintf(stderr, "Cannot allocate memory (errno = %d)\n", errno);
+		goto label_exit;
+	}
+	unsigned int frameCnt = fread(data, frameSize, MAX_FRAME, fp);
+	if (!frameCnt) {
+		fprintf(stderr, "No frame in speed map file\n");
+		goto label_exit;
+	}
+
+	unsigned long long int sampleCnt = 0, rowCnt = 0, rowOccupied = 0;
+	for (unsigned int f = 0; f < frameCnt; f++) {
+		for (unsigned int y = top; y <= bottom; y++) {
+			unsigned int cnt = scan_rowScalar(data + f * frameSize + (size_t)y * width * 2, left, right, 1, xs, width);
+			occupancy[f * height + y] = cnt ? 1 : 0;
+			sampleCnt += cnt;
+			rowCnt++;
+			rowOccupied += cnt ? 1 : 0;
+		}
+	}
+	fprintf(stdout, "%u frames of %u*%u, box %u-%u * %u-%u, %llu samples, %llu of %llu rows occupied, %s\n", frameCnt, width, height, left, right, top, bottom, sampleCnt, rowOccupied, rowCnt, scan_isa());
+
+	const char* name[] = {"scalar", "vector", "vector + row skip"};
+	for (unsigned int method = 0; method < 3; method++) {
+		unsigned long long int check = 0;
+		uint64_t start = nanotime();
+		for (unsigned int r = 0; r < repeat; r++) {
+			for (unsigned int f = 0; f < frameCnt; f++) {
+				for (unsigned int y = top; y <= bottom; y++) {
+					const uint8_t* row = data + f * frameSize + (size_t)y * width * 2;
+					if (method == 0)
+						check += scan_rowScalar(row, left, right, 1, xs, width);
+					else if (method == 1 || occupancy[f * height + y])
+						check += scan_row(row, left, right, 1, xs, width);
+				}
+			}
+		}
+		uint64_t time = nanotime() - start;
+		if (check != sampleCnt * repeat) {
+			fprintf(stderr, "Result mismatch: %s finds %llu samples, expected %llu\n", name[method], check, sampleCnt * repeat);
+			goto label_exit;
+		}
+		fprintf(stdout, "%-20s %8.3lf us/frame\n", name[method], time / 1e3 / repeat / frameCnt);
+	}
+
+	statue = EXIT_SUCCESS;
+
+label_exit:
+	free(xs);
+	free(occupancy);
+	free(data);
+	if (fp)
+		fclose(fp);
+	return statue;
+}
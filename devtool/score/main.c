@@ -0,0 +1,199 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+
+/* Score the program output against the ground truth of a synthetic video, usage: ./score <truth> <output> [benchmark] [-x gateX] [-o offset]
+ * truth: Written by devtool/synth; output: stdout of the program in track mode ("T" lines, other lines are ignored)
+ * benchmark: JSON report (--json) or stderr log of the program, for throughput ("fps" of the report, or "Throughput" logged by the analysis thread)
+ * -x: Max lateral distance (meter) between a track and a vehicle to match (default 1.0)
+ * -o: Frame number of the program for the first frame of the video (default 2: a frame is read in loop i and processed in loop i+2)
+ * A track is matched to the vehicle with the most overlapping frames in its lane, one track per vehicle (others are duplicates).
+ * Detection rate counts full vehicles only (leave the focus region before the video ends); speed error is over matched full vehicles.
+ * Output: a human-readable report, and a last line "score <detected> <full> <duplicate> <false> <bias> <mae> <rmse> <fps>" for scripts.
+ * Build: gcc -O3 main.c -lm -o score
+ */
+
+#define FRAME_OFFSET 2
+
+struct vehicle {
+	unsigned int id;
+	float speed, laneX;
+	int first, last, full;
+	int track; //Index of matched track, -1 if not detected
+	int overlap; //Number of overlapping frames with matched track
+};
+
+struct track {
+	unsigned int id;
+	int entry, exit;
+	unsigned int count;
+	int speedMedian, speedMax;
+	float laneX;
+	int vehicle; //Index of matched vehicle, -1 if false track
+};
+
+/** Read lines of a file as records, grows the buffer */
+static void* readRecords(const char* const file, size_t size, unsigned int* const cnt, int (*parse)(const char* line, void* record)) {
+	FILE* fp = fopen(file, "r");
+	if (!fp)
+		return NULL;
+	unsigned int cap = 256;
+	void* records = malloc(cap * size);
+	char line[256];
+	*cnt = 0;
+	while (records && fgets(line, sizeof(line), fp)) {
+		if (*cnt == cap) {
+			cap *= 2;
+			void* new = realloc(records, cap * size);
+			if (!new) {
+				free(records);
+				records = NULL;
+				break;
+			}
+			records = new;
+		}
+		if (parse(line, (char*)records + *cnt * size))
+			(*cnt)++;
+	}
+	fclose(fp);
+	return records;
+}
+
+static int parseVehicle(const char* line, void* record) {
+	struct vehicle* v = record;
+	v->track = -1;
+	v->overlap = 0;
+	return sscanf(line, "V %u %*u %f %f %d-%d %d", &v->id, &v->speed, &v->laneX, &v->first, &v->last, &v->full) == 6;
+}
+
+static int parseTrack(const char* line, void* record) {
+	struct track* t = record;
+	t->vehicle = -1;
+	return sscanf(line, "T %u %d-%d %u %d %d %f", &t->id, &t->entry, &t->exit, &t->count, &t->speedMedian, &t->speedMax, &t->laneX) == 7;
+}
+
+/** Get throughput from a benchmark report or a log, 0 if not found */
+static float readThroughput(const char* const file) {
+	FILE* fp = fopen(file, "r");
+	if (!fp)
+		return 0;
+	float fps = 0;
+	char line[256];
+	while (fgets(line, sizeof(line), fp)) {
+		const char* s;
+		if ((s = strstr(line, "\"fps\":")))
+			fps = atof(s + strlen("\"fps\":"));
+		else if ((s = strstr(line, "Throughput:")))
+			fps = atof(s + strlen("Throughput:"));
+	}
+	fclose(fp);
+	return fps;
+}
+
+int main(int argc, char* argv[]) {
+	int statue = EXIT_FAILURE;
+	struct vehicle* vehicles = NULL;
+	struct track* tracks = NULL;
+
+	float gateX = 1.0;
+	int offset = FRAME_OFFSET;
+	const char* benchmarkFile = NULL;
+	if (argc < 3) {
+		fprintf(stderr, "Usage: %s <truth> <output> [benchmark] [-x gateX] [-o offset]\n", argv[0]);
+		goto label_exit;
+	}
+	for (int i = 3; i < argc; i++) {
+		if (!strcmp(argv[i], "-x") && i + 1 < argc)
+			gateX = atof(argv[++i]);
+		else if (!strcmp(argv[i], "-o") && i + 1 < argc)
+			offset = atoi(argv[++i]);
+		else if (argv[i][0] != '-' && !benchmarkFile)
+			benchmarkFile = argv[i];
+		else {
+			fprintf(stderr, "Unknown option %s\n", argv[i]);
+			goto label_exit;
+		}
+	}
+
+	unsigned int vehicleCnt, trackCnt;
+	vehicles = readRecords(argv[1], sizeof(struct vehicle), &vehicleCnt, parseVehicle);
+	tracks = readRecords(argv[2], sizeof(struct track), &trackCnt, parseTrack);
+	if (!vehicles || !tracks) {
+		fprintf(stderr, "Cannot read truth or output file (errno = %d)\n", errno);
+		goto label_exit;
+	}
+
+	/* Match: repeatedly take the track-vehicle pair with most overlapping frames, so a vehicle gets its longest track */
+	while (1) {
+		int bestOverlap = 0, bestTrack = -1, bestVehicle = -1;
+		for (unsigned int t = 0; t < trackCnt; t++) {
+			if (tracks[t].vehicle >= 0)
+				continue;
+			for (unsigned int v = 0; v < vehicleCnt; v++) {
+				if (vehicles[v].track >= 0 || fabsf(tracks[t].laneX - vehicles[v].laneX) > gateX)
+					continue;
+				int first = vehicles[v].first + offset > tracks[t].entry ? vehicles[v].first + offset : tracks[t].entry;
+				int last = vehicles[v].last + offset < tracks[t].exit ? vehicles[v].last + offset : tracks[t].exit;
+				if (last - first + 1 > bestOverlap) {
+					bestOverlap = last - first + 1;
+					bestTrack = t;
+					bestVehicle = v;
+				}
+			}
+		}
+		if (bestTrack < 0)
+			break;
+		tracks[bestTrack].vehicle = bestVehicle;
+		vehicles[bestVehicle].track = bestTrack;
+		vehicles[bestVehicle].overlap = bestOverlap;
+	}
+
+	/* Tracks not matched: duplicate if it overlaps a detected vehicle in the same lane (a vehicle split into tracks), otherwise false */
+	unsigned int duplicate = 0, falseTrack = 0;
+	for (unsigned int t = 0; t < trackCnt; t++) {
+		if (tracks[t].vehicle >= 0)
+			continue;
+		int dup = 0;
+		for (unsigned int v = 0; v < vehicleCnt && !dup; v++)
+			dup = fabsf(tracks[t].laneX - vehicles[v].laneX) <= gateX && vehicles[v].first + offset <= tracks[t].exit && vehicles[v].last + offset >= tracks[t].entry;
+		if (dup)
+			duplicate++;
+		else
+			falseTrack++;
+	}
+
+	unsigned int full = 0, detected = 0;
+	double sumError = 0, sumAbsError = 0, sumSqError = 0, maxAbsError = 0, sumRelError = 0;
+	for (unsigned int v = 0; v < vehicleCnt; v++) {
+		if (!vehicles[v].full)
+			continue;
+		full++;
+		if (vehicles[v].track < 0)
+			continue;
+		detected++;
+		double error = tracks[vehicles[v].track].speedMedian - vehicles[v].speed;
+		sumError += error;
+		sumAbsError += fabs(error);
+		sumSqError += error * error;
+		sumRelError += fabs(error) / vehicles[v].speed;
+		if (fabs(error) > maxAbsError)
+			maxAbsError = fabs(error);
+	}
+	double bias = detected ? sumError / detected : 0, mae = detected ? sumAbsError / detected : 0, rmse = detected ? sqrt(sumSqError / detected) : 0;
+	float fps = benchmarkFile ? readThroughput(benchmarkFile) : 0;
+
+	fprintf(stdout, "Vehicles: %u (%u full), tracks: %u\n", vehicleCnt, full, trackCnt);
+	fprintf(stdout, "Detected: %u of %u full vehicles (%.1f%%), %u duplicate tracks, %u false tracks\n", detected, full, full ? 100.0 * detected / full : 0.0, duplicate, falseTrack);
+	fprintf(stdout, "Speed error (km/h): bias %+.2f, MAE %.2f (%.1f%%), RMSE %.2f, max %.2f\n", bias, mae, detected ? 100.0 * sumRelError / detected : 0.0, rmse, maxAbsError);
+	if (benchmarkFile)
+		fprintf(stdout, "Throughput: %.2f fps\n", fps);
+	fprintf(stdout, "score %u %u %u %u %.3f %.3f %.3f %.3f\n", detected, full, duplicate, falseTrack, bias, mae, rmse, fps);
+
+	statue = EXIT_SUCCESS;
+label_exit:
+	free(tracks);
+	free(vehicles);
+	return statue;
+}
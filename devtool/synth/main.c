@@ -0,0 +1,240 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <errno.h>
+
+#include "../../process/roadmap.h"
+
+/* Render synthetic traffic video with known speeds, usage: ./synth <roadmap> <frames> <fps> <truth> [-l laneOrigin laneWidth] [-s speed,speed,...] [-g minGap maxGap] [-n noise] [-r seed] > video
+ * Box-shaped vehicles (flat on the road) move along road-domain y in their lanes, at constant speed (km/h), positive toward the camera (-y), negative away.
+ * Each pixel of the focus region is painted by its road-domain location in Roadmap_Table1 (px, py), so the vehicles are projected the same way the program un-projects them.
+ * -l: Road-domain x-coord (meter) of the left side of the first lane, and lane width (default -7 3.5, same as the program)
+ * -s: Mean speed of each lane, one lane per value (default 60,80,100,-100,-80,-60); speed of a vehicle is +-10% of its lane
+ * -g: Min and max gap (meter) between two vehicles in a lane (default 15 60)
+ * -n: Sensor noise, each channel of each px of each frame is changed by up to +-noise gray levels (triangular distribution, default 0), for denoise tests
+ * -r: Random seed (default 1), same seed gives the same video
+ * Video: RGBA8 frames to stdout (color scheme 40123), e.g. pipe into the program FIFO.
+ * Truth: One line per vehicle: V id lane speed(km/h) laneX(m) firstFrame-lastFrame full, frames the vehicle is visible, full = 1 if it leaves the focus region before the video ends.
+ * The road is empty at the beginning, vehicles enter at the far end (or near end if moving away) of the focus region.
+ * Build: gcc -O3 main.c ../../process/roadmap.c -o synth
+ */
+
+#define MAX_LANE 16
+#define MAX_VEHICLE 256 //Vehicles on road at the same time
+#define VEHICLE_WIDTH 1.8 //meter
+#define VEHICLE_LENGTH_MIN 4.0 //meter, length is random in range
+#define VEHICLE_LENGTH_MAX 5.5
+#define VEHICLE_BUMPER 0.8 //meter, dark band at both ends of a vehicle, gives the program a sharp edge
+#define SPEED_VARIATION 0.1 //Speed of a vehicle is lane speed * (1 +- this)
+#define ROAD_COLOR 90 //Gray level of road, a static noise is added
+#define ROAD_NOISE 8
+#define MARK_COLOR 200 //Lane marks: dashes of MARK_DASH meter every MARK_PERIOD meter, MARK_WIDTH meter wide
+#define MARK_DASH 3.0
+#define MARK_PERIOD 12.0
+#define MARK_WIDTH 0.15
+
+struct vehicle {
+	unsigned int id, lane;
+	float speed; //km/h, positive toward the camera
+	float x, y; //Road-domain location (meter) of the near-side left corner
+	float length;
+	uint8_t color[3];
+	int firstFrame, lastFrame; //Visible, -1 if not yet
+};
+
+static uint32_t seed = 1, noiseSeed = 1; //Noise has its own sequence, so the same seed gives the same vehicles with or without noise
+static float xorshift01(uint32_t* const s) { //xorshift32, so the video is the same on every machine
+	*s ^= *s << 13;
+	*s ^= *s >> 17;
+	*s ^= *s << 5;
+	return (*s >> 8) / (float)(1 << 24);
+}
+static float random01() {
+	return xorshift01(&seed);
+}
+
+int main(int argc, char* argv[]) {
+	int statue = EXIT_FAILURE;
+	roadmap map = ROADMAP_DEFAULTSTRUCT;
+	FILE* fpTruth = NULL;
+	uint8_t* background = NULL;
+	uint8_t* frame = NULL;
+	struct vehicle* vehicles = NULL;
+
+	float laneOrigin = -7.0, laneWidth = 3.5, gapMin = 15.0, gapMax = 60.0;
+	float laneSpeed[MAX_LANE] = {60, 80, 100, -100, -80, -60};
+	unsigned int laneCnt = 6, noise = 0;
+	if (argc < 5) {
+		fprintf(stderr, "Usage: %s <roadmap> <frames> <fps> <truth> [-l laneOrigin laneWidth] [-s speed,speed,...] [-g minGap maxGap] [-n noise] [-r seed] > video\n", argv[0]);
+		goto label_exit;
+	}
+	unsigned int frameCnt = atoi(argv[2]), fps = atoi(argv[3]);
+	for (int i = 5; i < argc; i++) {
+		if (!strcmp(argv[i], "-l") && i + 2 < argc) {
+			laneOrigin = atof(argv[++i]);
+			laneWidth = atof(argv[++i]);
+		} else if (!strcmp(argv[i], "-s") && i + 1 < argc) {
+			laneCnt = 0;
+			for (char* s = strtok(argv[++i], ","); s && laneCnt < MAX_LANE; s = strtok(NULL, ","))
+				laneSpeed[laneCnt++] = atof(s);
+		} else if (!strcmp(argv[i], "-g") && i + 2 < argc) {
+			gapMin = atof(argv[++i]);
+			gapMax = atof(argv[++i]);
+		} else if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+			noise = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "-r") && i + 1 < argc) {
+			seed = noiseSeed = atoi(argv[++i]);
+		} else {
+			fprintf(stderr, "Unknown option %s\n", argv[i]);
+			goto label_exit;
+		}
+	}
+	if (!frameCnt || !fps || !laneCnt || laneWidth <= VEHICLE_WIDTH || gapMin <= 0 || gapMax < gapMin || !seed) {
+		fprintf(stderr, "Bad frames, fps, lane, gap or seed\n");
+		goto label_exit;
+	}
+
+	char* err;
+	map = roadmap_init(argv[1], &err);
+	if (err) {
+		fprintf(stderr, "Cannot load roadmap: %s\n", err);
+		goto label_exit;
+	}
+	unsigned int width = map.header.width, height = map.header.height;
+
+	/* Focus region rows, and road-domain y-range of the road in it; outside the focus region, Table1 is not meaningful (e.g. above horizon) */
+	float sTop = 1.0, sBottom = 0.0;
+	for (struct RoadPoint* p = map.roadPoints; p < map.roadPoints + map.header.pCnt - 4; p++) { //Last 4 are orthographic view
+		if (p->sy < sTop) sTop = p->sy;
+		if (p->sy > sBottom) sBottom = p->sy;
+	}
+	unsigned int rowTop = sTop * height, rowBottom = sBottom * height;
+	if (rowBottom >= height)
+		rowBottom = height - 1;
+	if (rowTop >= rowBottom) {
+		fprintf(stderr, "Bad focus region in roadmap\n");
+		goto label_exit;
+	}
+	float roadFar = map.t1[rowTop * width + width / 2].py, roadNear = map.t1[rowBottom * width + width / 2].py;
+	fprintf(stderr, "%u*%u, focus region rows %u-%u, road y %.1f-%.1f m, %u lanes, %u frames\n", width, height, rowTop, rowBottom, roadNear, roadFar, laneCnt, frameCnt);
+
+	fpTruth = fopen(argv[4], "w");
+	background = malloc(width * height * 4);
+	frame = malloc(width * height * 4);
+	vehicles = malloc(MAX_VEHICLE * sizeof(struct vehicle));
+	if (!fpTruth || !background || !frame || !vehicles) {
+		fprintf(stderr, "Cannot open truth file or allocate memory (errno = %d)\n", errno);
+		goto label_exit;
+	}
+
+	/* Static background: road with noise and lane marks, so the program sees texture but no change */
+	for (unsigned int y = 0; y < height; y++) {
+		for (unsigned int x = 0; x < width; x++) {
+			uint8_t* px = background + (y * width + x) * 4;
+			int gray = ROAD_COLOR + (int)(random01() * (2 * ROAD_NOISE + 1)) - ROAD_NOISE;
+			if (y >= rowTop && y <= rowBottom) {
+				const struct Roadmap_Table1* t = &map.t1[y * width + x];
+				float lane = (t->px - laneOrigin) / laneWidth;
+				float markX = (lane - (int)(lane + 0.5)) * laneWidth; //Distance to nearest lane line
+				float markY = t->py - (int)(t->py / MARK_PERIOD) * MARK_PERIOD;
+				if (lane > -0.5 && lane < laneCnt + 0.5 && markX > -MARK_WIDTH / 2 && markX < MARK_WIDTH / 2 && markY < MARK_DASH)
+					gray = MARK_COLOR;
+			}
+			px[0] = px[1] = px[2] = gray;
+			px[3] = 255;
+		}
+	}
+
+	unsigned int vehicleCnt = 0, vehicleId = 0;
+	float laneNext[MAX_LANE]; //Distance (meter) the last vehicle of a lane has to travel before the next one enters
+	float laneLast[MAX_LANE]; //Speed (km/h) of the last vehicle of a lane
+	for (unsigned int l = 0; l < laneCnt; l++) {
+		laneNext[l] = random01() * gapMax;
+		laneLast[l] = 0;
+	}
+
+	for (unsigned int f = 0; f < frameCnt; f++) {
+		/* Spawn vehicles at the entry of each lane, a vehicle is not faster than the one before it in the lane, so they never overlap */
+		for (unsigned int l = 0; l < laneCnt; l++) {
+			float last = laneLast[l] ? laneLast[l] : laneSpeed[l];
+			laneNext[l] -= (last < 0 ? -last : last) / 3.6 / fps;
+			if (laneNext[l] > 0 || vehicleCnt == MAX_VEHICLE)
+				continue;
+			float speed = laneSpeed[l] * (1.0 - SPEED_VARIATION + 2.0 * SPEED_VARIATION * random01());
+			if (laneLast[l] && (speed < 0 ? -speed > -laneLast[l] : speed > laneLast[l]))
+				speed = laneLast[l];
+			float length = VEHICLE_LENGTH_MIN + (VEHICLE_LENGTH_MAX - VEHICLE_LENGTH_MIN) * random01();
+			vehicles[vehicleCnt++] = (struct vehicle){
+				.id = vehicleId++, .lane = l, .speed = speed,
+				.x = laneOrigin + (l + 0.5) * laneWidth - VEHICLE_WIDTH / 2,
+				.y = speed > 0 ? roadFar : roadNear - length,
+				.length = length,
+				.color = {60 + random01() * 190, 60 + random01() * 190, 60 + random01() * 190},
+				.firstFrame = -1, .lastFrame = -1
+			};
+			laneLast[l] = speed;
+			laneNext[l] = length + gapMin + (gapMax - gapMin) * random01();
+		}
+
+		/* Paint: look up road-domain location of each pixel in focus region */
+		memcpy(frame, background, width * height * 4);
+		for (unsigned int y = rowTop; y <= rowBottom; y++) {
+			for (unsigned int x = 0; x < width; x++) {
+				const struct Roadmap_Table1* t = &map.t1[y * width + x];
+				for (struct vehicle* v = vehicles; v < vehicles + vehicleCnt; v++) {
+					if (t->px < v->x || t->px > v->x + VEHICLE_WIDTH || t->py < v->y || t->py > v->y + v->length)
+						continue;
+					uint8_t* px = frame + (y * width + x) * 4;
+					int bumper = t->py < v->y + VEHICLE_BUMPER || t->py > v->y + v->length - VEHICLE_BUMPER;
+					px[0] = bumper ? 20 : v->color[0];
+					px[1] = bumper ? 20 : v->color[1];
+					px[2] = bumper ? 20 : v->color[2];
+					if (v->firstFrame < 0)
+						v->firstFrame = f;
+					v->lastFrame = f;
+					break;
+				}
+			}
+		}
+		if (noise) { //Sum of 2 uniform, so small changes are more common than large
+			for (unsigned int i = 0; i < width * height * 4; i++) {
+				if ((i & 3) == 3) //Alpha
+					continue;
+				int v = frame[i] + (int)((xorshift01(&noiseSeed) + xorshift01(&noiseSeed) - 1.0) * (noise + 0.5));
+				frame[i] = v < 0 ? 0 : v > 255 ? 255 : v;
+			}
+		}
+		if (!fwrite(frame, width * height * 4, 1, stdout)) {
+			fprintf(stderr, "Cannot write video (errno = %d)\n", errno);
+			goto label_exit;
+		}
+
+		/* Move, and retire vehicles left the road */
+		for (unsigned int i = 0; i < vehicleCnt; ) {
+			struct vehicle* v = &vehicles[i];
+			v->y -= v->speed / 3.6 / fps;
+			if (v->y + v->length < roadNear || v->y > roadFar) {
+				if (v->firstFrame >= 0)
+					fprintf(fpTruth, "V %u %u %.2f %.2f %d-%d %d\n", v->id, v->lane, v->speed < 0 ? -v->speed : v->speed, v->x + VEHICLE_WIDTH / 2, v->firstFrame, v->lastFrame, 1);
+				*v = vehicles[--vehicleCnt];
+				continue;
+			}
+			i++;
+		}
+	}
+	for (struct vehicle* v = vehicles; v < vehicles + vehicleCnt; v++) { //Still on road at the end of video
+		if (v->firstFrame >= 0)
+			fprintf(fpTruth, "V %u %u %.2f %.2f %d-%d %d\n", v->id, v->lane, v->speed < 0 ? -v->speed : v->speed, v->x + VEHICLE_WIDTH / 2, v->firstFrame, v->lastFrame, 0);
+	}
+
+	statue = EXIT_SUCCESS;
+label_exit:
+	free(vehicles);
+	free(frame);
+	free(background);
+	if (fpTruth)
+		fclose(fpTruth);
+	roadmap_destroy(&map);
+	return statue;
+}
@@ -0,0 +1,128 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+#include <math.h>
+
+#include "archive.h"
+
+#define ARCHIVE_BLOCKSIZE 4096 //Max number of samples in one block
+
+struct Archive_ClassDataStructure {
+	FILE* fpData;
+	FILE* fpIndex;
+	int64_t runStart;
+	float fps;
+	archive_block block; //Header of current block
+	//Columns of current block
+	int32_t frame[ARCHIVE_BLOCKSIZE];
+	int16_t speed[ARCHIVE_BLOCKSIZE];
+	float rx[ARCHIVE_BLOCKSIZE], ry[ARCHIVE_BLOCKSIZE];
+	uint16_t sx[ARCHIVE_BLOCKSIZE], sy[ARCHIVE_BLOCKSIZE];
+	int16_t osy[ARCHIVE_BLOCKSIZE];
+};
+
+static void archive_write(const Archive this) {
+	archive_block* b = &this->block;
+	unsigned int n = b->count;
+	if (!n)
+		return;
+
+	b->magic = ARCHIVE_MAGIC;
+	b->runStart = this->runStart;
+	b->fps = this->fps;
+	b->timeMin = this->runStart + (int64_t)(b->frameMin * 1000.0 / this->fps);
+	b->timeMax = this->runStart + (int64_t)(b->frameMax * 1000.0 / this->fps);
+	b->offset = ftello(this->fpData) + sizeof(archive_block);
+
+	fwrite(b, sizeof(archive_block), 1, this->fpData);
+	fwrite(this->frame, sizeof(this->frame[0]), n, this->fpData);
+	fwrite(this->speed, sizeof(this->speed[0]), n, this->fpData);
+	fwrite(this->rx, sizeof(this->rx[0]), n, this->fpData);
+	fwrite(this->ry, sizeof(this->ry[0]), n, this->fpData);
+	fwrite(this->sx, sizeof(this->sx[0]), n, this->fpData);
+	fwrite(this->sy, sizeof(this->sy[0]), n, this->fpData);
+	fwrite(this->osy, sizeof(this->osy[0]), n, this->fpData);
+	fflush(this->fpData); //Block must be in data file before it is indexed
+	fwrite(b, sizeof(archive_block), 1, this->fpIndex);
+	fflush(this->fpIndex);
+
+	b->count = 0;
+}
+
+Archive archive_init(const char* const prefix, const float fps, char** const statue) {
+	Archive this = malloc(sizeof(struct Archive_ClassDataStructure));
+	if (!this) {
+		if (statue)
+			*statue = "Fail to create archive class object data structure";
+		return NULL;
+	}
+	this->fpData = NULL;
+	this->fpIndex = NULL;
+	this->fps = fps;
+	this->block = (archive_block){.count = 0};
+
+	struct timespec now;
+	clock_gettime(CLOCK_REALTIME, &now);
+	this->runStart = (int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+
+	char path[strlen(prefix) + 5];
+	sprintf(path, "%s.col", prefix);
+	this->fpData = fopen(path, "ab");
+	sprintf(path, "%s.idx", prefix);
+	this->fpIndex = fopen(path, "ab");
+	if (!this->fpData || !this->fpIndex) {
+		if (statue)
+			*statue = "Fail to open archive data or index file";
+		archive_destroy(this);
+		return NULL;
+	}
+
+	return this;
+}
+
+void archive_append(const Archive this, const int frame, const unsigned int count, const output_data* const data) {
+	archive_block* b = &this->block;
+	for (const output_data* s = data; s < data + count; s++) {
+		unsigned int i = b->count;
+		if (!i) {
+			b->frameMin = b->frameMax = frame;
+			b->speedMin = b->speedMax = s->speed;
+			b->rxMin = b->rxMax = s->rx;
+			b->ryMin = b->ryMax = s->ry;
+		} else {
+			b->frameMax = frame; //Frames come in ascending order
+			b->speedMin = s->speed < b->speedMin ? s->speed : b->speedMin;
+			b->speedMax = s->speed > b->speedMax ? s->speed : b->speedMax;
+			b->rxMin = fminf(s->rx, b->rxMin);
+			b->rxMax = fmaxf(s->rx, b->rxMax);
+			b->ryMin = fminf(s->ry, b->ryMin);
+			b->ryMax = fmaxf(s->ry, b->ryMax);
+		}
+
+		this->frame[i] = frame;
+		this->speed[i] = s->speed;
+		this->rx[i] = s->rx;
+		this->ry[i] = s->ry;
+		this->sx[i] = s->sx;
+		this->sy[i] = s->sy;
+		this->osy[i] = s->osy;
+
+		if (++b->count == ARCHIVE_BLOCKSIZE)
+			archive_write(this);
+	}
+}
+
+void archive_destroy(const Archive this) {
+	if (!this)
+		return;
+
+	if (this->fpData && this->fpIndex)
+		archive_write(this);
+	if (this->fpIndex)
+		fclose(this->fpIndex);
+	if (this->fpData)
+		fclose(this->fpData);
+	free(this);
+}
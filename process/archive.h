@@ -0,0 +1,61 @@
+/** Class - Archive.class.
+ * Append-only columnar archive of raw samples (output_data).
+ * Samples are buffered into blocks. Each block is written column by column (frame, speed, rx, ry, sx, sy, osy), so a reader
+ * only reads the columns it needs. Each block begins with a block header that contains the frame range, time range and
+ * min/max of speed and road-domain location of samples in the block. A copy of all block headers is kept in a separate
+ * index file, so a reader can find blocks of interest by reading the small index file only, without touching unrelated blocks.
+ *
+ * Files: <prefix>.col - Data file: (archive_block header, int32 frame[count], int16 speed[count], float rx[count], float ry[count], uint16 sx[count], uint16 sy[count], int16 osy[count]) ...
+ *        <prefix>.idx - Index file: archive_block header ...
+ * Both files are opened in append mode, so multiple runs can write into the same archive.
+ */
+
+#ifndef INCLUDE_ARCHIVE_H
+#define INCLUDE_ARCHIVE_H
+
+#include <inttypes.h>
+
+#include "th_output.h"
+
+#define ARCHIVE_MAGIC 0x41524353 //"SCRA"
+
+/** Block header, in both data file and index file
+ */
+typedef struct Archive_Block {
+	uint32_t magic; //ARCHIVE_MAGIC
+	uint32_t count; //Number of samples in this block
+	uint64_t offset; //Offset of the first column in data file
+	int64_t runStart; //Unix time (ms) of the run, time of sample = runStart + frame * 1000 / fps
+	float fps;
+	int32_t frameMin, frameMax;
+	int64_t timeMin, timeMax; //Unix time (ms)
+	int16_t speedMin, speedMax;
+	float rxMin, rxMax, ryMin, ryMax;
+} archive_block;
+
+/** Archive class object data structure
+ */
+typedef struct Archive_ClassDataStructure* Archive;
+
+/** Init an archive object, open (append) the data and index files.
+ * @param prefix Path of the archive, ".col" and ".idx" are appended to get the data file and index file
+ * @param fps Frame per second, to convert frame number into time
+ * @param statue If not NULL, return error message in case this function fail
+ * @return $this(Opaque) archive class object upon success. If fail, free all resource and return NULL
+ */
+Archive archive_init(const char* const prefix, const float fps, char** const statue);
+
+/** Add samples of a frame. Samples are written when a block is full.
+ * @param this This archive class object
+ * @param frame Frame number
+ * @param count Number of samples
+ * @param data An array of @param count samples
+ */
+void archive_append(const Archive this, const int frame, const unsigned int count, const output_data* const data);
+
+/** Write all buffered samples, destroy this archive class object, frees resources.
+ * @param this This archive class object
+ */
+void archive_destroy(const Archive this);
+
+#endif /* #ifndef INCLUDE_ARCHIVE_H */
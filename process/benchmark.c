@@ -0,0 +1,203 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+
+#include "benchmark.h"
+
+#define BENCHMARK_NONE UINT64_MAX //Time not recorded
+
+/** Distribution of a stage over the frames after warm-up, in ns */
+typedef struct Benchmark_Stat {
+	unsigned int count;
+	uint64_t p50, p95, p99, max;
+} benchmark_stat;
+
+struct Benchmark_ClassDataStructure {
+	unsigned int stageCnt;
+	const char* const* stageName;
+	unsigned int warmup;
+	unsigned int frameCnt, frameCap; //Number of frames recorded (last frame number + 1), size of buffer in frames
+	uint64_t* time; //Per frame: start, end, then each stage; BENCHMARK_NONE if not recorded
+};
+
+/** Get the time of a frame in buffer, grow the buffer if needed */
+static uint64_t* benchmark_row(const Benchmark this, const unsigned int frame) {
+	if (frame >= this->frameCap) {
+		unsigned int cap = this->frameCap;
+		while (frame >= cap)
+			cap *= 2;
+		uint64_t* new = realloc(this->time, cap * (this->stageCnt + 2) * sizeof(uint64_t));
+		if (!new)
+			return NULL;
+		for (uint64_t* x = new + this->frameCap * (this->stageCnt + 2); x < new + cap * (this->stageCnt + 2); x++)
+			*x = BENCHMARK_NONE;
+		this->time = new;
+		this->frameCap = cap;
+	}
+	if (frame >= this->frameCnt)
+		this->frameCnt = frame + 1;
+	return this->time + frame * (this->stageCnt + 2);
+}
+
+static int benchmark_compare(const void* a, const void* b) {
+	uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+	return (x > y) - (x < y);
+}
+
+/** Get the distribution of a column (0 for frame time, 2+ for stages), nearest-rank percentile */
+static benchmark_stat benchmark_stat_get(const Benchmark this, const unsigned int column, uint64_t* const buffer) {
+	benchmark_stat stat = {0};
+	for (unsigned int i = this->warmup; i < this->frameCnt; i++) {
+		const uint64_t* row = this->time + i * (this->stageCnt + 2);
+		if (column == 0) {
+			if (row[0] != BENCHMARK_NONE && row[1] != BENCHMARK_NONE)
+				buffer[stat.count++] = row[1] - row[0];
+		} else if (row[column] != BENCHMARK_NONE) {
+			buffer[stat.count++] = row[column];
+		}
+	}
+	if (!stat.count)
+		return stat;
+
+	qsort(buffer, stat.count, sizeof(uint64_t), benchmark_compare);
+	stat.p50 = buffer[(stat.count * 50 + 99) / 100 - 1];
+	stat.p95 = buffer[(stat.count * 95 + 99) / 100 - 1];
+	stat.p99 = buffer[(stat.count * 99 + 99) / 100 - 1];
+	stat.max = buffer[stat.count - 1];
+	return stat;
+}
+
+/** Get the frame rate over the frames after warm-up: frames / (end of last frame - start of first frame) */
+static double benchmark_fps(const Benchmark this, unsigned int* const count) {
+	uint64_t start = BENCHMARK_NONE, end = 0;
+	*count = 0;
+	for (unsigned int i = this->warmup; i < this->frameCnt; i++) {
+		const uint64_t* row = this->time + i * (this->stageCnt + 2);
+		if (row[0] == BENCHMARK_NONE || row[1] == BENCHMARK_NONE)
+			continue;
+		if (row[0] < start)
+			start = row[0];
+		if (row[1] > end)
+			end = row[1];
+		(*count)++;
+	}
+	return *count ? *count * 1e9 / (end - start) : 0.0;
+}
+
+Benchmark benchmark_init(const unsigned int stageCnt, const char* const* const stageName, const unsigned int warmup, const unsigned int frameCnt, char** const statue) {
+	Benchmark this = malloc(sizeof(struct Benchmark_ClassDataStructure));
+	if (!this) {
+		if (statue)
+			*statue = "Fail to create benchmark class object data structure";
+		return NULL;
+	}
+	*this = (struct Benchmark_ClassDataStructure){ .stageCnt = stageCnt, .stageName = stageName, .warmup = warmup, .frameCap = frameCnt ? frameCnt : 1024 };
+
+	this->time = malloc(this->frameCap * (stageCnt + 2) * sizeof(uint64_t));
+	if (!this->time) {
+		if (statue)
+			*statue = "Fail to allocate memory for benchmark record";
+		benchmark_destroy(this);
+		return NULL;
+	}
+	for (uint64_t* x = this->time; x < this->time + this->frameCap * (stageCnt + 2); x++)
+		*x = BENCHMARK_NONE;
+
+	return this;
+}
+
+void benchmark_frame(const Benchmark this, const unsigned int frame, const uint64_t start, const uint64_t end) {
+	uint64_t* row = benchmark_row(this, frame);
+	if (!row)
+		return;
+	row[0] = start;
+	row[1] = end;
+}
+
+void benchmark_stage(const Benchmark this, const unsigned int frame, const unsigned int stage, const uint64_t time) {
+	uint64_t* row = benchmark_row(this, frame);
+	if (!row)
+		return;
+	row[2 + stage] = time;
+}
+
+void benchmark_report(const Benchmark this, FILE* const fp) {
+	uint64_t* buffer = malloc((this->frameCnt + 1) * sizeof(uint64_t)); //+1: not 0 if no frame
+	if (!buffer)
+		return;
+
+	unsigned int count;
+	double fps = benchmark_fps(this, &count);
+	fprintf(fp, "Benchmark: %u frames (%u warm-up excluded), %.2f fps\n", count, this->warmup, fps);
+	fprintf(fp, "\t%-24s %8s %8s %8s %8s %8s\n", "Stage (ms)", "count", "p50", "p95", "p99", "max");
+	for (unsigned int i = 0; i < this->stageCnt + 1; i++) {
+		benchmark_stat stat = benchmark_stat_get(this, i ? i + 1 : 0, buffer);
+		if (!stat.count)
+			continue;
+		fprintf(fp, "\t%-24s %8u %8.3f %8.3f %8.3f %8.3f\n", i ? this->stageName[i-1] : "frame", stat.count, stat.p50 / 1e6, stat.p95 / 1e6, stat.p99 / 1e6, stat.max / 1e6);
+	}
+
+	free(buffer);
+}
+
+int benchmark_writeJson(const Benchmark this, const char* const file) {
+	uint64_t* buffer = malloc((this->frameCnt + 1) * sizeof(uint64_t)); //+1: not 0 if no frame
+	if (!buffer)
+		return 0;
+	FILE* fp = fopen(file, "w");
+	if (!fp) {
+		free(buffer);
+		return 0;
+	}
+
+	unsigned int count;
+	double fps = benchmark_fps(this, &count);
+	fprintf(fp, "{\n\t\"frames\": %u,\n\t\"warmup\": %u,\n\t\"fps\": %.3f,\n\t\"stages\": {", count, this->warmup, fps);
+	const char* sep = "\n";
+	for (unsigned int i = 0; i < this->stageCnt + 1; i++) {
+		benchmark_stat stat = benchmark_stat_get(this, i ? i + 1 : 0, buffer);
+		if (!stat.count)
+			continue;
+		fprintf(fp, "%s\t\t\"%s\": {\"count\": %u, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f}", sep, i ? this->stageName[i-1] : "frame", stat.count, stat.p50 / 1e6, stat.p95 / 1e6, stat.p99 / 1e6, stat.max / 1e6);
+		sep = ",\n";
+	}
+	fprintf(fp, "\n\t}\n}\n");
+
+	free(buffer);
+	return !fclose(fp);
+}
+
+int benchmark_writeCsv(const Benchmark this, const char* const file) {
+	FILE* fp = fopen(file, "w");
+	if (!fp)
+		return 0;
+
+	fprintf(fp, "frame,frame_time");
+	for (unsigned int i = 0; i < this->stageCnt; i++)
+		fprintf(fp, ",%s", this->stageName[i]);
+	fprintf(fp, "\n");
+
+	for (unsigned int i = 0; i < this->frameCnt; i++) {
+		const uint64_t* row = this->time + i * (this->stageCnt + 2);
+		fprintf(fp, "%u,", i);
+		if (row[0] != BENCHMARK_NONE && row[1] != BENCHMARK_NONE)
+			fprintf(fp, "%.4f", (row[1] - row[0]) / 1e6);
+		for (unsigned int j = 0; j < this->stageCnt; j++) {
+			if (row[2 + j] != BENCHMARK_NONE)
+				fprintf(fp, ",%.4f", row[2 + j] / 1e6);
+			else
+				fprintf(fp, ",");
+		}
+		fprintf(fp, "\n");
+	}
+
+	return !fclose(fp);
+}
+
+void benchmark_destroy(const Benchmark this) {
+	if (!this)
+		return;
+
+	free(this->time);
+	free(this);
+}
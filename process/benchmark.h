@@ -0,0 +1,68 @@
+/** Class - Benchmark.class.
+ * Record the time of each stage of each frame, and report the distribution (p50, p95, p99, max) of each stage and the frame rate.
+ * Frames before warm-up are recorded (CSV) but excluded from the report.
+ * A time can be recorded any time later (e.g. GPU time read a few frames later), a time not recorded is excluded from the report of its stage.
+ */
+
+#ifndef INCLUDE_BENCHMARK_H
+#define INCLUDE_BENCHMARK_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+/** Benchmark class object data structure
+ */
+typedef struct Benchmark_ClassDataStructure* Benchmark;
+
+/** Init a benchmark object.
+ * @param stageCnt Number of stages
+ * @param stageName Name of each stage, must be valid until this object is destroyed
+ * @param warmup Number of frames at the beginning excluded from the report
+ * @param frameCnt Expected number of frames (include warm-up), the buffer grows if more frames are recorded
+ * @param statue If not NULL, return error message in case this function fail
+ * @return $this(Opaque) benchmark class object upon success. If fail, free all resource and return NULL
+ */
+Benchmark benchmark_init(const unsigned int stageCnt, const char* const* const stageName, const unsigned int warmup, const unsigned int frameCnt, char** const statue);
+
+/** Record the start and end time of a frame, for frame time and frame rate.
+ * @param this This benchmark class object
+ * @param frame Frame number, start from 0
+ * @param start Time the frame starts in ns
+ * @param end Time the frame ends in ns
+ */
+void benchmark_frame(const Benchmark this, const unsigned int frame, const uint64_t start, const uint64_t end);
+
+/** Record the time of a stage of a frame.
+ * @param this This benchmark class object
+ * @param frame Frame number, start from 0
+ * @param stage Index of the stage in stageName
+ * @param time Time of the stage in ns
+ */
+void benchmark_stage(const Benchmark this, const unsigned int frame, const unsigned int stage, const uint64_t time);
+
+/** Write the report: number of frames, frame rate, p50/p95/p99/max of frame time and each stage in ms.
+ * @param this This benchmark class object
+ * @param fp Write to this file (e.g. stderr)
+ */
+void benchmark_report(const Benchmark this, FILE* const fp);
+
+/** Write the report as JSON: {"frames", "warmup", "fps", "stages": {"<name>": {"count", "p50", "p95", "p99", "max"}}}, time in ms; frame time is the stage "frame".
+ * @param this This benchmark class object
+ * @param file Directory to the JSON file
+ * @return 1 if success, 0 if fail to write the file
+ */
+int benchmark_writeJson(const Benchmark this, const char* const file);
+
+/** Write the time of every recorded frame (include warm-up) as CSV: a header row, then one row per frame, time in ms, empty if not recorded.
+ * @param this This benchmark class object
+ * @param file Directory to the CSV file
+ * @return 1 if success, 0 if fail to write the file
+ */
+int benchmark_writeCsv(const Benchmark this, const char* const file);
+
+/** Destroy this benchmark class object, frees resources.
+ * @param this This benchmark class object, NULL is OK
+ */
+void benchmark_destroy(const Benchmark this);
+
+#endif /* #ifndef INCLUDE_BENCHMARK_H */
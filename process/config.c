@@ -0,0 +1,222 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "config.h"
+
+#define CONFIG_LINE_SIZE 256
+#define CONFIG_STATUE_SIZE 320
+
+/** A "name = value" line in the config file */
+typedef struct Config_Entry {
+	char* name;
+	char* value;
+	int used; //Read by the program
+	int bad; //Value cannot be parsed
+} config_entry;
+
+struct Config_ClassDataStructure {
+	config_entry* entry;
+	unsigned int entryCnt, entryCap;
+	char* header; //Shader header of last config_shaderHeader() call
+};
+
+static char config_statue[CONFIG_STATUE_SIZE]; //Error message with name or line number
+
+/** Remove leading and trailing white space in place */
+static char* config_trim(char* str) {
+	while (isspace((unsigned char)*str))
+		str++;
+	char* end = str + strlen(str);
+	while (end > str && isspace((unsigned char)end[-1]))
+		end--;
+	*end = '\0';
+	return str;
+}
+
+/** Find entry by name, NULL if not in file */
+static config_entry* config_find(const Config this, const char* const name) {
+	if (!this)
+		return NULL;
+	for (unsigned int i = 0; i < this->entryCnt; i++) {
+		if (!strcmp(this->entry[i].name, name))
+			return &this->entry[i];
+	}
+	return NULL;
+}
+
+Config config_init(const char* const file, char** const statue) {
+	Config this = malloc(sizeof(struct Config_ClassDataStructure));
+	if (!this) {
+		if (statue)
+			*statue = "Fail to create config class object data structure";
+		return NULL;
+	}
+	*this = (struct Config_ClassDataStructure){ .entry = NULL, .header = NULL };
+	if (!file)
+		return this;
+
+	FILE* fp = fopen(file, "r");
+	if (!fp) {
+		if (statue)
+			*statue = "Fail to open config file";
+		config_destroy(this);
+		return NULL;
+	}
+
+	char line[CONFIG_LINE_SIZE];
+	for (unsigned int lineNum = 1; fgets(line, sizeof(line), fp); lineNum++) {
+		char* comment = strchr(line, '#');
+		if (comment)
+			*comment = '\0';
+		char* sep = strchr(line, '=');
+		if (!sep) {
+			if (*config_trim(line) == '\0') //Empty or comment only
+				continue;
+			if (statue) {
+				snprintf(config_statue, sizeof(config_statue), "Error in config file line %u: Expect \"name = value\"", lineNum);
+				*statue = config_statue;
+			}
+			fclose(fp);
+			config_destroy(this);
+			return NULL;
+		}
+		*sep = '\0';
+		char* name = config_trim(line);
+		char* value = config_trim(sep + 1);
+		if (*name == '\0' || *value == '\0') {
+			if (statue) {
+				snprintf(config_statue, sizeof(config_statue), "Error in config file line %u: Empty name or value", lineNum);
+				*statue = config_statue;
+			}
+			fclose(fp);
+			config_destroy(this);
+			return NULL;
+		}
+
+		config_entry* entry = config_find(this, name);
+		if (entry) { //Same name again, later one wins
+			char* new = strdup(value);
+			if (!new)
+				goto label_outOfMemory;
+			free(entry->value);
+			entry->value = new;
+			continue;
+		}
+		if (this->entryCnt == this->entryCap) {
+			unsigned int cap = this->entryCap ? this->entryCap * 2 : 16;
+			config_entry* new = realloc(this->entry, cap * sizeof(config_entry));
+			if (!new)
+				goto label_outOfMemory;
+			this->entry = new;
+			this->entryCap = cap;
+		}
+		entry = &this->entry[this->entryCnt];
+		*entry = (config_entry){ .name = strdup(name), .value = strdup(value) };
+		this->entryCnt++;
+		if (!entry->name || !entry->value)
+			goto label_outOfMemory;
+	}
+
+	fclose(fp);
+	return this;
+
+label_outOfMemory:
+	if (statue)
+		*statue = "Fail to allocate memory for config entry";
+	fclose(fp);
+	config_destroy(this);
+	return NULL;
+}
+
+unsigned int config_getUint(const Config this, const char* const name, const unsigned int value) {
+	config_entry* entry = config_find(this, name);
+	if (!entry)
+		return value;
+	entry->used = 1;
+
+	char* end;
+	unsigned long int x = strtoul(entry->value, &end, 0);
+	if (*end != '\0' || entry->value[0] == '-') {
+		entry->bad = 1;
+		return value;
+	}
+	return x;
+}
+
+float config_getFloat(const Config this, const char* const name, const float value) {
+	config_entry* entry = config_find(this, name);
+	if (!entry)
+		return value;
+	entry->used = 1;
+
+	char* end;
+	float x = strtof(entry->value, &end);
+	if (*end != '\0') {
+		entry->bad = 1;
+		return value;
+	}
+	return x;
+}
+
+const char* config_getString(const Config this, const char* const name, const char* const value) {
+	config_entry* entry = config_find(this, name);
+	if (!entry)
+		return value;
+	entry->used = 1;
+	return entry->value;
+}
+
+const char* config_shaderHeader(const Config this, const char* const program, const char* const version) {
+	size_t programLength = strlen(program);
+	size_t size = strlen(version) + 1;
+	for (unsigned int i = 0; i < this->entryCnt; i++) {
+		const config_entry* entry = &this->entry[i];
+		if (!strncmp(entry->name, program, programLength) && entry->name[programLength] == '.')
+			size += sizeof("#define  \n") + strlen(entry->name) + strlen(entry->value);
+	}
+
+	free(this->header);
+	this->header = malloc(size);
+	if (!this->header)
+		return NULL;
+
+	char* ptr = this->header;
+	ptr += sprintf(ptr, "%s", version);
+	for (unsigned int i = 0; i < this->entryCnt; i++) {
+		config_entry* entry = &this->entry[i];
+		if (!strncmp(entry->name, program, programLength) && entry->name[programLength] == '.') {
+			ptr += sprintf(ptr, "#define %s %s\n", entry->name + programLength + 1, entry->value);
+			entry->used = 1;
+		}
+	}
+	return this->header;
+}
+
+int config_check(const Config this, char** const statue) {
+	for (unsigned int i = 0; i < this->entryCnt; i++) {
+		const config_entry* entry = &this->entry[i];
+		if (!entry->used || entry->bad) {
+			if (statue) {
+				snprintf(config_statue, sizeof(config_statue), "Error in config file: %s \"%s\"", entry->bad ? "Bad value for" : "Unknown name", entry->name);
+				*statue = config_statue;
+			}
+			return 0;
+		}
+	}
+	return 1;
+}
+
+void config_destroy(const Config this) {
+	if (!this)
+		return;
+
+	for (unsigned int i = 0; i < this->entryCnt; i++) {
+		free(this->entry[i].name);
+		free(this->entry[i].value);
+	}
+	free(this->entry);
+	free(this->header);
+	free(this);
+}
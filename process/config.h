@@ -0,0 +1,68 @@
+/** Class - Config.class.
+ * Runtime config loaded from a text file at start, so a site can be tuned without rebuilding the program.
+ * Each line of the file is "name = value", anything after '#' is comment, empty lines are ignored.
+ * A name with a dot, "program.MACRO = value", is a shader macro: it is added as "#define MACRO value" to the common header of that shader program.
+ * The program asks for each value with a default (the compile-time config), so the file only needs the values to be changed.
+ */
+
+#ifndef INCLUDE_CONFIG_H
+#define INCLUDE_CONFIG_H
+
+/** Config class object data structure
+ */
+typedef struct Config_ClassDataStructure* Config;
+
+/** Init a config object, read and parse the config file.
+ * @param file Directory to the config file, NULL for an empty config (all values are default)
+ * @param statue If not NULL, return error message in case this function fail
+ * @return $this(Opaque) config class object upon success. If fail, free all resource and return NULL
+ */
+Config config_init(const char* const file, char** const statue);
+
+/** Get an unsigned integer value.
+ * @param this This config class object
+ * @param name Name of the value
+ * @param value Default value, returned if the file does not have this name
+ * @return Value in file, or default value
+ */
+unsigned int config_getUint(const Config this, const char* const name, const unsigned int value);
+
+/** Get a floating point value.
+ * @param this This config class object
+ * @param name Name of the value
+ * @param value Default value, returned if the file does not have this name
+ * @return Value in file, or default value
+ */
+float config_getFloat(const Config this, const char* const name, const float value);
+
+/** Get a string value, e.g. a file path.
+ * @param this This config class object
+ * @param name Name of the value
+ * @param value Default value, returned if the file does not have this name
+ * @return Value in file (kept in this object until it is destroyed), or default value
+ */
+const char* config_getString(const Config this, const char* const name, const char* const value);
+
+/** Get the common header of a shader program: the version line, followed by a "#define" line for each macro of this program in the file.
+ * The header is kept in this object until next call or the object is destroyed, which is good for gl_program_setCommonHeader() right before loading the program.
+ * @param this This config class object
+ * @param program Name of the shader program
+ * @param version Version line, e.g. "#version 310 es\n"
+ * @return The header, or NULL if out of memory
+ */
+const char* config_shaderHeader(const Config this, const char* const program, const char* const version);
+
+/** Check all values in the file are used and valid.
+ * Call this after all values are read, to catch typo in the file.
+ * @param this This config class object
+ * @param statue If not NULL, return error message in case of bad value
+ * @return 1 if all good, 0 if any value is unused or cannot be parsed
+ */
+int config_check(const Config this, char** const statue);
+
+/** Destroy this config class object, frees resources.
+ * @param this This config class object, NULL is OK
+ */
+void config_destroy(const Config this);
+
+#endif /* #ifndef INCLUDE_CONFIG_H */
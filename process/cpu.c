@@ -0,0 +1,717 @@
+#pragma GCC optimize ("fp-contract=off", "no-trapping-math", "tree-vectorize") //Float ops must be rounded one by one as the shaders say, no fused multiply-add; float exceptions are not used, so selects and the per-pixel passes vectorize
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "common.h"
+#include "cpu.h"
+
+#define CPU_BAND 8 //Rows are dealt to threads in bands of this number of rows, round robin, so the focus region is spread over all threads
+#define CPU_SUBPIXEL 256 //Vertex is snapped to 1/256 px before rasterization, same as Mesa
+
+/* Result of edge refine (HUMAN) */
+#define RESULT_OBJECT 0.3f
+#define RESULT_BOTTOM 0.6f
+#define RESULT_CBEDGE 1.0f
+
+/* Measure */
+#define DEST_THRESHOLD_EDGE 0.6f
+#define DEST_THRESHOLD_CENEDGE 1.0f
+
+typedef uint8_t rgba8[4];
+typedef uint8_t rg8[2];
+
+struct Cpu_Worker {
+	Cpu this;
+	unsigned int idx;
+	pthread_t tid;
+};
+
+struct Cpu_ClassDataStructure {
+	cpu_config config;
+	unsigned int threadCnt;
+	struct Cpu_Worker* worker;
+	pthread_mutex_t workerLock; //Held while creating workers, workers start after all created
+	int workerReady; //All workers created, barriers in use
+	pthread_barrier_t passStart, passEnd;
+	void (* pass)(const Cpu this, const unsigned int y); //Process a row, NULL to stop workers
+
+	float decode[256]; //UNORM8 to float, as texture fetch
+	uint8_t* maskPersp; //Focus region in perspective view (mesh_persp), 1 if covered
+	uint8_t* maskOrtho; //Focus region in orthographic view (mesh_ortho)
+	float (* t1)[4]; //Roadmap table 1 and 2 rounded to fp16, as RGBA16F texture
+	float (* t2)[4];
+
+	const rgba8* frame; //Input of current frame
+	rgba8* raw[2]; //Blurred video, current and previous
+	float (* state[2])[4]; //If temporal, temporal filter state instead of raw, fp16 as RGBA16F texture
+	rg8* stageA;
+	rg8* stageB;
+	uint8_t* object[CPU_QUEUE_MAX]; //Object of current and previous frames, measureInterlace + 1 in use
+	rg8* speed;
+	unsigned int current, previous, current_obj, hint_obj, previous_obj;
+	unsigned int direction; //Object fix: 0 for horizontal, 1 for vertical
+};
+
+/** UNORM8 to float, as texture fetch (c / 255, exact division) */
+static inline float cpu_unorm(const uint8_t c) {
+	return (float)c / 255.0f;
+}
+
+/** Float to UNORM8, as render target write: clamp, then round to nearest even with the fp32 magic number (x * 255/256 + 2^15 keeps 8 fraction bits); no branch, so loops of it vectorize */
+static inline uint8_t cpu_encode(const float x) {
+	float clamp = x > 0.0f ? x : 0.0f; //NaN is 0
+	clamp = clamp < 1.0f ? clamp : 1.0f;
+	union { float f; uint32_t i; } magic = { .f = clamp * (255.0f / 256.0f) + 32768.0f };
+	return magic.i & 0xFF;
+}
+
+/** Round to fp16 (nearest even), as storing float to RGBA16F texture or render target */
+static inline float cpu_half(const float x) {
+	return (float)(_Float16)x;
+}
+
+/** Rasterize a triangle strip (NTC vertices) to mask: a pixel is covered if its center is inside a triangle, top-left fill rule on edges */
+void cpu_rasterize(uint8_t* const mask, const unsigned int width, const unsigned int height, const struct RoadPoint* const point, const unsigned int cnt) {
+	int64_t (* vertex)[2] = malloc(cnt * sizeof(vertex[0]));
+	if (!vertex)
+		return;
+	for (unsigned int i = 0; i < cnt; i++) { //Vertex shader (NTC to NDC), viewport, then snap
+		const float ndc[2] = {point[i].sx * 2.0f - 1.0f, point[i].sy * 2.0f - 1.0f};
+		vertex[i][0] = lrintf((ndc[0] * (width / 2.0f) + width / 2.0f) * CPU_SUBPIXEL);
+		vertex[i][1] = lrintf((ndc[1] * (height / 2.0f) + height / 2.0f) * CPU_SUBPIXEL);
+	}
+
+	for (unsigned int t = 0; t + 2 < cnt; t++) {
+		const int64_t* v[3] = {vertex[t], vertex[t+1], vertex[t+2]};
+		int64_t area = (v[1][0] - v[0][0]) * (v[2][1] - v[0][1]) - (v[1][1] - v[0][1]) * (v[2][0] - v[0][0]);
+		if (!area)
+			continue;
+		if (area < 0) { //Make it counter-clockwise (y-down), so inside is positive for all edges
+			const int64_t* swap = v[1];
+			v[1] = v[2];
+			v[2] = swap;
+		}
+
+		int64_t left = v[0][0], right = v[0][0], top = v[0][1], bottom = v[0][1];
+		for (unsigned int i = 1; i < 3; i++) {
+			if (v[i][0] < left) left = v[i][0];
+			if (v[i][0] > right) right = v[i][0];
+			if (v[i][1] < top) top = v[i][1];
+			if (v[i][1] > bottom) bottom = v[i][1];
+		}
+		int x0 = left / CPU_SUBPIXEL - 1, x1 = right / CPU_SUBPIXEL + 1, y0 = top / CPU_SUBPIXEL - 1, y1 = bottom / CPU_SUBPIXEL + 1;
+		if (x0 < 0) x0 = 0;
+		if (y0 < 0) y0 = 0;
+		if (x1 >= (int)width) x1 = width - 1;
+		if (y1 >= (int)height) y1 = height - 1;
+
+		for (int y = y0; y <= y1; y++) {
+			for (int x = x0; x <= x1; x++) {
+				const int64_t p[2] = {(int64_t)x * CPU_SUBPIXEL + CPU_SUBPIXEL / 2, (int64_t)y * CPU_SUBPIXEL + CPU_SUBPIXEL / 2};
+				int inside = 1;
+				for (unsigned int e = 0; e < 3 && inside; e++) {
+					const int64_t* a = v[e];
+					const int64_t* b = v[(e + 1) % 3];
+					const int64_t dx = b[0] - a[0], dy = b[1] - a[1];
+					const int64_t edge = dx * (p[1] - a[1]) - dy * (p[0] - a[0]);
+					const int topLeft = dy < 0 || (dy == 0 && dx > 0);
+					inside = edge > 0 || (edge == 0 && topLeft);
+				}
+				if (inside)
+					mask[y * width + x] = 1;
+			}
+		}
+	}
+	free(vertex);
+}
+
+/** Run a pass on all rows, rows are dealt to threads in bands; returns when all threads finish */
+static void cpu_band(const Cpu this, const unsigned int idx) {
+	for (unsigned int band = idx * CPU_BAND; band < this->config.height; band += this->threadCnt * CPU_BAND) {
+		for (unsigned int y = band; y < band + CPU_BAND && y < this->config.height; y++)
+			this->pass(this, y);
+	}
+}
+
+static void* cpu_worker(void* arg) {
+	struct Cpu_Worker* worker = arg;
+	const Cpu this = worker->this;
+	pthread_mutex_lock(&this->workerLock);
+	pthread_mutex_unlock(&this->workerLock);
+	if (!this->workerReady)
+		return NULL;
+	while (1) {
+		pthread_barrier_wait(&this->passStart);
+		if (!this->pass)
+			break;
+		cpu_band(this, worker->idx);
+		pthread_barrier_wait(&this->passEnd);
+	}
+	return NULL;
+}
+
+static void cpu_run(const Cpu this, void (* const pass)(const Cpu this, const unsigned int y)) {
+	this->pass = pass;
+	if (this->threadCnt > 1)
+		pthread_barrier_wait(&this->passStart);
+	cpu_band(this, 0);
+	if (this->threadCnt > 1)
+		pthread_barrier_wait(&this->passEnd);
+}
+
+/* Passes, one row each call; same as the shaders at full float precision, see the shader for the algorithm
+ * A fragment is the px of its index, texture() at the center of a px reads that px; fp16 is only where the texture is RGBA16F.
+ */
+
+static void cpu_blur(const Cpu this, const unsigned int y) { //blurFilter: 3*3 weighted mean, out of frame is 0 (texelFetch) or edge px (BILINEAR)
+	const int width = this->config.width, height = this->config.height;
+	uint8_t pad[3][(width + 2) * 4]; //Rows y-1, y and y+1 with a px on both sides, so all px take the same branch-free loop
+	for (int j = 0; j < 3; j++) {
+		int ty = (int)y + j - 1;
+		if (this->config.bilinear) //Linear filter clamps to edge
+			ty = ty < 0 ? 0 : ty >= height ? height - 1 : ty;
+		if (ty < 0 || ty >= height) {
+			memset(pad[j], 0, sizeof(pad[j]));
+			continue;
+		}
+		memcpy(pad[j] + 4, this->frame + ty * width, width * sizeof(rgba8));
+		if (this->config.bilinear) {
+			memcpy(pad[j], pad[j] + 4, sizeof(rgba8));
+			memcpy(pad[j] + (width + 1) * 4, pad[j] + width * 4, sizeof(rgba8));
+		} else {
+			memset(pad[j], 0, sizeof(rgba8));
+			memset(pad[j] + (width + 1) * 4, 0, sizeof(rgba8));
+		}
+	}
+
+	const int cnt = width * 4; //Channels are independent until MONO, a row is width * 4 values
+	const uint8_t* restrict const top = pad[0] + 4;
+	const uint8_t* restrict const mid = pad[1] + 4;
+	const uint8_t* restrict const bottom = pad[2] + 4;
+	float accum[cnt];
+	if (this->config.bilinear) { //4 taps at the corners of px, a tap is the weighted sum of the 2*2 block with the weights of the linear filter (1/4 each at the corner)
+		for (int i = 0; i < cnt; i++) {
+			const float tl = cpu_unorm(top[i-4]) * 0.25f + cpu_unorm(top[i]) * 0.25f + cpu_unorm(mid[i-4]) * 0.25f + cpu_unorm(mid[i]) * 0.25f;
+			const float tr = cpu_unorm(top[i]) * 0.25f + cpu_unorm(top[i+4]) * 0.25f + cpu_unorm(mid[i]) * 0.25f + cpu_unorm(mid[i+4]) * 0.25f;
+			const float bl = cpu_unorm(mid[i-4]) * 0.25f + cpu_unorm(mid[i]) * 0.25f + cpu_unorm(bottom[i-4]) * 0.25f + cpu_unorm(bottom[i]) * 0.25f;
+			const float br = cpu_unorm(mid[i]) * 0.25f + cpu_unorm(mid[i+4]) * 0.25f + cpu_unorm(bottom[i]) * 0.25f + cpu_unorm(bottom[i+4]) * 0.25f;
+			accum[i] = tl / 4.0f + tr / 4.0f + bl / 4.0f + br / 4.0f;
+		}
+	} else { //Same order as the shader
+		for (int i = 0; i < cnt; i++) {
+			accum[i] = cpu_unorm(top[i-4]) / 16.0f + cpu_unorm(mid[i-4]) / 8.0f + cpu_unorm(bottom[i-4]) / 16.0f
+				+ cpu_unorm(top[i]) / 8.0f + cpu_unorm(mid[i]) / 4.0f + cpu_unorm(bottom[i]) / 8.0f
+				+ cpu_unorm(top[i+4]) / 16.0f + cpu_unorm(mid[i+4]) / 8.0f + cpu_unorm(bottom[i+4]) / 16.0f;
+		}
+	}
+
+	if (this->config.mono) {
+		for (int i = 0; i < cnt; i += 4) {
+			const float mono = (accum[i] * 0.299f + accum[i+1] * 0.587f + accum[i+2] * 0.114f) * accum[i+3];
+			accum[i] = accum[i+1] = accum[i+2] = mono;
+			accum[i+3] = 1.0f;
+		}
+	}
+	uint8_t* restrict const dest = this->raw[this->current][y * width];
+	for (int i = 0; i < cnt; i++)
+		dest[i] = cpu_encode(accum[i]);
+}
+
+static void cpu_temporalFilter(const Cpu this, const unsigned int y) { //temporalFilter: state = mix(state, frame, alpha), alpha grows from ALPHA to 1.0 with the luma difference
+	const unsigned int width = this->config.width;
+	const rgba8* const frame = this->frame + y * width;
+	const float (* const state)[4] = this->state[this->previous] + y * width;
+	float (* const dest)[4] = this->state[this->current] + y * width;
+	const float alpha = this->config.alpha, motion = this->config.motion;
+	for (unsigned int x = 0; x < width; x++) {
+		float f[4];
+		for (int c = 0; c < 4; c++)
+			f[c] = cpu_unorm(frame[x][c]);
+		const float diff = fabsf(f[0] - state[x][0]) * 0.299f + fabsf(f[1] - state[x][1]) * 0.587f + fabsf(f[2] - state[x][2]) * 0.114f;
+		const float ratio = fminf(diff / motion, 1.0f);
+		const float a = alpha * (1.0f - ratio) + 1.0f * ratio; //mix(ALPHA, 1.0, ratio), x * (1 - a) + y * a
+		for (int c = 0; c < 3; c++)
+			dest[x][c] = cpu_half(state[x][c] * (1.0f - a) + f[c] * a); //mix(state, frame, a), stored as fp16
+		dest[x][3] = cpu_half(f[3]);
+	}
+}
+
+static void cpu_changingSensor(const Cpu this, const unsigned int y) { //changingSensor: step(THRESHOLD, luma of |current - previous|)
+	const int width = this->config.width;
+	const float threshold = this->config.threshold;
+	float diff[width]; //Luma difference first, then the result; each loop has one data type so it vectorizes
+	if (this->config.temporal) {
+		const float* restrict const pc = this->state[this->current][y * width];
+		const float* restrict const pb = this->state[this->previous][y * width];
+		for (int x = 0; x < width; x++)
+			diff[x] = fabsf(pc[x*4] - pb[x*4]) * 0.299f + fabsf(pc[x*4+1] - pb[x*4+1]) * 0.587f + fabsf(pc[x*4+2] - pb[x*4+2]) * 0.114f;
+	} else {
+		const uint8_t* restrict const pc = this->raw[this->current][y * width];
+		const uint8_t* restrict const pb = this->raw[this->previous][y * width];
+		for (int x = 0; x < width; x++)
+			diff[x] = fabsf(cpu_unorm(pc[x*4]) - cpu_unorm(pb[x*4])) * 0.299f + fabsf(cpu_unorm(pc[x*4+1]) - cpu_unorm(pb[x*4+1])) * 0.587f + fabsf(cpu_unorm(pc[x*4+2]) - cpu_unorm(pb[x*4+2])) * 0.114f;
+	}
+	const uint8_t* restrict const mask = this->maskPersp + y * width;
+	uint8_t* restrict const dest = this->stageA[y * width];
+	for (int x = 0; x < width; x++) {
+		dest[x * 2] = (mask[x] != 0) & (diff[x] >= threshold) ? 255 : 0;
+		dest[x * 2 + 1] = 0;
+	}
+}
+
+/** Object fix: sum of a 2*2 block (textureGather, clamp to edge) around a fragment coord > 1.0 */
+static inline int cpu_objectFix_block(const Cpu this, const rg8* const src, int x, int y) { //Block at (x,y) top-left has at least 2 object px, edge px repeated (textureGather() with clamp to edge)
+	const int width = this->config.width, height = this->config.height;
+	const int x1 = x + 1 >= width ? width - 1 : x + 1 < 0 ? 0 : x + 1;
+	const int y1 = y + 1 >= height ? height - 1 : y + 1 < 0 ? 0 : y + 1;
+	x = x < 0 ? 0 : x >= width ? width - 1 : x;
+	y = y < 0 ? 0 : y >= height ? height - 1 : y;
+	return (src[y * width + x][0] != 0) + (src[y * width + x1][0] != 0) + (src[y1 * width + x][0] != 0) + (src[y1 * width + x1][0] != 0) >= 2;
+}
+
+static void cpu_objectFix(const Cpu this, const unsigned int y) { //objectFix: fill gap if a block is found on both sides within search distance, 2px a step; the coord of the search loops is at the corner of a block in exact arithmetic, same blocks as objectFixScan
+	const unsigned int width = this->config.width;
+	const float* const d = this->decode;
+	const uint8_t* const mask = this->maskPersp + y * width;
+	const rg8* const src = this->direction ? this->stageB : this->stageA;
+	rg8* const dest = (this->direction ? this->stageA : this->stageB) + y * width;
+	const int dx = this->direction ? 0 : 2, dy = this->direction ? 2 : 0;
+	const float distance = 0.5f * this->config.searchDistance;
+	const uint8_t fix = cpu_encode(0.7f);
+	for (unsigned int x = 0; x < width; x++) {
+		dest[x][0] = dest[x][1] = 0;
+		if (!mask[x])
+			continue;
+		const uint8_t ret = src[y * width + x][0];
+		if (d[ret] >= 0.5f) {
+			dest[x][0] = ret;
+			continue;
+		}
+		const int cnt = distance * this->t1[y * width + x][3];
+		int found = 0;
+		for (int i = 1; i <= cnt && !found; i++)
+			found = cpu_objectFix_block(this, src, x + i * dx, y + i * dy);
+		if (found) {
+			found = 0;
+			for (int i = 1; i <= cnt && !found; i++)
+				found = cpu_objectFix_block(this, src, x - i * dx, y - i * dy);
+		}
+		dest[x][0] = found ? fix : 0;
+	}
+}
+
+/** Texel of RG8 buffer, out of frame is 0 (texelFetch) */
+static inline const uint8_t* cpu_fetch(const Cpu this, const rg8* const src, const int x, const int y) {
+	static const rg8 zero = {0, 0};
+	if (x < 0 || x >= (int)this->config.width || y < 0 || y >= (int)this->config.height)
+		return zero;
+	return src[y * this->config.width + x];
+}
+
+/** Edge refine: length of the path of object pixels (> 0.5) from start to one side, up to goal; a step goes to the next column, same row first, then up, then down */
+static inline int cpu_edgeRefine_path(const Cpu this, const int start[2], const int dir, const int goal) {
+	const float* const d = this->decode;
+	const rg8* const src = this->stageA;
+	int x = start[0], y = start[1];
+	while (dir * (x - start[0]) < goal) {
+		if (d[cpu_fetch(this, src, x + dir, y)[0]] > 0.5f) {
+		} else if (d[cpu_fetch(this, src, x + dir, y - 1)[0]] > 0.5f) {
+			y--;
+		} else if (d[cpu_fetch(this, src, x + dir, y + 1)[0]] > 0.5f) {
+			y++;
+		} else {
+			break;
+		}
+		x += dir;
+	}
+	return dir * (x - start[0]);
+}
+
+static void cpu_edgeRefine(const Cpu this, const unsigned int y) { //edgeRefine: keep bottom edge of object, centered bottom edge is 1.0, other bottom edge is 0.6, object is 0.3 (HUMAN output)
+	const unsigned int width = this->config.width;
+	const float* const d = this->decode;
+	const uint8_t* const mask = this->maskPersp + y * width;
+	const rg8* const src = this->stageA;
+	rg8* const dest = this->stageB + y * width;
+	const rg8 result[3] = {
+		{cpu_encode(RESULT_OBJECT), cpu_encode(0.1f)},
+		{cpu_encode(RESULT_BOTTOM), cpu_encode(1.0f)},
+		{cpu_encode(RESULT_CBEDGE), cpu_encode(1.0f)}
+	};
+	for (unsigned int x = 0; x < width; x++) {
+		dest[x][0] = dest[x][1] = 0;
+		if (!mask[x])
+			continue;
+		const int idx[2] = {x, y};
+		if (d[cpu_fetch(this, src, idx[0], idx[1])[0]] < 0.1f)
+			continue;
+		dest[x][0] = result[0][0];
+		dest[x][1] = result[0][1];
+		const float pixelWidth = this->t1[y * width + x][3];
+		const int limitBottom = this->config.bottomDenoise * pixelWidth;
+		int search = 1;
+		for (int j = idx[1] + 1; j < limitBottom + idx[1] + 1 && search; j++)
+			search = !(d[cpu_fetch(this, src, idx[0], j)[0]] > 0.0f);
+		if (!search)
+			continue;
+		const int goal = this->config.sideMargin * pixelWidth;
+		const int refine = cpu_edgeRefine_path(this, idx, -1, goal) >= goal && cpu_edgeRefine_path(this, idx, +1, goal) >= goal ? 2 : 1;
+		dest[x][0] = result[refine][0];
+		dest[x][1] = result[refine][1];
+	}
+}
+
+static void cpu_project(const Cpu this, const unsigned int y) { //project mode 2: perspective to orthographic, x from P2O lookup
+	const unsigned int width = this->config.width;
+	const uint8_t* const mask = this->maskOrtho + y * width;
+	uint8_t* const dest = this->object[this->current_obj] + y * width;
+	for (unsigned int x = 0; x < width; x++) {
+		dest[x] = 0;
+		if (!mask[x])
+			continue;
+		const int projX = (float)width * this->t2[y * width + x][2];
+		dest[x] = cpu_fetch(this, this->stageB, projX, y)[0];
+	}
+}
+
+/** Measure: object texel, out of frame is 0 */
+static inline float cpu_measure_fetch(const Cpu this, const uint8_t* const src, const int x, const int y) {
+	if (x < 0 || x >= (int)this->config.width || y < 0 || y >= (int)this->config.height)
+		return 0.0f;
+	return this->decode[src[y * this->config.width + x]];
+}
+
+static void cpu_measure(const Cpu this, const unsigned int y) { //measure: road-domain displacement of centered bottom edge between current and previous object, hint is the frame between
+	const unsigned int width = this->config.width, height = this->config.height;
+	const float heightF = height;
+	const uint8_t* const mask = this->maskOrtho + y * width;
+	const uint8_t* const current = this->object[this->current_obj];
+	const uint8_t* const hint = this->object[this->hint_obj];
+	const uint8_t* const previous = this->object[this->previous_obj];
+	rg8* const dest = this->stageA + y * width;
+	const float bias = this->config.bias;
+	const int idxY = y;
+	const int gatherY1 = idxY + 1 < (int)height ? idxY + 1 : (int)height - 1; //Gather at the center of px is the 2*2 block from the px, clamp to edge
+	for (int x = 0; x < (int)width; x++) {
+		dest[x][0] = dest[x][1] = 0;
+		if (!mask[x])
+			continue;
+		const int idxX = x;
+
+		const int gatherX1 = idxX + 1 < (int)width ? idxX + 1 : (int)width - 1;
+		const float* const l0 = this->t2[idxY * width + idxX]; //Component 3 of the gather
+		const float* const l1 = this->t2[gatherY1 * width + gatherX1]; //Component 1
+		const int limit[4] = {
+			fmaxf(l0[0], l1[0]) * heightF, //Up hint
+			fminf(l0[1], l1[1]) * heightF, //Down hint
+			fminf(l0[0], l1[0]) * heightF, //Up search
+			fmaxf(l0[1], l1[1]) * heightF //Down search
+		};
+
+		float displaceRoad = 0.0f;
+		int displaceScreen = idxY;
+		if (cpu_measure_fetch(this, current, idxX, idxY) == DEST_THRESHOLD_CENEDGE) {
+			const float currentPos = this->t1[idxY * width + idxX][1]; //Road-domain y of a px sampled at its corner (vec2(idx) / videoSize) is also that px
+
+			float hintUpRoad = 0.0f, hintDownRoad = 0.0f;
+			int hintUpScreen = idxY, hintDownScreen = idxY;
+			if (cpu_measure_fetch(this, hint, idxX, idxY) < DEST_THRESHOLD_EDGE) {
+				for (int i = idxY; i > limit[0]; i--) {
+					if (cpu_measure_fetch(this, hint, idxX, i) >= DEST_THRESHOLD_EDGE) {
+						hintUpRoad = fabsf(currentPos - this->t1[i * width + idxX][1]);
+						hintUpScreen = i;
+						break;
+					}
+				}
+				for (int i = idxY; i < limit[1]; i++) {
+					if (cpu_measure_fetch(this, hint, idxX, i) >= DEST_THRESHOLD_EDGE) {
+						hintDownRoad = fabsf(currentPos - this->t1[i * width + idxX][1]);
+						hintDownScreen = i;
+						break;
+					}
+				}
+			}
+
+			int searchUp = 0, searchDown = 0;
+			if (hintUpScreen != idxY && hintDownScreen != idxY) {
+				if (hintUpRoad < hintDownRoad)
+					searchUp = 1;
+				else
+					searchDown = 1;
+			} else if (hintUpScreen != idxY) {
+				searchUp = 1;
+			} else if (hintDownScreen != idxY) {
+				searchDown = 1;
+			}
+
+			if (searchUp) {
+				for (int i = idxY - 1; i > limit[2]; i--) {
+					if (cpu_measure_fetch(this, previous, idxX, i) >= DEST_THRESHOLD_EDGE) {
+						displaceRoad = fabsf(currentPos - this->t1[i * width + idxX][1]);
+						displaceScreen = i;
+						break;
+					}
+				}
+			} else if (searchDown) {
+				for (int i = idxY + 1; i < limit[3]; i++) {
+					if (cpu_measure_fetch(this, previous, idxX, i) >= DEST_THRESHOLD_EDGE) {
+						displaceRoad = fabsf(currentPos - this->t1[i * width + idxX][1]);
+						displaceScreen = i;
+						break;
+					}
+				}
+			}
+		}
+
+		dest[x][0] = cpu_encode(displaceRoad * bias / 255.0f);
+		dest[x][1] = cpu_encode(0.5f + (float)(displaceScreen - idxY) / 255.0f);
+	}
+}
+
+static void cpu_unproject(const Cpu this, const unsigned int y) { //project mode 3: orthographic to perspective, x from O2P lookup
+	const unsigned int width = this->config.width;
+	const uint8_t* const mask = this->maskPersp + y * width;
+	rg8* const dest = this->stageB + y * width;
+	for (unsigned int x = 0; x < width; x++) {
+		dest[x][0] = dest[x][1] = 0;
+		if (!mask[x])
+			continue;
+		const int projX = (float)width * this->t2[y * width + x][3];
+		const uint8_t* const src = cpu_fetch(this, this->stageA, projX, y);
+		dest[x][0] = src[0];
+		dest[x][1] = src[1];
+	}
+}
+
+/** Sample: accumulate a path of measured pixels to one side, returns count, road and screen sum */
+static inline float cpu_sample_search(const Cpu this, int x, int y, const int dir, float* const road, float* const screen) {
+	const float* const d = this->decode;
+	const float threshold = 0.01f;
+	float count = 0.0f;
+	*road = *screen = 0.0f;
+	while (1) {
+		const uint8_t* value;
+		if (d[(value = cpu_fetch(this, this->stageB, x + dir, y))[0]] > threshold) {
+		} else if (d[(value = cpu_fetch(this, this->stageB, x + dir, y - 1))[0]] > threshold) {
+			y--;
+		} else if (d[(value = cpu_fetch(this, this->stageB, x + dir, y + 1))[0]] > threshold) {
+			y++;
+		} else {
+			break;
+		}
+		x += dir;
+		*road += d[value[0]];
+		*screen += d[value[1]];
+		count += 1.0f;
+	}
+	return count;
+}
+
+static void cpu_sample(const Cpu this, const unsigned int y) { //sample: center of a measured edge, mean of the edge
+	const unsigned int width = this->config.width;
+	const uint8_t* const mask = this->maskPersp + y * width;
+	rg8* const dest = this->speed + y * width;
+	for (int x = 0; x < (int)width; x++) {
+		dest[x][0] = dest[x][1] = 0;
+		if (!mask[x] || !(this->decode[this->stageB[y * width + x][0]] > 0.0f))
+			continue;
+		float leftRoad, leftScreen, rightRoad, rightScreen;
+		const float left = cpu_sample_search(this, x, y, -1, &leftRoad, &leftScreen);
+		const float right = cpu_sample_search(this, x, y, +1, &rightRoad, &rightScreen);
+		if (fminf(left, right) > this->config.minSampleSize && fabsf(0.5f + left - right) < 1.0f) {
+			const float both = left + right;
+			dest[x][0] = cpu_encode((leftRoad + rightRoad) / both);
+			dest[x][1] = cpu_encode((leftScreen + rightScreen) / both);
+		}
+	}
+}
+
+static const char* const cpu_name[cpu_pass_cnt] = {"blur", "changingSensor", "objectFix", "edgeRefine", "project", "measure", "unproject", "sample"};
+
+Cpu cpu_init(const cpu_config config, char** const statue) {
+	Cpu this = malloc(sizeof(struct Cpu_ClassDataStructure));
+	if (!this) {
+		if (statue)
+			*statue = "Fail to create cpu class object data structure";
+		return NULL;
+	}
+	*this = (struct Cpu_ClassDataStructure){ .config = config };
+
+	if (config.roadmap->header.width != config.width || config.roadmap->header.height != config.height) {
+		if (statue)
+			*statue = "Roadmap size must be the same as frame size";
+		cpu_destroy(this);
+		return NULL;
+	}
+	if (config.measureInterlace >= CPU_QUEUE_MAX) {
+		if (statue)
+			*statue = "Bad measureInterlace";
+		cpu_destroy(this);
+		return NULL;
+	}
+
+	const size_t size = config.width * config.height;
+	int fail = 0;
+	fail |= !( this->maskPersp = calloc(size, sizeof(uint8_t)) );
+	fail |= !( this->maskOrtho = calloc(size, sizeof(uint8_t)) );
+	fail |= !( this->t1 = malloc(size * sizeof(this->t1[0])) );
+	fail |= !( this->t2 = malloc(size * sizeof(this->t2[0])) );
+	fail |= !( this->raw[0] = calloc(size, sizeof(rgba8)) );
+	fail |= !( this->raw[1] = calloc(size, sizeof(rgba8)) );
+	if (config.temporal) { //Cleared, same as the GPU before the first frame
+		fail |= !( this->state[0] = calloc(size, sizeof(this->state[0][0])) );
+		fail |= !( this->state[1] = calloc(size, sizeof(this->state[0][0])) );
+	}
+	fail |= !( this->stageA = calloc(size, sizeof(rg8)) );
+	fail |= !( this->stageB = calloc(size, sizeof(rg8)) );
+	fail |= !( this->speed = calloc(size, sizeof(rg8)) );
+	for (unsigned int i = 0; i <= config.measureInterlace; i++)
+		fail |= !( this->object[i] = calloc(size, sizeof(uint8_t)) );
+	if (fail) {
+		if (statue)
+			*statue = "Fail to allocate memory for buffers";
+		cpu_destroy(this);
+		return NULL;
+	}
+
+	for (unsigned int i = 0; i < 256; i++)
+		this->decode[i] = cpu_unorm(i);
+	const roadmap* const map = config.roadmap;
+	for (size_t i = 0; i < size; i++) {
+		this->t1[i][0] = cpu_half(map->t1[i].px);
+		this->t1[i][1] = cpu_half(map->t1[i].py);
+		this->t1[i][2] = cpu_half(map->t1[i].ox);
+		this->t1[i][3] = cpu_half(map->t1[i].pw);
+		this->t2[i][0] = cpu_half(map->t2[i].searchLimitUp);
+		this->t2[i][1] = cpu_half(map->t2[i].searchLimitDown);
+		this->t2[i][2] = cpu_half(map->t2[i].lookupXp2o);
+		this->t2[i][3] = cpu_half(map->t2[i].lookupXo2p);
+	}
+	cpu_rasterize(this->maskPersp, config.width, config.height, map->roadPoints, map->header.pCnt - 4);
+	cpu_rasterize(this->maskOrtho, config.width, config.height, map->roadPoints + map->header.pCnt - 4, 4);
+
+	this->threadCnt = config.threads;
+	if (!this->threadCnt) {
+		long cpuCnt = sysconf(_SC_NPROCESSORS_ONLN);
+		this->threadCnt = cpuCnt > 0 ? cpuCnt : 1;
+	}
+	if (this->threadCnt > 1) {
+		this->worker = calloc(this->threadCnt, sizeof(struct Cpu_Worker));
+		if (!this->worker) {
+			if (statue)
+				*statue = "Fail to allocate memory for workers";
+			cpu_destroy(this);
+			return NULL;
+		}
+		pthread_mutex_init(&this->workerLock, NULL);
+		pthread_mutex_lock(&this->workerLock);
+		unsigned int started = 1; //Caller is worker 0
+		for (; started < this->threadCnt; started++) {
+			this->worker[started] = (struct Cpu_Worker){.this = this, .idx = started};
+			if (pthread_create(&this->worker[started].tid, NULL, cpu_worker, &this->worker[started]))
+				break;
+		}
+		if (started == this->threadCnt) {
+			pthread_barrier_init(&this->passStart, NULL, this->threadCnt);
+			pthread_barrier_init(&this->passEnd, NULL, this->threadCnt);
+			this->workerReady = 1;
+		}
+		pthread_mutex_unlock(&this->workerLock);
+		if (!this->workerReady) { //Started workers quit without a pass
+			for (unsigned int i = 1; i < started; i++)
+				pthread_join(this->worker[i].tid, NULL);
+			if (statue)
+				*statue = "Fail to create worker thread";
+			cpu_destroy(this);
+			return NULL;
+		}
+	}
+
+	return this;
+}
+
+const char* cpu_passName(const cpu_pass pass) {
+	return pass < cpu_pass_cnt ? cpu_name[pass] : NULL;
+}
+
+unsigned int cpu_threads(const Cpu this) {
+	return this->threadCnt;
+}
+
+void cpu_process(const Cpu this, const uint8_t (* const frame)[4], const unsigned int frameCnt, uint64_t* const time) {
+	this->frame = frame;
+	this->current = frameCnt & 1;
+	this->previous = 1 - this->current;
+	this->current_obj = frameCnt & this->config.measureInterlace;
+	this->hint_obj = (frameCnt - 1) & this->config.measureInterlace;
+	this->previous_obj = (frameCnt + 1) & this->config.measureInterlace;
+
+	uint64_t stamp = nanotime();
+	void record(cpu_pass pass) {
+		uint64_t now = nanotime();
+		if (time)
+			time[pass] = now - stamp;
+		stamp = now;
+	}
+
+	cpu_run(this, this->config.temporal ? cpu_temporalFilter : cpu_blur);
+	record(cpu_pass_blur);
+	cpu_run(this, cpu_changingSensor);
+	record(cpu_pass_changingSensor);
+	this->direction = 0; //Horizontal: stageA to stageB
+	cpu_run(this, cpu_objectFix);
+	this->direction = 1; //Vertical: stageB to stageA
+	cpu_run(this, cpu_objectFix);
+	record(cpu_pass_objectFix);
+	cpu_run(this, cpu_edgeRefine);
+	record(cpu_pass_edgeRefine);
+	cpu_run(this, cpu_project);
+	record(cpu_pass_project);
+	cpu_run(this, cpu_measure);
+	record(cpu_pass_measure);
+	cpu_run(this, cpu_unproject);
+	record(cpu_pass_unproject);
+	cpu_run(this, cpu_sample);
+	record(cpu_pass_sample);
+}
+
+void cpu_download(const Cpu this, uint8_t (* const dest)[2], const unsigned int offset[2], const unsigned int size[2]) {
+	for (unsigned int y = 0; y < size[1]; y++)
+		memcpy(dest + y * size[0], this->speed + (offset[1] + y) * this->config.width + offset[0], size[0] * sizeof(rg8));
+}
+
+void cpu_destroy(const Cpu this) {
+	if (!this)
+		return;
+
+	if (this->workerReady) { //Wake up workers with no pass to stop them
+		this->pass = NULL;
+		pthread_barrier_wait(&this->passStart);
+		for (unsigned int i = 1; i < this->threadCnt; i++)
+			pthread_join(this->worker[i].tid, NULL);
+		pthread_barrier_destroy(&this->passEnd);
+		pthread_barrier_destroy(&this->passStart);
+	}
+	if (this->worker)
+		pthread_mutex_destroy(&this->workerLock);
+	free(this->worker);
+
+	for (unsigned int i = 0; i < CPU_QUEUE_MAX; i++)
+		free(this->object[i]);
+	free(this->speed);
+	free(this->stageB);
+	free(this->stageA);
+	free(this->state[1]);
+	free(this->state[0]);
+	free(this->raw[1]);
+	free(this->raw[0]);
+	free(this->t2);
+	free(this->t1);
+	free(this->maskOrtho);
+	free(this->maskPersp);
+	free(this);
+}
@@ -0,0 +1,113 @@
+/** Class - Cpu.class.
+ * CPU reference of the GPU pipeline: blur, changing sensor, object fix, edge refine, project, measure, unproject and sample.
+ * Each pass follows its shader step by step on the same texture formats (RGBA8, RG8, R8, RGBA16F), with float arithmetic at full precision; it is the reference of fb_speed of the GPU.
+ * A GPU that evaluates mediump in fp16 (e.g. llvmpipe) rounds differently, so some px of the speed map may differ; check mode reports them.
+ * Pixels are processed in bands of rows by a pool of worker threads, the caller joins as the first worker; each pass ends with a barrier, like a GPU pass.
+ * Focus region (mesh) is rasterized once at init with the same fill rule as the GPU, pixels out of the mesh are 0 (like gl_frameBuffer_clearAll).
+ */
+
+#ifndef INCLUDE_CPU_H
+#define INCLUDE_CPU_H
+
+#include <inttypes.h>
+
+#include "roadmap.h"
+
+/* Defaults of shader macros, same as in the shaders; can be changed by the same "shaderName.MACRO = value" in config file */
+#define CPU_TEMPORALFILTER_ALPHA 0.25 //temporalFilter.ALPHA
+#define CPU_TEMPORALFILTER_MOTION 0.1 //temporalFilter.MOTION
+#define CPU_CHANGINGSENSOR_THRESHOLD 0.2 //changingSensor.THRESHOLD
+#define CPU_OBJECTFIX_SEARCH_DISTANCE 0.7 //objectFix.SEARCH_DISTANCE
+#define CPU_EDGEREFINE_BOTTOMDENOISE 0.2 //edgeRefine.SHADER_EDGEREFINE_BOTTOMDENOISE
+#define CPU_EDGEREFINE_SIDEMARGIN 0.6 //edgeRefine.SHADER_EDGEREFINE_SIDEMARGIN
+#define CPU_SAMPLE_MIN_SAMPLE_SIZE 2.0 //sample.MIN_SAMPLE_SIZE
+
+#define CPU_QUEUE_MAX 16 //Max measureInterlace + 1
+
+/** Passes, for time of each pass
+ */
+typedef enum Cpu_Pass {
+	cpu_pass_blur,
+	cpu_pass_changingSensor,
+	cpu_pass_objectFix,
+	cpu_pass_edgeRefine,
+	cpu_pass_project,
+	cpu_pass_measure,
+	cpu_pass_unproject,
+	cpu_pass_sample,
+	cpu_pass_cnt
+} cpu_pass;
+
+/** Config of the pipeline
+ */
+typedef struct Cpu_Config {
+	unsigned int width, height; //Frame size in px, same as roadmap
+	const roadmap* roadmap; //After roadmap_post(), read at init only
+	unsigned int measureInterlace; //2^n - 1, same as GPU
+	float bias; //Measure: m/Nframe to km/h, same as uniform "bias" of measure shader
+	unsigned int mono; //blurFilter.MONO is defined
+	unsigned int bilinear; //blurFilter.BILINEAR is defined
+	unsigned int temporal; //temporalFilter instead of blurFilter (denoise = 1)
+	float alpha, motion; //temporalFilter.ALPHA and MOTION
+	float threshold; //changingSensor.THRESHOLD
+	float searchDistance; //objectFix.SEARCH_DISTANCE
+	float bottomDenoise, sideMargin; //edgeRefine.SHADER_EDGEREFINE_BOTTOMDENOISE and SHADER_EDGEREFINE_SIDEMARGIN
+	float minSampleSize; //sample.MIN_SAMPLE_SIZE
+	unsigned int threads; //Number of threads include the caller, 0 for number of CPUs
+} cpu_config;
+
+/** Cpu class object data structure
+ */
+typedef struct Cpu_ClassDataStructure* Cpu;
+
+/** Init a CPU pipeline: rasterize focus region, load roadmap, create buffers and worker threads.
+ * @param config Config of the pipeline
+ * @param statue If not NULL, return error message in case this function fail
+ * @return $this(Opaque) cpu class object upon success. If fail, free all resource and return NULL
+ */
+Cpu cpu_init(const cpu_config config, char** const statue);
+
+/** Get the name of a pass.
+ * @param pass Pass
+ * @return Name of the pass, same as the shader
+ */
+const char* cpu_passName(const cpu_pass pass);
+
+/** Get number of threads in use (include the caller).
+ * @param this This cpu class object
+ * @return Number of threads
+ */
+unsigned int cpu_threads(const Cpu this);
+
+/** Process a frame, blocks until all passes are done. Frames must be processed in order, as the GPU does.
+ * @param this This cpu class object
+ * @param frame Video frame, RGBA8, width * height
+ * @param frameCnt Frame number, selects the raw and object queues the same way as the GPU
+ * @param time If not NULL, return time of each pass in ns (cpu_pass_cnt elements)
+ */
+void cpu_process(const Cpu this, const uint8_t (* const frame)[4], const unsigned int frameCnt, uint64_t* const time);
+
+/** Copy a box of the speed map of the last processed frame, same layout as gl_frameBuffer_download() of fb_speed.
+ * @param this This cpu class object
+ * @param dest Destination, RG8, size[0] * size[1]
+ * @param offset Left and top of the box in px
+ * @param size Width and height of the box in px
+ */
+void cpu_download(const Cpu this, uint8_t (* const dest)[2], const unsigned int offset[2], const unsigned int size[2]);
+
+/** Rasterize a triangle strip of the roadmap to a mask, same coverage as the GPU: a pixel is covered if its center is inside a triangle, top-left fill rule on edges.
+ * Also used to build the focus region mask of the fused edge shader.
+ * @param mask Destination, 1 byte a pixel, width * height, covered pixels are set to 1, others are not touched
+ * @param width Width of the mask in px
+ * @param height Height of the mask in px
+ * @param point Vertices of the strip, NTC coord in screen member
+ * @param cnt Number of vertices
+ */
+void cpu_rasterize(uint8_t* const mask, const unsigned int width, const unsigned int height, const struct RoadPoint* const point, const unsigned int cnt);
+
+/** Destroy this cpu class object, stops worker threads, frees resources.
+ * @param this This cpu class object, NULL is OK
+ */
+void cpu_destroy(const Cpu this);
+
+#endif /* #ifndef INCLUDE_CPU_H */
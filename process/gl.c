@@ -2,9 +2,12 @@
 #include <stdlib.h>
 #include <stdarg.h>
 #include <string.h>
+#include <time.h>
 
 #include <GL/glew.h>
 #include <GL/glfw3.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
 
 #include "gl.h"
 
@@ -15,6 +18,14 @@
 /* == Window and driver management ========================================================== */
 
 GLFWwindow* window = NULL; //Display window object
+gl_backend backend = gl_backend_glfw;
+EGLDisplay eglDisplay = EGL_NO_DISPLAY; //EGL backend: surfaceless display and context, no window
+EGLContext eglContext = EGL_NO_CONTEXT;
+int eglSize[2] = {0, 0}; //EGL backend: window size in config, reported as window and framebuffer size
+int eglClose = 0; //EGL backend: close flag
+
+int __gl_initGlfw(gl_config config); //Create GLFW window and its context
+int __gl_initEgl(gl_config config); //Create EGL surfaceless context, no window
 
 void __gl_windowCloseCallback(GLFWwindow* window); //Event callback when window closed by user (X button or kill)
 void __gl_glfwErrorCallback(int code, const char* desc); //GLFW error log
@@ -29,40 +40,16 @@ void GLAPIENTRY __gl_glErrorCallback(GLenum src, GLenum type, GLuint id, GLenum
 
 int gl_init(gl_config config) {
 	__gl_log("Init OpenGL");
+	backend = config.backend;
 
-	/* init GLFW */
-	if (!glfwInit()) {
-		#ifdef VERBOSE
-			__gl_elog("\tFail to init GLFW");
-		#endif
+	if ( !(backend == gl_backend_egl ? __gl_initEgl(config) : __gl_initGlfw(config)) ) {
 		gl_destroy();
 		return 0;
 	}
 
-	/* Start and config OpenGL, init window */
-	glfwWindowHint(GLFW_CLIENT_API, config.gles ? GLFW_OPENGL_ES_API : GLFW_OPENGL_API);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, config.vMajor);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, config.vMinor);
-	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-//	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
-	#ifdef VERBOSE
-		glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GL_TRUE);
-	#endif
-	window = glfwCreateWindow(config.winWidth, config.winHeight, config.winName, NULL, NULL);
-	if (!window){
-		#ifdef VERBOSE
-			__gl_elog("\tFail to open window");
-		#endif
-		gl_destroy();
-		return 0;
-	}
-	glfwMakeContextCurrent(window);
-
-	glfwSwapInterval(config.vsynch);
-
 	/* Init GLEW */
 	glewExperimental = GL_TRUE;
-	GLenum glewInitError = glewInit();
+	GLenum glewInitError = backend == gl_backend_egl ? glewContextInit() : glewInit(); //glewInit() requires GLX display, context init only loads GL functions
 	if (glewInitError != GLEW_OK) {
 		#ifdef VERBOSE
 			__gl_elog("\tFail init GLEW: %s", glewGetErrorString(glewInitError));
@@ -90,8 +77,10 @@ int gl_init(gl_config config) {
 	__gl_log("\t- Max Vertex texture units: %d", textureImageUnitVertex);
 
 	/* Event control - callback */
-	glfwSetWindowCloseCallback(window, __gl_windowCloseCallback);
-	glfwSetErrorCallback(__gl_glfwErrorCallback);
+	if (backend == gl_backend_glfw) {
+		glfwSetWindowCloseCallback(window, __gl_windowCloseCallback);
+		glfwSetErrorCallback(__gl_glfwErrorCallback);
+	}
 	glDebugMessageCallback(__gl_glErrorCallback, NULL);
 
 	/* OpenGL config */
@@ -99,8 +88,105 @@ int gl_init(gl_config config) {
 //	glEnable(GL_DEPTH_TEST); glDepthFunc(GL_LESS);
 //	glEnable(GL_CULL_FACE); glCullFace(GL_BACK); glFrontFace(GL_CCW);
 //	glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-	glfwSetCursor(window, glfwCreateStandardCursor(GLFW_CROSSHAIR_CURSOR));
+	if (backend == gl_backend_glfw)
+		glfwSetCursor(window, glfwCreateStandardCursor(GLFW_CROSSHAIR_CURSOR));
+
+	return 1;
+}
+
+int __gl_initGlfw(gl_config config) {
+	/* init GLFW */
+	if (!glfwInit()) {
+		#ifdef VERBOSE
+			__gl_elog("\tFail to init GLFW");
+		#endif
+		return 0;
+	}
+
+	/* Start and config OpenGL, init window */
+	glfwWindowHint(GLFW_CLIENT_API, config.gles ? GLFW_OPENGL_ES_API : GLFW_OPENGL_API);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, config.vMajor);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, config.vMinor);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+//	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+	#ifdef VERBOSE
+		glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GL_TRUE);
+	#endif
+	window = glfwCreateWindow(config.winWidth, config.winHeight, config.winName, NULL, NULL);
+	if (!window){
+		#ifdef VERBOSE
+			__gl_elog("\tFail to open window");
+		#endif
+		return 0;
+	}
+	glfwMakeContextCurrent(window);
+
+	glfwSwapInterval(config.vsynch);
+	return 1;
+}
+
+int __gl_initEgl(gl_config config) {
+	const char* clientExt = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS); //Client extensions, NULL if not supported
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	if (!clientExt || !strstr(clientExt, "EGL_MESA_platform_surfaceless") || !getPlatformDisplay) {
+		__gl_elog("\tEGL surfaceless platform not supported");
+		return 0;
+	}
+
+	eglDisplay = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+	EGLint eglMajor, eglMinor;
+	if (eglDisplay == EGL_NO_DISPLAY || !eglInitialize(eglDisplay, &eglMajor, &eglMinor)) {
+		__gl_elog("\tFail to init EGL display (error %x)", eglGetError());
+		eglDisplay = EGL_NO_DISPLAY;
+		return 0;
+	}
+	__gl_log("EGL %d.%d, surfaceless", eglMajor, eglMinor);
+	const char* displayExt = eglQueryString(eglDisplay, EGL_EXTENSIONS);
+	if (!displayExt || !strstr(displayExt, "EGL_KHR_surfaceless_context")) { //Make context current without surface
+		__gl_elog("\tEGL surfaceless context not supported");
+		return 0;
+	}
+
+	if (!eglBindAPI(config.gles ? EGL_OPENGL_ES_API : EGL_OPENGL_API)) {
+		__gl_elog("\tFail to bind EGL API (error %x)", eglGetError());
+		return 0;
+	}
+	EGLConfig eglConfig = EGL_NO_CONFIG_KHR; //No surface, config is not needed if supported
+	if (!strstr(displayExt, "EGL_KHR_no_config_context")) {
+		const EGLint configAttr[] = {
+			EGL_RENDERABLE_TYPE, config.gles ? EGL_OPENGL_ES3_BIT : EGL_OPENGL_BIT,
+			EGL_NONE
+		};
+		EGLint configCnt;
+		if (!eglChooseConfig(eglDisplay, configAttr, &eglConfig, 1, &configCnt) || !configCnt) {
+			__gl_elog("\tNo EGL config (error %x)", eglGetError());
+			return 0;
+		}
+	}
+
+	EGLint contextAttr[9], * attr = contextAttr;
+	*attr++ = EGL_CONTEXT_MAJOR_VERSION;	*attr++ = config.vMajor;
+	*attr++ = EGL_CONTEXT_MINOR_VERSION;	*attr++ = config.vMinor;
+	if (!config.gles) {
+		*attr++ = EGL_CONTEXT_OPENGL_PROFILE_MASK;	*attr++ = EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT;
+	}
+	#ifdef VERBOSE
+		*attr++ = EGL_CONTEXT_OPENGL_DEBUG;	*attr++ = EGL_TRUE;
+	#endif
+	*attr = EGL_NONE;
+	eglContext = eglCreateContext(eglDisplay, eglConfig, EGL_NO_CONTEXT, contextAttr);
+	if (eglContext == EGL_NO_CONTEXT) {
+		__gl_elog("\tFail to create EGL context (error %x)", eglGetError());
+		return 0;
+	}
+	if (!eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, eglContext)) {
+		__gl_elog("\tFail to make EGL context current (error %x)", eglGetError());
+		return 0;
+	}
 
+	eglSize[0] = config.winWidth;
+	eglSize[1] = config.winHeight;
+	eglClose = 0;
 	return 1;
 }
 
@@ -109,11 +195,18 @@ void* gl_getWindow() {
 }
 
 void gl_drawStart() {
-	glfwPollEvents();
+	if (backend == gl_backend_glfw)
+		glfwPollEvents();
 }
 
 gl_winsizeNcursor gl_getWinsizeCursor() {
 	gl_winsizeNcursor x;
+	if (backend == gl_backend_egl) { //No window, no cursor
+		return (gl_winsizeNcursor){
+			.winsize = {eglSize[0], eglSize[1]},
+			.framesize = {eglSize[0], eglSize[1]}
+		};
+	}
 	glfwGetCursorPos(window, x.curPos, x.curPos+1); //In fact, this call returns cursor pos respect to window
 	glfwGetWindowSize(window, x.winsize, x.winsize+1);
 	glfwGetFramebufferSize(window, x.framesize, x.framesize+1); //Window size and framebuffer size may differ if DPI is not 1
@@ -130,6 +223,9 @@ void gl_setViewport(const unsigned int offset[static 2], const unsigned int size
 }
 
 void gl_drawEnd(const char* const title) {
+	if (backend == gl_backend_egl) //Nothing to show
+		return;
+
 	if (title)
 		glfwSetWindowTitle(window, title);
 	
@@ -137,6 +233,12 @@ void gl_drawEnd(const char* const title) {
 }
 
 int gl_close(const int close) {
+	if (backend == gl_backend_egl) {
+		if (close >= 0)
+			eglClose = close > 0;
+		return eglClose;
+	}
+
 	if (close == 0) {
 		__gl_log("Request to keep window");
 		glfwSetWindowShouldClose(window, 0);
@@ -153,6 +255,17 @@ int gl_close(const int close) {
 void gl_destroy() {
 	__gl_log("Destroy OpenGL");
 	gl_close(1);
+	if (backend == gl_backend_egl) {
+		if (eglDisplay != EGL_NO_DISPLAY) {
+			eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+			if (eglContext != EGL_NO_CONTEXT)
+				eglDestroyContext(eglDisplay, eglContext);
+			eglTerminate(eglDisplay);
+		}
+		eglContext = EGL_NO_CONTEXT;
+		eglDisplay = EGL_NO_DISPLAY;
+		return;
+	}
 	glfwTerminate();
 }
 
@@ -199,6 +312,142 @@ void gl_synchDelete(const gl_synch s) {
 	glDeleteSync(s);
 }
 
+gl_timer gl_timer_create(const unsigned int depth, const unsigned int stamps) {
+	gl_timer timer = GL_INIT_DEFAULT_TIMER;
+	timer.mode = GLEW_EXT_disjoint_timer_query ? 1 : GLEW_ARB_timer_query ? 2 : 0;
+	timer.depth = depth;
+	timer.stamps = stamps;
+	timer.head = 0;
+	timer.pending = 0;
+	timer.drop = 0;
+	timer.cnt = calloc(depth, sizeof(unsigned int));
+	timer.tag = calloc(depth, sizeof(unsigned int));
+	if (!timer.cnt || !timer.tag) {
+		gl_timer_delete(&timer);
+		return timer;
+	}
+
+	if (timer.mode) {
+		__gl_log("GPU timer: timestamp query (%s)", timer.mode == 1 ? "GL_EXT_disjoint_timer_query" : "GL_ARB_timer_query");
+		timer.query = malloc(depth * stamps * sizeof(unsigned int));
+		if (!timer.query) {
+			gl_timer_delete(&timer);
+			return timer;
+		}
+		glGenQueries(depth * stamps, timer.query);
+		if (timer.mode == 1)
+			glGetIntegerv(GL_GPU_DISJOINT_EXT, (int[1]){0}); //Clear disjoint flag
+	} else {
+		__gl_log("GPU timer: timestamp query not supported, use fence (stall)");
+		timer.synch = calloc(stamps, sizeof(gl_synch));
+		timer.time = calloc(depth * stamps, sizeof(uint64_t));
+		if (!timer.synch || !timer.time)
+			gl_timer_delete(&timer);
+	}
+	return timer;
+}
+
+int gl_timer_check(const gl_timer* const timer) {
+	return timer->cnt != NULL;
+}
+
+void gl_timer_stamp(gl_timer* const timer) {
+	if (!timer->cnt) //Not created
+		return;
+	unsigned int* cnt = &timer->cnt[timer->head];
+	if (*cnt >= timer->stamps)
+		return;
+
+	if (timer->mode == 1)
+		glQueryCounterEXT(timer->query[timer->head * timer->stamps + *cnt], GL_TIMESTAMP_EXT);
+	else if (timer->mode == 2)
+		glQueryCounter(timer->query[timer->head * timer->stamps + *cnt], GL_TIMESTAMP);
+	else
+		timer->synch[*cnt] = gl_synchSet();
+	(*cnt)++;
+}
+
+void gl_timer_frameEnd(gl_timer* const timer, const unsigned int tag) {
+	if (!timer->cnt) //Not created
+		return;
+	if (!timer->mode) { //Wait fences in order, time is taken when each one is signaled
+		uint64_t* time = timer->time + timer->head * timer->stamps;
+		for (unsigned int i = 0; i < timer->cnt[timer->head]; i++) {
+			gl_synchWait(timer->synch[i], 5000000000LLU);
+			struct timespec ts;
+			clock_gettime(CLOCK_MONOTONIC, &ts);
+			time[i] = (uint64_t)ts.tv_sec * 1000000000LLU + ts.tv_nsec;
+			gl_synchDelete(timer->synch[i]);
+		}
+	}
+
+	timer->tag[timer->head] = tag;
+	timer->head = (timer->head + 1) % timer->depth;
+	timer->cnt[timer->head] = 0;
+	if (timer->pending == timer->depth - 1) { //Ring full, next frame overwrites the oldest
+		timer->drop++;
+		return;
+	}
+	timer->pending++;
+}
+
+int gl_timer_read(gl_timer* const timer, const int wait, unsigned int* const tag, uint64_t* const duration) {
+	if (!timer->pending)
+		return -1;
+	unsigned int oldest = (timer->head + timer->depth - timer->pending) % timer->depth;
+	unsigned int cnt = timer->cnt[oldest];
+
+	if (timer->mode) {
+		unsigned int* query = timer->query + oldest * timer->stamps;
+		if (cnt && !wait) { //Queries finish in order, the last one is the last to be ready
+			unsigned int available = 0;
+			glGetQueryObjectuiv(query[cnt - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available)
+				return -1;
+		}
+		uint64_t prev = 0;
+		for (unsigned int i = 0; i < cnt; i++) {
+			uint64_t time = 0;
+			if (timer->mode == 1)
+				glGetQueryObjectui64vEXT(query[i], GL_QUERY_RESULT, &time);
+			else
+				glGetQueryObjectui64v(query[i], GL_QUERY_RESULT, &time);
+			if (i)
+				duration[i - 1] = time - prev;
+			prev = time;
+		}
+		if (timer->mode == 1) { //GPU time is not continuous (e.g. frequency change), results since last check are not valid
+			int disjoint = 0;
+			glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+			if (disjoint)
+				cnt = 0;
+		}
+	} else {
+		uint64_t* time = timer->time + oldest * timer->stamps;
+		for (unsigned int i = 1; i < cnt; i++)
+			duration[i - 1] = time[i] - time[i - 1];
+	}
+
+	*tag = timer->tag[oldest];
+	timer->pending--;
+	return cnt;
+}
+
+void gl_timer_delete(gl_timer* const timer) {
+	if (timer->query)
+		glDeleteQueries(timer->depth * timer->stamps, timer->query);
+	if (timer->synch && timer->cnt) { //Fences of the frame being recorded
+		for (unsigned int i = 0; i < timer->cnt[timer->head]; i++)
+			gl_synchDelete(timer->synch[i]);
+	}
+	free(timer->query);
+	free(timer->synch);
+	free(timer->time);
+	free(timer->cnt);
+	free(timer->tag);
+	*timer = GL_INIT_DEFAULT_TIMER;
+}
+
 void __gl_windowCloseCallback(GLFWwindow* window) {
 	__gl_log("Window close event fired");
 	glfwSetWindowShouldClose(window, 1);
@@ -249,8 +498,8 @@ gl_program gl_program_load(char* src, gl_programArg* const args) {
 		code = src + 1;
 	}
 
-	const unsigned int shaderTypes[] = {GL_VERTEX_SHADER, GL_FRAGMENT_SHADER, GL_GEOMETRY_SHADER};
-	const char* shaderTokens[] = {"@VS\n", "@FS\n", "@GS\n"};
+	const unsigned int shaderTypes[] = {GL_VERTEX_SHADER, GL_FRAGMENT_SHADER, GL_GEOMETRY_SHADER, GL_COMPUTE_SHADER};
+	const char* shaderTokens[] = {"@VS\n", "@FS\n", "@GS\n", "@CS\n"};
 	const unsigned int shaderCnt = sizeof(shaderTypes) / sizeof(shaderTypes[0]);
 	struct {
 		GLuint name; //GL shader name
@@ -396,6 +645,10 @@ void gl_program_setParam(const gl_param paramId, const unsigned int length, cons
 		__gl_elog("Param set fail: GL supports date type int, uint and float only");
 }
 
+void gl_program_dispatch(const unsigned int groups[static 3]) {
+	glDispatchCompute(groups[0], groups[1], groups[2]);
+}
+
 void gl_program_delete(gl_program* const program) {
 	glDeleteProgram(*program);
 	*program = GL_INIT_DEFAULT_PROGRAM;
@@ -436,6 +689,61 @@ void gl_unifromBuffer_delete(gl_ubo* const ubo) {
 	*ubo = GL_INIT_DEFAULT_UBO;
 }
 
+gl_sbo gl_storageBuffer_create(const unsigned int bindingPoint, const unsigned int size, const gl_usage usage) {
+	const GLenum usageLookup[] = {GL_STREAM_READ, GL_STATIC_READ, GL_DYNAMIC_READ}; //Written by shader, read by CPU
+	if (usage < 0 || usage >= gl_usage_placeholderEnd)
+		return GL_INIT_DEFAULT_SBO;
+
+	gl_sbo sbo = GL_INIT_DEFAULT_SBO;
+
+	glGenBuffers(1, &sbo);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, sbo);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, size, NULL, usageLookup[usage]);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, bindingPoint, sbo);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	return sbo;
+}
+
+int gl_storageBuffer_check(const gl_sbo* const sbo) {
+	return *sbo != GL_INIT_DEFAULT_SBO;
+}
+
+void gl_storageBuffer_bind(const gl_sbo* const sbo, const unsigned int bindingPoint) {
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, bindingPoint, *sbo);
+}
+
+void gl_storageBuffer_update(const gl_sbo* const sbo, const unsigned int start, const unsigned int len, const void* const data) {
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, *sbo);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, start, len, data);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void* gl_storageBuffer_download(const gl_sbo* const sbo, const unsigned int start, const unsigned int len) {
+	glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT); //Shader writes are incoherent, make them visible to buffer mapping
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, *sbo);
+	return glMapBufferRange(GL_SHADER_STORAGE_BUFFER, start, len, GL_MAP_READ_BIT);
+}
+
+void gl_storageBuffer_downloadDiscard() {
+	glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void gl_storageBuffer_resize(const gl_sbo* const sbo, const unsigned int size, const gl_usage usage) {
+	const GLenum usageLookup[] = {GL_STREAM_READ, GL_STATIC_READ, GL_DYNAMIC_READ}; //Same as gl_storageBuffer_create()
+	if (usage < 0 || usage >= gl_usage_placeholderEnd)
+		return;
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, *sbo);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, size, NULL, usageLookup[usage]);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void gl_storageBuffer_delete(gl_sbo* const sbo) {
+	glDeleteBuffers(1, sbo);
+	*sbo = GL_INIT_DEFAULT_SBO;
+}
+
 /* == Mesh (vertices) ======================================================================= */
 
 gl_mesh gl_mesh_create(
@@ -527,6 +835,11 @@ void gl_mesh_updateInstances(const gl_mesh* const mesh, const gl_vertex_t* const
 	glBufferSubData(GL_ARRAY_BUFFER, start * sizeof(gl_vertex_t), len * sizeof(gl_vertex_t), instances);
 }
 
+void gl_mesh_resizeInstances(const gl_mesh* const mesh, const unsigned int len) {
+	glBindBuffer(GL_ARRAY_BUFFER, mesh->ibo);
+	glBufferData(GL_ARRAY_BUFFER, len * sizeof(gl_vertex_t), NULL, GL_STREAM_DRAW); //Same buffer object, attribute binding in VAO is kept
+}
+
 void gl_mesh_draw(const gl_mesh* const mesh, const unsigned int vSize, const unsigned int iSize) {
 	glBindVertexArray(mesh->vao);
 	if (mesh->ibo) {
@@ -617,11 +930,12 @@ gl_tex gl_texture_create(const gl_texformat format, const gl_textype type, const
 		case gl_textype_2d:
 			glGenTextures(1, &tex);
 			glBindTexture(GL_TEXTURE_2D, tex);
-			glTexImage2D(
-				GL_TEXTURE_2D, 0, __gl_texformat_lookup[format].internalFormat,
-				dim[0].size, dim[1].size,
-				0, __gl_texformat_lookup[format].format, __gl_texformat_lookup[format].type, NULL
-			);
+			GLsizei levels = 1;
+			if (mipmap) {
+				for (unsigned int size = dim[0].size > dim[1].size ? dim[0].size : dim[1].size; size > 1; size >>= 1)
+					levels++;
+			}
+			glTexStorage2D(GL_TEXTURE_2D, levels, __gl_texformat_lookup[format].internalFormat, dim[0].size, dim[1].size); //Immutable storage, required to bind as image
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter); //GL_LINEAR
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, magFilter);
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, dim[0].wrapping);
@@ -713,6 +1027,14 @@ void gl_texture_bind(const gl_tex* const tex, const gl_param paramId, const unsi
 	glUniform1i(paramId, unit);
 }
 
+void gl_texture_bindImage(const gl_tex* const tex, const unsigned int unit) {
+	glBindImageTexture(unit, tex->texture, 0, GL_FALSE, 0, GL_WRITE_ONLY, __gl_texformat_lookup[tex->format].internalFormat);
+}
+
+void gl_texture_syncImage() {
+	glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT); //Image writes are incoherent
+}
+
 void gl_texture_delete(gl_tex* const tex) {
 	if (tex->type == gl_textype_renderBuffer)
 		glDeleteRenderbuffers(1,&tex->texture );
@@ -785,9 +1107,15 @@ void gl_frameBuffer_download(const gl_fbo* const fbo, void* const dest, const gl
 	if (format < 0 || format >= gl_texformat_placeholderEnd)
 		return;
 	
+	GLint pbo; //Pixel buffer download may be in progress, download to client memory without disturbing it
+	glGetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING, &pbo);
+	if (pbo != GL_INIT_DEFAULT_PBO)
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, GL_INIT_DEFAULT_PBO);
 	glBindFramebuffer(GL_READ_FRAMEBUFFER, *fbo);
 	glReadBuffer(GL_COLOR_ATTACHMENT0 + attachment);
 	glReadPixels(offset[0], offset[1], size[0], size[1], __gl_texformat_lookup[format].format, __gl_texformat_lookup[format].type, dest);
+	if (pbo != GL_INIT_DEFAULT_PBO)
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
 }
 
 void gl_frameBuffer_delete(gl_fbo* const fbo) {
@@ -859,14 +1187,18 @@ void gl_pixelBuffer_downloadStart(const gl_pbo* pbo, const gl_fbo* const fbo, co
 	glReadBuffer(GL_COLOR_ATTACHMENT0 + attachment);
 	glBindBuffer(GL_PIXEL_PACK_BUFFER, *pbo);
 	glReadPixels(offset[0], offset[1], size[0], size[1], __gl_texformat_lookup[format].format, __gl_texformat_lookup[format].type, 0);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, GL_INIT_DEFAULT_PBO);
 }
 
-void* gl_pixelBuffer_downloadFinish(const unsigned int size) {
+void* gl_pixelBuffer_downloadFinish(const gl_pbo* pbo, const unsigned int size) {
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, *pbo);
 	void* ptr = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, GL_INIT_DEFAULT_PBO);
 	return ptr;
 }
 
-void gl_pixelBuffer_downloadDiscard() {
+void gl_pixelBuffer_downloadDiscard(const gl_pbo* pbo) {
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, *pbo);
 	glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
 	glBindBuffer(GL_PIXEL_PACK_BUFFER, GL_INIT_DEFAULT_PBO);
 }
@@ -1,6 +1,6 @@
 /** Class - GL.class. Captdam's OpenGL helper class. 
  * Start, load, config, manage and destroy OpenGL engine. 
- * GLFW and GLEW are used as backend of this class. 
+ * GLFW and GLEW are used as backend of this class; EGL (surfaceless) can be used instead of GLFW for off-screen rendering without window system. 
  * Only one GL class and one window is allowed. 
  * Use this class to access OpenGL engine. 
  */
@@ -10,6 +10,12 @@
 
 /* == Common ================================================================================ */
 
+/** Context and window backend */
+typedef enum GL_Backend {
+	gl_backend_glfw = 0,	//GLFW: Context with a window on screen, requires window system (X11, Wayland)
+	gl_backend_egl = 1,	//EGL (EGL_MESA_platform_surfaceless): Context without window, render to FBO only, works without window system and GPU (Mesa software rasterizer)
+gl_backend_placeholderEnd} gl_backend;
+
 /** Init config */
 typedef struct GL_Config {
 	uint8_t vMajor;			//OpenGl version major
@@ -18,6 +24,7 @@ typedef struct GL_Config {
 	uint8_t vsynch;			//Limit FPS to v-synch points
 	uint16_t winWidth, winHeight;	//Window size
 	char* winName;			//Window name
+	gl_backend backend;		//Context and window backend, default is GLFW
 } gl_config;
 
 /** Usage frequency hint for driver */
@@ -47,6 +54,20 @@ typedef enum GL_Synch_Status {
 	gl_synch_ok = 2		//Command finished before timeout
 } gl_synch_status; //Synch status
 
+/** GPU timer: GPU time at points (stamps) in the command queue, a ring of frames read back a few frames later */
+typedef struct GL_Timer {
+	int mode;			//0: Fence (timer query not supported), 1: GL_EXT_disjoint_timer_query, 2: GL_ARB_timer_query
+	unsigned int depth, stamps;	//Number of frames in ring, max number of stamps in a frame
+	unsigned int* query;		//Query mode: Timestamp queries, depth * stamps
+	gl_synch* synch;		//Fence mode: Fences of the frame being recorded, stamps
+	uint64_t* time;			//Fence mode: Time the fence is signaled (CPU clock), depth * stamps
+	unsigned int* cnt;		//Number of stamps of each frame in ring
+	unsigned int* tag;		//User tag of each frame in ring
+	unsigned int head, pending;	//Frame being recorded, number of finished frames not read (before head)
+	unsigned int drop;		//Number of finished frames overwritten before read
+} gl_timer;
+#define GL_INIT_DEFAULT_TIMER (gl_timer){.query = NULL, .synch = NULL, .time = NULL, .cnt = NULL, .tag = NULL}
+
 /* == Shader and shader param data types, UBO =============================================== */
 
 typedef unsigned int gl_program; //Shader program
@@ -61,12 +82,15 @@ typedef enum GL_DataType {
 gl_datatype_placeholderEnd } gl_datatype;
 typedef unsigned int gl_ubo; //Uniform buffer object
 #define GL_INIT_DEFAULT_UBO (gl_ubo)0
+typedef unsigned int gl_sbo; //Shader storage buffer object
+#define GL_INIT_DEFAULT_SBO (gl_sbo)0
 
 /** Shader types */
 typedef enum GL_ProgramSourceCodeType {
 	gl_programSrcType_vertex = 0,		//Vertex shader
 	gl_programSrcType_fragment = 1,		//Fragment shader
 	gl_programSrcType_geometry = 2,		//Geometry shader (optional)
+	gl_programSrcType_compute = 3,		//Compute shader (use alone)
 gl_programSrcType_placeholderEnd } gl_programSrcType;
 /** Shader code source */
 typedef enum GL_ProgramSourceCodeLocation {
@@ -197,12 +221,14 @@ typedef enum GL_FramebufferAttachment {
 /* == Window and driver management ========================================================== */
 
 /** Init the GL class. 
+ * With EGL backend, there is no window and default framebuffer: drawing to screen and swapping buffer do nothing, 
+ * window size is the size in config, cursor is always at 0, the close flag is set by gl_close() only. 
  * @return 1 if success, 0 if fail
  */
 int gl_init(gl_config config) __attribute__((cold));
 
 /** Get the GLFW window object so user program can use GLFW lib to access the window. 
- * @return GLFW window object
+ * @return GLFW window object, NULL with EGL backend
  */
 void* gl_getWindow();
 
@@ -270,6 +296,48 @@ gl_synch_status gl_synchWait(const gl_synch s, const uint64_t timeout);
  */
 void gl_synchDelete(const gl_synch s);
 
+/** Create a GPU timer. 
+ * Timestamp queries are used if supported (GL_EXT_disjoint_timer_query for OpenGL ES, GL_ARB_timer_query for OpenGL): 
+ * nothing is waited, results are read a few frames later when the GPU has finished them. 
+ * Otherwise, fences are used: all fences of a frame are waited in order at the end of the frame, so the CPU is stalled until the GPU finishes the frame. 
+ * @param depth Number of frames in ring, a finished frame is overwritten if not read before depth - 1 newer frames finish
+ * @param stamps Max number of stamps in a frame, extra stamps are ignored
+ * @return GPU timer
+ */
+gl_timer gl_timer_create(const unsigned int depth, const unsigned int stamps);
+
+/** Check a GPU timer is successfully created. 
+ * @param timer A GPU timer previously returned by gl_timer_create()
+ * @return 1 if good, 0 if not
+ */
+int gl_timer_check(const gl_timer* const timer);
+
+/** Record GPU time when all previous commands are finished (a stamp), in the current frame. 
+ * Do nothing if the timer is not created (GL_INIT_DEFAULT_TIMER), so stamps can be left in place when timing is not wanted. 
+ * @param timer A GPU timer previously returned by gl_timer_create()
+ */
+void gl_timer_stamp(gl_timer* const timer);
+
+/** End the current frame and start next frame. Do nothing if the timer is not created. 
+ * @param timer A GPU timer previously returned by gl_timer_create()
+ * @param tag User tag of the current frame (e.g. frame number), returned by gl_timer_read()
+ */
+void gl_timer_frameEnd(gl_timer* const timer, const unsigned int tag);
+
+/** Read the oldest finished frame. 
+ * @param timer A GPU timer previously returned by gl_timer_create()
+ * @param wait 0 to return immediately if the GPU has not finished the frame, non-zero to wait
+ * @param tag Return the user tag of the frame
+ * @param duration Return the GPU time between stamps in ns, (number of stamps - 1) elements
+ * @return Number of stamps of the frame; 0 if result of the frame is not valid (e.g. GPU disjoint); -1 if no frame is ready (nothing returned)
+ */
+int gl_timer_read(gl_timer* const timer, const int wait, unsigned int* const tag, uint64_t* const duration);
+
+/** Delete a GPU timer. 
+ * @param timer A GPU timer previously returned by gl_timer_create()
+ */
+void gl_timer_delete(gl_timer* const timer);
+
 /* == Shader and shader param data types, UBO =============================================== */
 
 /** Set the header of all shader program. 
@@ -280,6 +348,7 @@ void gl_synchDelete(const gl_synch s);
 void gl_program_setCommonHeader(const char* const header);
 
 /** Create a shader program from file or memory. 
+ * Source code is split by tokens "@VS", "@FS", "@GS" (render program) or "@CS" (compute program) at the beginning of a line. 
  * @param src A string representing the program, use "fDIR" (e.g. "f./myshader.glsl") for file, use "mSRC" (e.g. "m@VS\nlayout...") for in-memory code
  * @param args A list of gl_programArg used to return the ID of each param. The last gl_programArg should have a NULL .name to indicate the end of list
  * @return Shader program
@@ -306,6 +375,12 @@ void gl_program_use(const gl_program* const program);
  */
 void gl_program_setParam(const gl_param paramId, const unsigned int length, const gl_datatype type, const void* data);
 
+/** Run the current compute shader program. 
+ * Call gl_program_use() to bind the compute shader program before dispatch. 
+ * @param groups Number of work groups in x, y and z
+ */
+void gl_program_dispatch(const unsigned int groups[static 3]);
+
 /** Delete a shader program, the shader program will be reset to GL_INIT_DEFAULT_SHADER. 
  * @param program A shader program previously returned by gl_program_load()
  */
@@ -345,6 +420,62 @@ void gl_uniformBuffer_update(const gl_ubo* const ubo, const unsigned int start,
  */
 void gl_unifromBuffer_delete(gl_ubo* const ubo);
 
+/** Create a shader storage buffer object (SSBO) and bind it to a binding point. 
+ * SSBO can be written by shader and read by CPU. 
+ * @param bindingPoint Binding point to bind, same as the binding in shader code
+ * @param size Size of memory allocating to the buffer, in bytes
+ * @param usage A hint to the driver about the frequency of usage, can be gl_usage_*
+ * @return SSBO
+ */
+gl_sbo gl_storageBuffer_create(const unsigned int bindingPoint, const unsigned int size, const gl_usage usage);
+
+/** Check a SSBO
+ * @param sbo A SSBO previously returned by gl_storageBuffer_create()
+ * @return 1 if good, 0 if not
+ */
+int gl_storageBuffer_check(const gl_sbo* const sbo);
+
+/** Bind a SSBO to a binding point, use this to switch between multiple SSBOs used by the same shader. 
+ * @param sbo A SSBO previously returned by gl_storageBuffer_create()
+ * @param bindingPoint Binding point to bind
+ */
+void gl_storageBuffer_bind(const gl_sbo* const sbo, const unsigned int bindingPoint);
+
+/** Update a portion of shader storage buffer. 
+ * @param sbo A SSBO previously returned by gl_storageBuffer_create()
+ * @param start Starting offset of the update in bytes
+ * @param len Length of the update in bytes
+ * @param data Pointer to the update data
+ */
+void gl_storageBuffer_update(const gl_sbo* const sbo, const unsigned int start, const unsigned int len, const void* const data);
+
+/** Map a portion of shader storage buffer to user space for reading. 
+ * Shader writes issued before this call are visible. This call blocks until the shader writing this buffer is finished. 
+ * Only one SSBO can be mapped at a time, call gl_storageBuffer_downloadDiscard() to unmap after the data has been processed. 
+ * @param sbo A SSBO previously returned by gl_storageBuffer_create()
+ * @param start Starting offset of the download in bytes
+ * @param len Length of the download in bytes
+ * @return Address of the downloaded data
+ */
+void* gl_storageBuffer_download(const gl_sbo* const sbo, const unsigned int start, const unsigned int len);
+
+/** Discard the pointer returned by gl_storageBuffer_download()
+ */
+void gl_storageBuffer_downloadDiscard();
+
+/** Resize a SSBO, old content is discarded. 
+ * The buffer object is the same, so its binding point is kept. 
+ * @param sbo A SSBO previously returned by gl_storageBuffer_create()
+ * @param size New size of the buffer, in bytes
+ * @param usage A hint to the driver about the frequency of usage, can be gl_usage_*
+ */
+void gl_storageBuffer_resize(const gl_sbo* const sbo, const unsigned int size, const gl_usage usage);
+
+/** Delete a SSBO. 
+ * @param sbo A SSBO previously created by gl_storageBuffer_create()
+ */
+void gl_storageBuffer_delete(gl_sbo* const sbo);
+
 /* == Mesh (vertices) ======================================================================= */
 
 /** Create and bind gl_mesh object. 
@@ -397,6 +528,13 @@ void gl_mesh_updateIndices(const gl_mesh* const mesh, const gl_index_t* const in
  */
 void gl_mesh_updateInstances(const gl_mesh* const mesh, const gl_vertex_t* const instances, const unsigned int start, const unsigned int len);
 
+/** Resize a mesh's instances array (IBO inside mesh), old content is discarded. 
+ * Meshes sharing the instance buffer of this mesh see the new size as well. 
+ * @param mesh  A mesh previously returned by gl_mesh_create()
+ * @param len New size of the instances array (in unit of gl_vertex_t)
+ */
+void gl_mesh_resizeInstances(const gl_mesh* const mesh, const unsigned int len);
+
 /** Draw a mesh once or for a few times. 
  * If the mesh is created with instance, that instance will be used; if without instance, only draw the mesh once.
  * @param mesh A mesh previously returned by gl_mesh_create()
@@ -450,6 +588,18 @@ void gl_texture_update(const gl_tex* const tex, const void* const data, const un
  */
 void gl_texture_bind(const gl_tex* const tex, const gl_param paramId, const unsigned int unit);
 
+/** Bind a texture to OpenGL engine image unit, for compute shader to write (writeonly image). 
+ * Only 2D texture, level 0. ES 3.1 image supports X8 in RGBA8 only (no R8 or RG8). 
+ * @param tex A texture previously returned by gl_texture_create()
+ * @param unit An image unit, same as the binding in the shader
+ */
+void gl_texture_bindImage(const gl_tex* const tex, const unsigned int unit);
+
+/** Make image writes of previous compute shaders visible to later texture fetch, framebuffer and texture download. 
+ * Call after gl_program_dispatch() and before using the written texture. 
+ */
+void gl_texture_syncImage();
+
 /** Delete a texture. 
  * @param tex A texture previously returned by gl_texture_create()
  */
@@ -489,6 +639,7 @@ int gl_frameBuffer_check(const gl_fbo* const fbo);
 void gl_frameBuffer_bind(const gl_fbo* const fbo, const int clear);
 
 /** Download a portion of fram buffer from GPU. 
+ * This is allowed while PBO downloads are in progress or mapped, the PBO binding is kept. 
  * @param fbo A FBO previously created by gl_frameBuffer_create()
  * @param dest Where to save the data, the memory space should be enough to hold the download content
  * @param format Format of data downloading
@@ -533,7 +684,7 @@ void gl_pixelBuffer_updateFinish();
 void gl_pixelBuffer_updateToTexture(const gl_pbo* const pbo, const gl_tex* const tex);
 
 /** Start a GPU-to-CPU transfer, download texture of an framebuffer to PBO. 
- * No other download operation is allowed between gl_pixelBuffer_downloadStart()-gl_pixelBuffer_downloadFinish()-gl_pixelBuffer_downloadDiscard() calls. 
+ * Multiple downloads can be in progress at the same time using different PBOs. 
  * @param pbo A PBO previously returned by gl_pixelBuffer_create()
  * @param fbo A FBO previously returned by gl_frameBuffer_create()
  * @param format Format of data downloading
@@ -543,18 +694,20 @@ void gl_pixelBuffer_updateToTexture(const gl_pbo* const pbo, const gl_tex* const
  */
 void gl_pixelBuffer_downloadStart(const gl_pbo* pbo, const gl_fbo* const fbo, const gl_texformat format, const unsigned int attachment, const unsigned int offset[static 2], const unsigned int size[static 2]);
 
-/** Obtain the data address after finishing the data transfer started by gl_pixelBuffer_updateStart(). 
- * A synch object can be used to test if the download has been finished. 
+/** Obtain the data address after finishing the data transfer started by gl_pixelBuffer_downloadStart(). 
+ * A synch object set after gl_pixelBuffer_downloadStart() can be used to test if the download has been finished, this call stalls if not. 
  * This function will map the internal buffer to user space, call gl_pixelBuffer_downloadDiscard() to unmap after the data has been processed. 
+ * Multiple PBOs can be mapped at the same time, the address is valid (and can be read by other threads) until discarded; a mapped PBO cannot be used for new download. 
  * @param pbo A PBO previously returned by gl_pixelBuffer_create()
  * @param size Size of the PBO/texture data in bytes
  * @return Address of the downloaded data
  */
-void* gl_pixelBuffer_downloadFinish(const unsigned int size);
+void* gl_pixelBuffer_downloadFinish(const gl_pbo* pbo, const unsigned int size);
 
 /** Discard the pointer returned by gl_pixelBuffer_downloadFinish()
+ * @param pbo A PBO previously mapped by gl_pixelBuffer_downloadFinish()
  */
-void gl_pixelBuffer_downloadDiscard();
+void gl_pixelBuffer_downloadDiscard(const gl_pbo* pbo);
 
 /** Delete a PBO. 
  * @param pbo A PBO previously returned by gl_pixelBuffer_create()
@@ -7,6 +7,8 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <signal.h>
+#include <sched.h>
+#include <limits.h>
 
 #include <GL/glew.h>
 #include <GL/glfw3.h>
@@ -17,27 +19,79 @@
 #include "speedometer.h"
 #include "th_reader.h"
 #include "th_output.h"
-
-/* Program config */
-#define MAX_SPEED 200 //km/h
+#include "th_event.h"
+#include "th_analysis.h"
+#include "config.h"
+#include "benchmark.h"
+#include "cpu.h"
+
+/* Program config, names in [] can be changed in config file at runtime (see config.h) */
+#define MAX_SPEED 200 //km/h [maxSpeed]
 #define GL_SYNCH_TIMEOUT 5000000000LLU //For gl sync timeout
+#define BENCHMARK_WARMUP 10 //Benchmark mode: default number of frames at start excluded from the report (--warmup)
+#define BENCHMARK_CSV "benchmark.csv" //Benchmark mode: time of each step of every frame
+#define BACKEND 0 //[backend] 0 to process on GPU (OpenGL ES); 1 on CPU (reference of the shaders, same speed map, see cpu.h); 2 on both and compare the speed map of every frame (check, output is from GPU)
+#define CPU_THREADS 0 //[cpuThreads] CPU backend: number of threads, 0 for number of CPUs
 
-/* Shader config */
-//#define HEADLESS
+/* Shader config, macros of a shader can be changed in config file as "shaderName.MACRO = value" */
+#define HEADLESS 0 //[headless] 1 to disable display, no window: render off-screen with EGL surfaceless context, works without window system (X11) and GPU
 #define SHADER_DIR "fshader/"
-#define SHADER_MEASURE_INTERLACE 3 //Must be 2^n - 1 (1, 3, 7, 15...), this create a 2^n level queue
-#define SHADER_SPEED_DOWNLOADLATENCY 1 //Must be 2^n - 1 (1, 3, 7, 15...), this create a 2^n level queue. Higher number means higher chance the FBO is ready when download, lower stall but higher latency as well
-#define SHADER_SPEEDOMETER_CNT 32 //Max number of speedometer
+#define SHADER_DENOISE 0 //[denoise] 0 to denoise the video by 3*3 spatial blur (blurFilter); 1 by temporal moving average (temporalFilter), a px follows the frame when it moves, cheaper and better for still camera, see temporalFilter.glsl; GPU, CPU and check backends
+#define SHADER_FUSED_EDGE 0 //[fusedEdge] 1 to run changing sensor, object fix and edge refine in one compute shader (fusedEdge, a work group a tile), intermediate results are kept in shared memory instead of written to and read from textures between passes; GPU and check backends
+#define SHADER_FUSED_WINDOW 256 //Tile and halo of fusedEdge in px, same as WINDOW in the shader
+#define SHADER_EDGEREFINE_SCAN 0 //[edgeRefineScan] 1 to refine edge by a lookup of walk lengths found by a compute shader (edgeRefineScan, a tile an invocation) instead of search loops, the cost of a tile does not depend on the pixel width; GPU and check backends
+#define SHADER_OBJECTFIX_SCAN 0 //[objectFixScan] 1 to fix object by a lookup of the nearest blocks found by a compute shader (objectFixScan, a work group a line) instead of search loops, the cost does not depend on the pixel width; GPU and check backends
+#define SHADER_OBJECTFIX_LINE 4096 //Max width and height of ROI box for object fix by scan, a word of 32px an invocation, 128 invocations is the minimum of ES 3.1; larger use the search loops of objectFix
+#define SHADER_EDGEREFINE_WINDOW 256 //Tile and halo of edgeRefineScan in px, same as WINDOW in the shader; larger halo uses the search loops of edgeRefine
+#define SHADER_EDGEREFINE_TILES 8 //Tiles (in a row) of an edgeRefineScan work group, same as local size in the shader
+#define SHADER_EDGEREFINE_LAYERS 16 //Texels of a word (32 rows) in edgeRefineScan result, same as LAYERS in the shaders
+#define SHADER_REGION_MARGIN 2 //Margin in px of focus region (mesh_perspMargin) for passes whose result is read around the focus region, e.g. by a 3*3 kernel
+#define SHADER_MEASURE_INTERLACE 3 //[measureInterlace] Must be 2^n - 1 (1, 3, 7, 15...), this create a 2^n level queue
+#define SHADER_SPEED_DOWNLOADLATENCY 1 //[speedDownloadLatency] Must be 2^n - 1 (1, 3, 7, 15...), this create a 2^n level queue. Higher number means higher chance the FBO is ready when download, lower stall but higher latency as well. Also number of frames in flight - 1, each frame in flight has its own intermediate buffers, use 3 or 7 for offline reprocessing
+#define LOW_LATENCY 0 //[lowLatency] 1 to read back the speed map of the current frame as soon as GPU finishes it (polling), instead of the previous frame in next frame. One frame less latency, but the main thread waits for GPU every frame
+#define SHADER_QUEUE_MAX 16 //Size of object and speed map queues, interlace and download latency must be less than this, must be 2^n
+#define SHADER_SPEEDOMETER_CNT 32 //[speedometerCnt] Init number of speedometer (objects in a frame), grows when needed
+
+/* Output */
+#define OUTPUT_MODE output_mode_track //[outputMode] Bit mask, output_mode_raw (1) for every sample, output_mode_track (2) for one summary per vehicle, 3 for both
+#define TRACK_GATE_X 1.5 //[trackGateX] Max lateral displacement (m) of a sample to its track, about half of lane width
+#define TRACK_TIMEOUT 5 //[trackTimeout] Close a track if it is not updated for this number of frames
+#define TRACK_MIN_COUNT 3 //[trackMinCount] Track with less samples is considered as noise
+#define ROLLUP_FILE NULL //[rollupFile] Append per-lane per-interval statistics to this file (e.g. "./rollup.data"), NULL to disable
+#define ROLLUP_INTERVAL 60 //[rollupInterval] Length of interval in second
+#define LANE_ORIGIN -7.0 //[laneOrigin] Road-domain x-coord (m) of the left side of the first lane
+#define LANE_WIDTH 3.5 //[laneWidth] Width of lane (m)
+#define LANE_CNT 6 //[laneCnt] Number of lanes
+#define ARCHIVE_FILE NULL //[archiveFile] Append every sample to columnar archive <ARCHIVE_FILE>.col and .idx (e.g. "./archive"), NULL to disable
+#define EVENT_SPEED 0 //[eventSpeed] km/h, write frames around the first sample of a vehicle at or above this speed, 0 to disable
+#define EVENT_PRE 10 //[eventPre] Number of frames before the trigger frame to write
+#define EVENT_POST 10 //[eventPost] Number of frames after the trigger frame to write
+#define EVENT_RING 32 //[eventRing] Number of frames kept in memory, must be greater than EVENT_PRE + EVENT_POST plus the frames in the pipeline (checked at start)
+#define EVENT_DIR "." //[eventDir] Directory to write event files
+#define EVENT_FRAME_OFFSET 2 //Frame read in loop i, uploaded in loop i+1, processed in loop i+2
 
 /* Speedometer */
 #define SPEEDOMETER_FILE "./textmap.data"
 
 /* Video data upload to GPU and processed data download to CPU */
-//#define USE_PBO_UPLOAD //Not big gain: uploading is asynch op, driver will copy data to internal buffer and then upload
-#define USE_PBO_DOWNLOAD //Big gain: download is synch op
+#define USE_PBO_UPLOAD 0 //[pboUpload] Not big gain: uploading is asynch op, driver will copy data to internal buffer and then upload
+#define USE_PBO_DOWNLOAD 1 //[pboDownload] Big gain: download is synch op
+#define PBO_DOWNLOAD_DEPTH 2 //[pboDownloadDepth] Number of PBOs in download ring, a PBO is mapped only if GPU has finished it, so GPU can be late for (depth - 1) frames before the main thread stalls; 1 to always wait
+#define USE_GPU_COMPACT 1 //[compact] Big gain: 1 to compact non-zero samples of speed map on GPU (compute shader), download the sample list only instead of the entire speed map, overrides USE_PBO_DOWNLOAD; 0 to download the speed map and scan it on CPU (e.g. the driver has no compute shader)
+#define COMPACT_CAPACITY 4096 //[compactCapacity] Init number of non-zero samples in the compact list of a frame, grows when a frame has more (that frame is compacted again)
+#define SBO_COMPACT 0 //Binding point of compact sample list, same as in compact shader
+#define USE_ROW_OCCUPANCY //Scan path only: mark rows (in spans) having non-zero samples on GPU, skip empty rows when scanning the speed map on CPU
+#define OCCUPANCY_SPAN 4 //Number of spans per row in occupancy map, same as in occupancy shader
+#define ANALYSIS_QUEUE 2 //[analysisQueue] Number of downloaded frames the analysis thread can hold, number of CPU-side download buffers if PBO ring is not used
+#define ANALYSIS_QUEUE_MAX 16 //Size of CPU-side download buffer arrays, analysis queue must not be greater than this
+#define SPEEDMAP_DUMP NULL //[speedmapDump] Scan path only: append every downloaded speed map (ROI only, size is logged at start) to this file (e.g. "./speedmap.data") for devtool/scanbench, NULL to disable
 
 #define TEXUNIT_ROADMAP 15 //Reserve binding point for reference texture data to reduce texture re-binding
 #define TEXUNIT_SPEEDOLMETER 14
+#define TEXUNIT_FOCUS 13
+#define IMAGE_EDGE 0 //Image unit of fusedEdge result, same as in fusedEdge shader
+#define IMAGE_GAP 1 //Image unit of objectFixScan result, same as in objectFixScan shader
+#define IMAGE_RUN 2 //Image unit of edgeRefineScan result, same as in edgeRefineScan shader
 
 #define info(format, ...) {fprintf(stderr, "Log:\t"format"\n" __VA_OPT__(,) __VA_ARGS__);} //Write log
 #define error(format, ...) {fprintf(stderr, "Err:\t"format"\n" __VA_OPT__(,) __VA_ARGS__);} //Write error log
@@ -52,12 +106,70 @@ int main(int argc, char* argv[]) {
 	const char* color; //Input video color scheme
 	unsigned int fps; //Input video FPS
 	const char* roadmapFile; //File dir - roadmap file (binary)
+	const char* configFile; //File dir - config file (text), NULL to use compile-time config
+	Config config = NULL; //Kept until all shaders are loaded
+	struct {
+		float maxSpeed; //km/h
+		unsigned int measureInterlace; //2^n - 1
+		unsigned int speedDownloadLatency; //2^n - 1
+		unsigned int lowLatency;
+		unsigned int speedometerCnt;
+		unsigned int compactCapacity;
+		unsigned int headless;
+		unsigned int pboUpload, pboDownload, pboDownloadDepth;
+		unsigned int compact;
+		enum {backend_gpu, backend_cpu, backend_check} backend;
+		unsigned int cpuThreads;
+		unsigned int fusedEdge;
+		unsigned int objectFixScan;
+		unsigned int edgeRefineScan;
+		unsigned int denoise;
+		unsigned int analysisQueue;
+		const char* speedmapDump; //NULL to disable
+		output_mode outputMode;
+		float trackGateX; //m
+		unsigned int trackTimeout, trackMinCount;
+		const char* rollupFile; //NULL to disable
+		unsigned int rollupInterval; //s
+		float laneOrigin, laneWidth; //m
+		unsigned int laneCnt;
+		const char* archiveFile; //NULL to disable
+		unsigned int eventSpeed; //km/h, 0 to disable
+		unsigned int eventPre, eventPost, eventRing;
+		const char* eventDir;
+	} cfg; //Runtime config, strings are kept in config until all shaders are loaded
+	struct {
+		int enable; //Benchmark mode: record time of each step, report and quit after the measured frames
+		unsigned int frames; //Number of frames to measure, 0 for the entire input
+		unsigned int warmup; //Number of frames at start excluded from the report
+		const char* json; //Write report to this file as JSON, NULL to disable
+	} benchmarkArg = {.enable = 0, .frames = 0, .warmup = BENCHMARK_WARMUP, .json = NULL};
 
 	/* Program argument check */ {
-		if (argc != 6) {
-			error("Bad arg: Use 'this width height fps color roadmapFile'");
+		int badArg = argc < 6;
+		configFile = NULL;
+		for (int i = 6; i < argc && !badArg; i++) {
+			if (!strcmp(argv[i], "--benchmark") && i + 1 < argc) {
+				benchmarkArg.enable = 1;
+				benchmarkArg.frames = atoi(argv[++i]);
+			} else if (!strcmp(argv[i], "--warmup") && i + 1 < argc) {
+				benchmarkArg.warmup = atoi(argv[++i]);
+			} else if (!strcmp(argv[i], "--json") && i + 1 < argc) {
+				benchmarkArg.json = argv[++i];
+			} else if (argv[i][0] != '-' && !configFile) {
+				configFile = argv[i];
+			} else {
+				badArg = 1;
+			}
+		}
+		if (badArg) {
+			error("Bad arg: Use 'this width height fps color roadmapFile [configFile] [--benchmark N [--warmup W] [--json file]]'");
 			error("\twhere color = ncccc (n is number of channel input, cccc is the order of RGB[A])");
 			error("\troadmappFile = Directory to a binary coded file contains road-domain data");
+			error("\tconfigFile = Directory to a text file contains \"name = value\" lines to change program and shader config");
+			error("\t--benchmark N = Process W + N frames (N = 0 for the entire input) as fast as possible then quit, report p50/p95/p99/max time of each step and FPS of the last N frames");
+			error("\t--warmup W = Number of frames at start excluded from the report, default %u", BENCHMARK_WARMUP);
+			error("\t--json file = Also write the report to this file as JSON");
 			return status;
 		}
 		sizeData[0] = atoi(argv[1]);
@@ -69,6 +181,9 @@ int main(int argc, char* argv[]) {
 		info("\tWidth: %upx, Height: %upx, Total: %usqpx", sizeData[0], sizeData[1], sizeData[0] * sizeData[1]);
 		info("\tFPS: %u, Color: %s", fps, color);
 		info("\tRoadmap: %s", roadmapFile);
+		info("\tConfig: %s", configFile ? configFile : "(default)");
+		if (benchmarkArg.enable)
+			info("\tBenchmark: %u frames after %u warm-up frames", benchmarkArg.frames, benchmarkArg.warmup);
 
 		if (sizeData[0] & (unsigned int)0b111 || sizeData[0] < 320 || sizeData[0] > 2048) {
 			error("Bad width: Width must be multiple of 8, 320 <= width <= 2048");
@@ -92,38 +207,197 @@ int main(int argc, char* argv[]) {
 				return status;
 			}
 		}
+
+		char* statue;
+		config = config_init(configFile, &statue);
+		if (!config) {
+			error("Cannot load config: %s", statue);
+			return status;
+		}
+		cfg.maxSpeed = config_getFloat(config, "maxSpeed", MAX_SPEED);
+		cfg.measureInterlace = config_getUint(config, "measureInterlace", SHADER_MEASURE_INTERLACE);
+		cfg.speedDownloadLatency = config_getUint(config, "speedDownloadLatency", SHADER_SPEED_DOWNLOADLATENCY);
+		cfg.lowLatency = config_getUint(config, "lowLatency", LOW_LATENCY);
+		cfg.speedometerCnt = config_getUint(config, "speedometerCnt", SHADER_SPEEDOMETER_CNT);
+		cfg.compactCapacity = config_getUint(config, "compactCapacity", COMPACT_CAPACITY);
+		cfg.headless = config_getUint(config, "headless", HEADLESS);
+		cfg.pboUpload = config_getUint(config, "pboUpload", USE_PBO_UPLOAD);
+		cfg.pboDownload = config_getUint(config, "pboDownload", USE_PBO_DOWNLOAD);
+		cfg.pboDownloadDepth = config_getUint(config, "pboDownloadDepth", PBO_DOWNLOAD_DEPTH);
+		cfg.compact = config_getUint(config, "compact", USE_GPU_COMPACT);
+		cfg.backend = config_getUint(config, "backend", BACKEND);
+		cfg.cpuThreads = config_getUint(config, "cpuThreads", CPU_THREADS);
+		cfg.fusedEdge = config_getUint(config, "fusedEdge", SHADER_FUSED_EDGE);
+		cfg.objectFixScan = config_getUint(config, "objectFixScan", SHADER_OBJECTFIX_SCAN);
+		cfg.edgeRefineScan = config_getUint(config, "edgeRefineScan", SHADER_EDGEREFINE_SCAN);
+		cfg.denoise = config_getUint(config, "denoise", SHADER_DENOISE);
+		cfg.analysisQueue = config_getUint(config, "analysisQueue", ANALYSIS_QUEUE);
+		cfg.speedmapDump = config_getString(config, "speedmapDump", SPEEDMAP_DUMP);
+		cfg.outputMode = config_getUint(config, "outputMode", OUTPUT_MODE);
+		cfg.trackGateX = config_getFloat(config, "trackGateX", TRACK_GATE_X);
+		cfg.trackTimeout = config_getUint(config, "trackTimeout", TRACK_TIMEOUT);
+		cfg.trackMinCount = config_getUint(config, "trackMinCount", TRACK_MIN_COUNT);
+		cfg.rollupFile = config_getString(config, "rollupFile", ROLLUP_FILE);
+		cfg.rollupInterval = config_getUint(config, "rollupInterval", ROLLUP_INTERVAL);
+		cfg.laneOrigin = config_getFloat(config, "laneOrigin", LANE_ORIGIN);
+		cfg.laneWidth = config_getFloat(config, "laneWidth", LANE_WIDTH);
+		cfg.laneCnt = config_getUint(config, "laneCnt", LANE_CNT);
+		cfg.archiveFile = config_getString(config, "archiveFile", ARCHIVE_FILE);
+		cfg.eventSpeed = config_getUint(config, "eventSpeed", EVENT_SPEED);
+		cfg.eventPre = config_getUint(config, "eventPre", EVENT_PRE);
+		cfg.eventPost = config_getUint(config, "eventPost", EVENT_POST);
+		cfg.eventRing = config_getUint(config, "eventRing", EVENT_RING);
+		cfg.eventDir = config_getString(config, "eventDir", EVENT_DIR);
+		if (cfg.backend == backend_cpu) //CPU backend writes the speed map to memory, nothing to compact on GPU
+			cfg.compact = 0;
+		if (cfg.compact) {
+			if (config_getUint(config, "pboDownload", 0)) //Set in config file, not the compile-time default
+				info("\tPBO download is ignored with compact = 1, the compact list is downloaded once its fence is passed; set compact = 0 to download by the PBO ring");
+			cfg.pboDownload = 0;
+		}
+		if (cfg.backend != backend_gpu) //CPU backend reads the frame from memory and writes the speed map to memory
+			cfg.pboUpload = cfg.pboDownload = 0;
+		info("\tMax speed: %.1fkm/h, Interlace: %u, Download latency: %u, Low latency: %u, Headless: %u", cfg.maxSpeed, cfg.measureInterlace, cfg.speedDownloadLatency, cfg.lowLatency, cfg.headless);
+		info("\tPBO upload: %u, PBO download: %u (depth %u), Compact: %u", cfg.pboUpload, cfg.pboDownload, cfg.pboDownloadDepth, cfg.compact);
+		info("\tBackend: %s", cfg.backend == backend_gpu ? "GPU" : cfg.backend == backend_cpu ? "CPU" : "GPU, check with CPU");
+		if (cfg.backend == backend_cpu) //CPU backend does not run the GL passes
+			cfg.fusedEdge = cfg.objectFixScan = cfg.edgeRefineScan = 0;
+		info("\tFused edge: %u, Object fix scan: %u, Edge refine scan: %u", cfg.fusedEdge, cfg.objectFixScan, cfg.edgeRefineScan);
+		info("\tDenoise: %s", cfg.denoise ? "temporal" : "spatial");
+		info("\tAnalysis queue: %u, Speed map dump: %s", cfg.analysisQueue, cfg.speedmapDump ? cfg.speedmapDump : "(none)");
+		info("\tOutput mode: %u, Track gate: %.2fm, Track timeout: %u, Track min count: %u", cfg.outputMode, cfg.trackGateX, cfg.trackTimeout, cfg.trackMinCount);
+		info("\tRollup: %s (%us), Lanes: %u * %.2fm from %.2fm, Archive: %s", cfg.rollupFile ? cfg.rollupFile : "(none)", cfg.rollupInterval, cfg.laneCnt, cfg.laneWidth, cfg.laneOrigin, cfg.archiveFile ? cfg.archiveFile : "(none)");
+		if (cfg.eventSpeed)
+			info("\tEvent: %ukm/h, %u frames before and %u after, Ring: %u, Dir: %s", cfg.eventSpeed, cfg.eventPre, cfg.eventPost, cfg.eventRing, cfg.eventDir);
+
+		if (cfg.maxSpeed <= 0) {
+			error("Bad config: maxSpeed must be greater than 0");
+			config_destroy(config);
+			return status;
+		}
+		if (!cfg.measureInterlace || cfg.measureInterlace & (cfg.measureInterlace + 1) || cfg.measureInterlace >= SHADER_QUEUE_MAX) {
+			error("Bad config: measureInterlace must be 2^n - 1 and less than %u", SHADER_QUEUE_MAX);
+			config_destroy(config);
+			return status;
+		}
+		if (!cfg.speedDownloadLatency || cfg.speedDownloadLatency & (cfg.speedDownloadLatency + 1) || cfg.speedDownloadLatency >= SHADER_QUEUE_MAX) {
+			error("Bad config: speedDownloadLatency must be 2^n - 1 and less than %u", SHADER_QUEUE_MAX);
+			config_destroy(config);
+			return status;
+		}
+		if (!cfg.speedometerCnt || !cfg.compactCapacity || !cfg.pboDownloadDepth) {
+			error("Bad config: speedometerCnt, compactCapacity and pboDownloadDepth must be greater than 0");
+			config_destroy(config);
+			return status;
+		}
+		if (cfg.denoise > 1) {
+			error("Bad config: denoise must be 0 (spatial) or 1 (temporal)");
+			config_destroy(config);
+			return status;
+		}
+		if (cfg.backend > backend_check) {
+			error("Bad config: backend must be 0 (GPU), 1 (CPU) or 2 (check)");
+			config_destroy(config);
+			return status;
+		}
+		if (!cfg.analysisQueue || cfg.analysisQueue > ANALYSIS_QUEUE_MAX) {
+			error("Bad config: analysisQueue must be greater than 0 and not greater than %u", ANALYSIS_QUEUE_MAX);
+			config_destroy(config);
+			return status;
+		}
+		if (!cfg.outputMode || cfg.outputMode > (output_mode_raw | output_mode_track)) {
+			error("Bad config: outputMode must be 1 (raw), 2 (track) or 3 (both)");
+			config_destroy(config);
+			return status;
+		}
+		if (cfg.trackGateX <= 0 || !cfg.trackTimeout) {
+			error("Bad config: trackGateX and trackTimeout must be greater than 0");
+			config_destroy(config);
+			return status;
+		}
+		if (cfg.rollupFile && (!cfg.rollupInterval || !cfg.laneCnt || cfg.laneWidth <= 0)) {
+			error("Bad config: rollupInterval, laneCnt and laneWidth must be greater than 0");
+			config_destroy(config);
+			return status;
+		}
+		if (cfg.eventSpeed > INT16_MAX) {
+			error("Bad config: eventSpeed must not be greater than %d", INT16_MAX);
+			config_destroy(config);
+			return status;
+		}
+		unsigned int eventLatency = EVENT_FRAME_OFFSET + (cfg.lowLatency ? 0 : cfg.speedDownloadLatency) + (cfg.pboDownload ? cfg.pboDownloadDepth : cfg.analysisQueue); //Frames the reader is ahead of output: upload, frames in flight on GPU, downloads queued for analysis; they enter the ring while the pre frames of a trigger must stay in it
+		if (cfg.eventSpeed && cfg.eventRing <= cfg.eventPre + cfg.eventPost + eventLatency) {
+			error("Bad config: eventRing (%u) must be greater than eventPre + eventPost + %u frames in the pipeline (%u)", cfg.eventRing, eventLatency, cfg.eventPre + cfg.eventPost + eventLatency);
+			config_destroy(config);
+			return status;
+		}
 	}
 
 	/* Program variables declaration */
 
 	//PBO or memory space for orginal video raw data uploading, and textures to store orginal video data
-	#ifdef USE_PBO_UPLOAD
-		gl_pbo pboUpload[2] = {GL_INIT_DEFAULT_PBO, GL_INIT_DEFAULT_PBO};
-	#else
-		void* rawData[2] = {NULL, NULL};
-	#endif
+	gl_pbo pboUpload[2] = {GL_INIT_DEFAULT_PBO, GL_INIT_DEFAULT_PBO}; //If pboUpload
+	void* rawData[2] = {NULL, NULL}; //If not pboUpload
 	gl_tex texture_orginalBuffer[2] = {GL_INIT_DEFAULT_TEX, GL_INIT_DEFAULT_TEX}; //Front texture for using, back texture up updating
 
 	//Roadinfo, a mesh to store region of interest, and texture to store road-domain data
 	roadmap roadmap = ROADMAP_DEFAULTSTRUCT;
 	gl_mesh mesh_persp = GL_INIT_DEFAULT_MESH;
 	gl_mesh mesh_ortho = GL_INIT_DEFAULT_MESH;
+	gl_mesh mesh_perspMargin = GL_INIT_DEFAULT_MESH; //mesh_persp dilated by SHADER_REGION_MARGIN px
 	gl_tex texture_roadmap = GL_INIT_DEFAULT_TEX; //2D array texture: 1 - Geo coord in persp and ortho views; 2 - Up and down search limit, P2O and O2P project lookup
 	struct {
 		float left, right, top, bottom;
 	} road_boxROI;
+	struct {
+		unsigned int offset[2], size[2];
+	} road_boxROIpx; //Box of interest in px: {left, top} and {width, height}, width is even so a row of RG8 is 4-byte aligned
+	gl_tex texture_gap[2] = {GL_INIT_DEFAULT_TEX, GL_INIT_DEFAULT_TEX}; //If object fix by scan, steps to the nearest block forward (low 16 bits) and backward (high 16 bits) of each px, R32UI, horizontal and vertical
+	gl_tex texture_run = GL_INIT_DEFAULT_TEX; //If edge refine by scan, bit-sliced walk length to the left and right and object px, a word of 32 rows in SHADER_EDGEREFINE_LAYERS texels, R32UI
+	gl_tex texture_focus = GL_INIT_DEFAULT_TEX; //If fusedEdge, focus region (perspective mesh) rasterized on CPU, RGBA8 (4-byte aligned rows for upload), non-zero if covered
 
 	//To display human readable text on screen
 	gl_tex texture_speedometer = GL_INIT_DEFAULT_TEX; //Glyph
 	float* instance_speedometer_data = NULL; //Speed data to be draw (sx, sy, speed)
 	gl_mesh mesh_display = GL_INIT_DEFAULT_MESH;
-
-	//Analysis and export data (CPU side)
-	uint8_t (* speedData)[sizeData[0]][2] = NULL; //FBO download, height(sizeData[1]) * width(sizeData[0]) * RG8. Note: no performance difference between RGBA8 and RG8 on VC6
-	#ifdef USE_PBO_DOWNLOAD
-		gl_synch pboDownloadSynch = NULL;
-		gl_pbo pboDownload = GL_INIT_DEFAULT_PBO;
+	unsigned int instance_speedometer_cap = cfg.speedometerCnt; //Size of instance_speedometer_data in number of speedometer, grows when needed
+	unsigned int mesh_displayCap = cfg.speedometerCnt; //Size of instance buffer of mesh_display, grows with instance_speedometer_data
+
+	//Analysis and export data (CPU side), downloaded data is handed to analysis thread. Note: no performance difference between RGBA8 and RG8 on VC6
+	gl_sbo sboCompact[SHADER_QUEUE_MAX] = {[0 ... SHADER_QUEUE_MAX - 1] = GL_INIT_DEFAULT_SBO}; //If compact, non-zero samples of speed map, same queue as fb_speed
+	unsigned int sboCompactCap[SHADER_QUEUE_MAX] = {0}; //Size of list in sboCompact in number of samples, grows to compactCap before the compact shader writes it
+	uint32_t (* compactData[ANALYSIS_QUEUE_MAX])[2] = {[0 ... ANALYSIS_QUEUE_MAX - 1] = NULL}; //Download, (x | y << 16, speed | screenDy << 8), one per analysis job
+	unsigned int compactDataCap[ANALYSIS_QUEUE_MAX] = {0}; //Size of compactData in number of samples, grows when a frame has more
+	unsigned int compactCap = cfg.compactCapacity; //Size of list of the next frames in number of samples, doubled when a frame has more, so the lists grow with the busiest frame
+	gl_synch compactSynch[SHADER_QUEUE_MAX] = {[0 ... SHADER_QUEUE_MAX - 1] = NULL}; //Set after compact of the frame, NULL if not in flight
+	unsigned int compactStall = 0; //Number of times the main thread waits for GPU because the list of the oldest frame in flight is not ready
+	unsigned int compactOverflow = 0; //Number of frames having more samples than the list capacity, these frames are compacted again into a larger list
+	struct PboDownload {
+		gl_pbo speed; //Speed map
+		#ifdef USE_ROW_OCCUPANCY
+			gl_pbo occupancy; //Row occupancy map
+		#endif
+		gl_synch synch; //Set after download start, NULL if not in use
+		unsigned int frame; //Frame number of the data
+		uint64_t arrival; //Time the frame was read from input
+	}* pboDownload = NULL; //Ring of downloads, if not compact and pboDownload
+	unsigned int pboDownloadDepth = cfg.pboDownloadDepth, pboDownloadTail = 0, pboDownloadCnt = 0; //Oldest download at tail
+	unsigned int pboDownloadMapped = 0; //Number of downloads (from tail) mapped and handed to analysis thread
+	unsigned int pboDownloadStall = 0; //Number of times the main thread waits for GPU because the ring is full
+	uint8_t (* speedData[ANALYSIS_QUEUE_MAX])[2] = {[0 ... ANALYSIS_QUEUE_MAX - 1] = NULL}; //If not compact and not pboDownload, FBO download, ROI only, height(road_boxROIpx.size[1]) * width(road_boxROIpx.size[0]) * RG8, one per analysis job
+	#ifdef USE_ROW_OCCUPANCY
+		uint8_t (* occupancyData[ANALYSIS_QUEUE_MAX])[OCCUPANCY_SPAN] = {[0 ... ANALYSIS_QUEUE_MAX - 1] = NULL}; //FBO download, ROI only, height(road_boxROIpx.size[1]) * OCCUPANCY_SPAN * R8, non-zero if the span of the row has sample
 	#endif
+	FILE* speedmapDump = NULL; //If not compact
+	unsigned int analysisBufferNext = 0, analysisBufferCnt = 0; //If not pboDownload, next CPU-side buffer to download to, number of buffers in use by analysis thread
+
+	//CPU backend: all passes on CPU, speed map is copied to CPU-side buffers for analysis thread; in check mode, compared with GPU speed map
+	Cpu cpu = NULL; //NULL if GPU backend
+	uint8_t (* cpuSpeedData[ANALYSIS_QUEUE_MAX])[2] = {[0 ... ANALYSIS_QUEUE_MAX - 1] = NULL}; //If CPU backend, ROI of speed map, one per analysis job
+	uint8_t (* cpuCheckData[2])[2] = {NULL, NULL}; //If check, ROI of speed map of GPU and CPU
+	uint64_t cpuTimeTotal[cpu_pass_cnt] = {0}; //Sum of time of each pass
+	unsigned int cpuFrameCnt = 0; //Number of frames processed by CPU
+	unsigned int cpuCheckCnt = 0, cpuCheckFrame = 0, cpuCheckPixel = 0; //If check, number of frames compared, frames and pixels differ
 
 	//Final display on screen
 	gl_mesh mesh_final = GL_INIT_DEFAULT_MESH;
@@ -138,30 +412,75 @@ int main(int argc, char* argv[]) {
 	fb fb_raw[2] = { //Raw video data with minor pre-process
 		[0 ... 1] = {GL_INIT_DEFAULT_FBO, GL_INIT_DEFAULT_TEX, gl_texformat_RGBA8} //Input video, RGBA8
 	};
-	fb fb_object[SHADER_MEASURE_INTERLACE + 1] = { //Object detection of current and previous frames
-		[0 ... SHADER_MEASURE_INTERLACE] = {GL_INIT_DEFAULT_FBO, GL_INIT_DEFAULT_TEX, gl_texformat_R8} //Enum < 256
+	fb fb_object[SHADER_QUEUE_MAX] = { //Object detection of current and previous frames, measureInterlace + 1 in use
+		[0 ... SHADER_QUEUE_MAX - 1] = {GL_INIT_DEFAULT_FBO, GL_INIT_DEFAULT_TEX, gl_texformat_R8} //Enum < 256
+	};
+	fb fb_speed[SHADER_QUEUE_MAX] = { //Speed measure result, road-domain speed in km/h and screen-domain speed in px/frame, speedDownloadLatency + 1 in use
+		[0 ... SHADER_QUEUE_MAX - 1] = {GL_INIT_DEFAULT_FBO, GL_INIT_DEFAULT_TEX, gl_texformat_RG8} //Range uint8 [0, 255]
 	};
-	fb fb_speed[SHADER_SPEED_DOWNLOADLATENCY + 1] = { //Speed measure result, road-domain speed in km/h and screen-domain speed in px/frame
-		[0 ... SHADER_SPEED_DOWNLOADLATENCY] = {GL_INIT_DEFAULT_FBO, GL_INIT_DEFAULT_TEX, gl_texformat_RG8} //Range uint8 [0, 255]
+	fb fb_occupancy[SHADER_QUEUE_MAX] = { //Row occupancy of speed map, same queue as fb_speed
+		[0 ... SHADER_QUEUE_MAX - 1] = {GL_INIT_DEFAULT_FBO, GL_INIT_DEFAULT_TEX, gl_texformat_R8} //Bool
 	};
 	fb fb_display = {GL_INIT_DEFAULT_FBO, GL_INIT_DEFAULT_TEX, gl_texformat_RGBA8}; //Display human-readable text, video, RGBA8
-	fb fb_stageA = {GL_INIT_DEFAULT_FBO, GL_INIT_DEFAULT_TEX, gl_texformat_RG8}; //General intermediate data, normalized, max 2 ch
-	fb fb_stageB = {GL_INIT_DEFAULT_FBO, GL_INIT_DEFAULT_TEX, gl_texformat_RG8};
+	fb fb_stageA[SHADER_QUEUE_MAX] = { //General intermediate data, normalized, max 2 ch, same queue as fb_speed so frames in flight do not share them
+		[0 ... SHADER_QUEUE_MAX - 1] = {GL_INIT_DEFAULT_FBO, GL_INIT_DEFAULT_TEX, gl_texformat_RG8}
+	};
+	fb fb_stageB[SHADER_QUEUE_MAX] = {
+		[0 ... SHADER_QUEUE_MAX - 1] = {GL_INIT_DEFAULT_FBO, GL_INIT_DEFAULT_TEX, gl_texformat_RG8}
+	};
+	fb fb_edge[SHADER_QUEUE_MAX] = { //If fusedEdge, refined edge from fusedEdge shader, same queue as fb_speed; RGBA8 because ES image store has no RG8
+		[0 ... SHADER_QUEUE_MAX - 1] = {GL_INIT_DEFAULT_FBO, GL_INIT_DEFAULT_TEX, gl_texformat_RGBA8}
+	};
 	fb fb_check = {GL_INIT_DEFAULT_FBO, GL_INIT_DEFAULT_TEX, gl_texformat_RGBA16F};
 
 	//Program - Roadmap check
 	struct { gl_program pid; } program_roadmapCheck = {.pid = GL_INIT_DEFAULT_PROGRAM};
 	struct { gl_program pid; gl_param src; gl_param mode; } program_project = {.pid = GL_INIT_DEFAULT_PROGRAM};
 	struct { gl_program pid; gl_param src; } program_blurFilter = {.pid = GL_INIT_DEFAULT_PROGRAM};
+	struct { gl_program pid; gl_param current; gl_param previous; } program_temporalFilter = {.pid = GL_INIT_DEFAULT_PROGRAM};
 	struct { gl_program pid; gl_param src; } program_edgeFilter = {.pid = GL_INIT_DEFAULT_PROGRAM};
 	struct { gl_program pid; gl_param current; gl_param previous; } program_changingSensor = {.pid = GL_INIT_DEFAULT_PROGRAM};
-	struct { gl_program pid; gl_param src; gl_param direction; } program_objectFix = {.pid = GL_INIT_DEFAULT_PROGRAM};
-	struct { gl_program pid; gl_param src; } program_edgeRefine = {.pid = GL_INIT_DEFAULT_PROGRAM};
+	struct { gl_program pid; gl_param src; gl_param direction; gl_param gap; } program_objectFix = {.pid = GL_INIT_DEFAULT_PROGRAM};
+	struct { gl_program pid; gl_param src; gl_param direction; gl_param range; int lines[2][3]; uint groups[2][3]; } program_objectFixScan = {.pid = GL_INIT_DEFAULT_PROGRAM}; //Range (lines and part of line) and work groups (a line each) of horizontal and vertical scans
+	struct { gl_program pid; gl_param src; gl_param run; } program_edgeRefine = {.pid = GL_INIT_DEFAULT_PROGRAM};
+	struct { gl_program pid; gl_param src; int grid[4]; int halo[2]; uint groups[3]; } program_edgeRefineScan = {.pid = GL_INIT_DEFAULT_PROGRAM}; //Tiles ({left, top} of the first tile, {width, height}), halo (columns and rows) and work groups (a row of tiles each)
+	struct { gl_program pid; gl_param current; gl_param previous; uint groups[3]; } program_fusedEdge = {.pid = GL_INIT_DEFAULT_PROGRAM};
 	struct { gl_program pid; gl_param current; gl_param hint; gl_param previous; } program_measure = {.pid = GL_INIT_DEFAULT_PROGRAM};
 	struct { gl_program pid; gl_param src; } program_sample = {.pid = GL_INIT_DEFAULT_PROGRAM};
+	struct { gl_program pid; gl_param src; uint groups[3]; } program_compact = {.pid = GL_INIT_DEFAULT_PROGRAM};
+	struct { gl_program pid; gl_param src; } program_occupancy = {.pid = GL_INIT_DEFAULT_PROGRAM};
 	struct { gl_program pid; } program_display = {.pid = GL_INIT_DEFAULT_PROGRAM};
 	struct { gl_program pid; gl_param orginal; gl_param result; } program_final = {.pid = GL_INIT_DEFAULT_PROGRAM};
 
+	//Benchmark mode: CPU time of each step of main thread, GPU time of each pass (timer query, read a few frames later)
+	#define BENCHMARK_CPU_CNT 5
+	#define BENCHMARK_GPU_CNT 10
+	#define BENCHMARK_REF (BENCHMARK_CPU_CNT + BENCHMARK_GPU_CNT + 1) //CPU backend: time of each pass, then total
+	const char* const benchmark_stageName[BENCHMARK_REF + cpu_pass_cnt + 1] = {
+		"cpu_upload", "cpu_render", "cpu_download", "cpu_display", "cpu_wait",
+		"gpu_upload", "gpu_blur", "gpu_changingSensor", "gpu_objectFix", "gpu_edgeRefine", "gpu_project", "gpu_measure", "gpu_unproject", "gpu_sample", "gpu_display",
+		"gpu_total",
+		"ref_blur", "ref_changingSensor", "ref_objectFix", "ref_edgeRefine", "ref_project", "ref_measure", "ref_unproject", "ref_sample",
+		"ref_total"
+	};
+	Benchmark benchmark = NULL; //NULL if not in benchmark mode
+	unsigned int benchmarkEnd = UINT_MAX; //Frames from this one are not recorded: after the measured frames, or not from the input (end of input)
+	gl_timer benchmark_timer = GL_INIT_DEFAULT_TIMER; //A stamp before the first pass and after each pass, not created (stamps do nothing) if not in benchmark mode
+	void benchmarkGpuRead(int wait) { //Read GPU time of finished frames
+		unsigned int frame;
+		uint64_t duration[BENCHMARK_GPU_CNT];
+		for (int cnt; (cnt = gl_timer_read(&benchmark_timer, wait, &frame, duration)) >= 0; ) {
+			if (cnt == BENCHMARK_GPU_CNT + 1 && frame < benchmarkEnd) {
+				uint64_t total = 0;
+				for (uint i = 0; i < BENCHMARK_GPU_CNT; i++) {
+					benchmark_stage(benchmark, frame, BENCHMARK_CPU_CNT + i, duration[i]);
+					total += duration[i];
+				}
+				benchmark_stage(benchmark, frame, BENCHMARK_CPU_CNT + BENCHMARK_GPU_CNT, total);
+			}
+		}
+	}
+
 	/* Init OpenGL and viewer window */ {
 		info("Init openGL...");
 		if (!gl_init((gl_config){
@@ -170,7 +489,8 @@ int main(int argc, char* argv[]) {
 			.gles = 1,
 			.vsynch = 0,
 			.winWidth = sizeData[0], .winHeight = sizeData[1],
-			.winName = "Viewer"
+			.winName = "Viewer",
+			.backend = cfg.headless ? gl_backend_egl : gl_backend_glfw
 		})) {
 			error("Cannot init OpenGL");
 			goto label_exit;
@@ -179,29 +499,30 @@ int main(int argc, char* argv[]) {
 
 	/* Use a texture to store raw frame data & Start reader thread */ {
 		info("Prepare video upload buffer...");
-		#ifdef USE_PBO_UPLOAD
+		if (cfg.pboUpload) {
 			pboUpload[0] = gl_pixelBuffer_create(sizeData[0] * sizeData[1] * 4, 0, gl_usage_stream); //Always use RGBA8 (good performance)
 			pboUpload[1] = gl_pixelBuffer_create(sizeData[0] * sizeData[1] * 4, 0, gl_usage_stream);
 			if ( !gl_pixelBuffer_check(&(pboUpload[0])) || !gl_pixelBuffer_check(&(pboUpload[1])) ) {
 				error("Fail to create pixel buffers for orginal frame data uploading");
 				goto label_exit;
 			}
-		#else
+		} else {
 			rawData[0] = malloc(sizeData[0] * sizeData[1] * 4); //Always use RGBA8 (aligned, good performance)
 			rawData[1] = malloc(sizeData[0] * sizeData[1] * 4);
 			if (!rawData[0] || !rawData[1]) {
 				error("Fail to create memory buffers for orginal frame data loading");
 				goto label_exit;
 			}
-		#endif
+		}
 
 		gl_tex_dim dim[3] = {
 			{.size = sizeData[0], .wrapping = gl_tex_dimWrapping_edge},
 			{.size = sizeData[1], .wrapping = gl_tex_dimWrapping_edge},
 			{.size = 0, .wrapping = gl_tex_dimWrapping_edge}
 		};
-		texture_orginalBuffer[0] = gl_texture_create(gl_texformat_RGBA8, gl_textype_2d, gl_tex_dimFilter_nearest, gl_tex_dimFilter_nearest, dim); //RGBA8 Video use lowp
-		texture_orginalBuffer[1] = gl_texture_create(gl_texformat_RGBA8, gl_textype_2d, gl_tex_dimFilter_nearest, gl_tex_dimFilter_nearest, dim);
+		const gl_tex_dimFilter filter = config_getUint(config, "blurFilter.BILINEAR", UINT_MAX) != UINT_MAX ? gl_tex_dimFilter_linear : gl_tex_dimFilter_nearest; //Bilinear taps of blur filter, defined in any value
+		texture_orginalBuffer[0] = gl_texture_create(gl_texformat_RGBA8, gl_textype_2d, filter, filter, dim); //RGBA8 Video use lowp
+		texture_orginalBuffer[1] = gl_texture_create(gl_texformat_RGBA8, gl_textype_2d, filter, filter, dim);
 		if ( !gl_texture_check(&texture_orginalBuffer[0]) || !gl_texture_check(&texture_orginalBuffer[1]) ) {
 			error("Fail to create texture buffer for orginal frame data storage");
 			goto label_exit;
@@ -230,7 +551,18 @@ int main(int argc, char* argv[]) {
 		road_boxROI.top = roadmap.roadPoints[roadmap.header.pCnt-4].sy;
 		road_boxROI.bottom = roadmap.roadPoints[roadmap.header.pCnt-1].sy;
 
-		roadmap_post(&roadmap, MAX_SPEED / 3.6 / fps, SHADER_MEASURE_INTERLACE * MAX_SPEED / 3.6 / fps); //km/h to m/s to m/frame
+		unsigned int left = road_boxROI.left * sizeData[0], right = road_boxROI.right * sizeData[0]; //Inclusive
+		unsigned int top = road_boxROI.top * sizeData[1], bottom = road_boxROI.bottom * sizeData[1];
+		if (right >= sizeData[0]) right = sizeData[0] - 1;
+		if (bottom >= sizeData[1]) bottom = sizeData[1] - 1;
+		left &= ~(unsigned int)1; //Width of frame is even, so box can be extended to even width without going out of frame
+		road_boxROIpx.offset[0] = left;
+		road_boxROIpx.offset[1] = top;
+		road_boxROIpx.size[0] = (right - left + 2) & ~(unsigned int)1;
+		road_boxROIpx.size[1] = bottom - top + 1;
+		info("\tROI: %u*%u px at (%u,%u), %.1f%% of frame", road_boxROIpx.size[0], road_boxROIpx.size[1], left, top, 100.0 * road_boxROIpx.size[0] * road_boxROIpx.size[1] / (sizeData[0] * sizeData[1]));
+
+		roadmap_post(&roadmap, cfg.maxSpeed / 3.6 / fps, cfg.measureInterlace * cfg.maxSpeed / 3.6 / fps); //km/h to m/s to m/frame
 
 		const unsigned int sizeRoadmap[3] = {roadmap.header.width, roadmap.header.height, 1};
 		const gl_index_t attributes[] = {2, 0};
@@ -241,6 +573,37 @@ int main(int argc, char* argv[]) {
 			error("Fail to create mesh for roadmap - Region of interest");
 			goto label_exit;
 		}
+
+		/* Focus region with margin: points are pairs of left and right from top to bottom, move left and right apart, first and last pair up and down */ {
+			const unsigned int cnt = roadmap.header.pCnt - 4;
+			const float margin = SHADER_REGION_MARGIN;
+			struct RoadPoint* const p = roadmap.roadPoints;
+			struct RoadPoint* dilated = malloc(cnt * sizeof(struct RoadPoint));
+			if (!dilated) {
+				error("Fail to allocate memory for mesh of focus region with margin");
+				goto label_exit;
+			}
+			for (unsigned int i = 0; i < cnt; i++) {
+				float slope = 0.0f; //Max |dx/dy| in px of the side at this point, moving by margin * (1 + slope) keeps the side margin px away in both x and y
+				for (int j = (int)i - 2; j <= (int)i + 2; j += 4) {
+					if (j < 0 || j >= (int)cnt)
+						continue;
+					const float dx = fabsf(p[j].sx - p[i].sx) * sizeData[0], dy = fabsf(p[j].sy - p[i].sy) * sizeData[1];
+					if (dy > 0.0f && dx / dy > slope)
+						slope = dx / dy;
+				}
+				const float x = p[i].sx + (i & 1 ? 1.0f : -1.0f) * margin * (1.0f + slope) / sizeData[0];
+				const float y = p[i].sy + (i < 2 ? -margin : i >= cnt - 2 ? margin : 0.0f) / sizeData[1];
+				dilated[i].sx = x < 0.0f ? 0.0f : x > 1.0f ? 1.0f : x;
+				dilated[i].sy = y < 0.0f ? 0.0f : y > 1.0f ? 1.0f : y;
+			}
+			mesh_perspMargin = gl_mesh_create(cnt, 0, 0, gl_meshmode_triangleStrip, attributes, NULL, (gl_vertex_t*)dilated, NULL, NULL);
+			free(dilated);
+			if (!gl_mesh_check(&mesh_perspMargin)) {
+				error("Fail to create mesh for focus region with margin");
+				goto label_exit;
+			}
+		}
 		
 		gl_tex_dim dim[3] = {
 			{.size = sizeRoadmap[0], .wrapping = gl_tex_dimWrapping_edge},
@@ -284,7 +647,7 @@ int main(int argc, char* argv[]) {
 
 		speedometer_destroy(speedometer); //Free speedometer memory after data uploading finished
 
-		instance_speedometer_data = malloc(SHADER_SPEEDOMETER_CNT * 3 * sizeof(float));
+		instance_speedometer_data = malloc(instance_speedometer_cap * 3 * sizeof(float));
 		if (!instance_speedometer_data) {
 			error("Fail to allocate memory for speedometer instance buffer");
 			goto label_exit;
@@ -295,7 +658,7 @@ int main(int argc, char* argv[]) {
 			-0.02, +0.0125, 0.0f, 1.0f,
 			-0.02, -0.0125, 0.0f, 0.0f
 		};
-		mesh_display = gl_mesh_create(4, 0, SHADER_SPEEDOMETER_CNT, gl_meshmode_triangleFan, (gl_index_t[]){4, 0}, (gl_index_t[]){3, 0}, vertices, NULL, NULL);
+		mesh_display = gl_mesh_create(4, 0, mesh_displayCap, gl_meshmode_triangleFan, (gl_index_t[]){4, 0}, (gl_index_t[]){3, 0}, vertices, NULL, NULL);
 		if (!gl_mesh_check(&mesh_display)) {
 			error("Fail to create mesh to store speedometer");
 			goto label_exit;
@@ -303,25 +666,123 @@ int main(int argc, char* argv[]) {
 	}
 
 	/* Create buffer for post process on CPU side & Start output thread for result write */ {
-		#ifdef USE_PBO_DOWNLOAD
-			pboDownload = gl_pixelBuffer_create(sizeData[0] * sizeData[1] * sizeof(speedData[0][0]), 1, gl_usage_stream);
-			if (!gl_pixelBuffer_check(&pboDownload)) {
-				error("Fail to create pixel buffer for speed downloading");
-				goto label_exit;
+		if (cfg.compact) {
+			for (uint i = 0; i <= cfg.speedDownloadLatency; i++) {
+				sboCompact[i] = gl_storageBuffer_create(SBO_COMPACT, 2 * sizeof(uint32_t) + compactCap * sizeof(compactData[0][0]), gl_usage_stream);
+				if (!gl_storageBuffer_check(&sboCompact[i])) {
+					error("Fail to create storage buffer for compact speed sample downloading");
+					goto label_exit;
+				}
+				gl_storageBuffer_update(&sboCompact[i], 0, sizeof(uint32_t), (const uint32_t[1]){0}); //Empty, in case it is downloaded before written
+				sboCompactCap[i] = compactCap;
 			}
-		#else
-			speedData = malloc(sizeData[0] * sizeData[1] * sizeof(speedData[0][0])); //FBO dump
-			if (!speedData) {
-				error("Fail to create buffer to download speed framebuffer");
-				goto label_exit;
+			for (uint i = 0; i < cfg.analysisQueue; i++) {
+				compactData[i] = malloc(compactCap * sizeof(compactData[i][0]));
+				compactDataCap[i] = compactCap;
+				if (!compactData[i]) {
+					error("Fail to create buffer to download compact speed sample (%u)", i);
+					goto label_exit;
+				}
 			}
-		#endif
+		} else {
+			if (cfg.pboDownload) {
+				pboDownload = calloc(pboDownloadDepth, sizeof(pboDownload[0]));
+				if (!pboDownload) {
+					error("Fail to create pixel buffer ring for speed downloading");
+					goto label_exit;
+				}
+				for (uint i = 0; i < pboDownloadDepth; i++) {
+					pboDownload[i].speed = gl_pixelBuffer_create(road_boxROIpx.size[0] * road_boxROIpx.size[1] * 2, 1, gl_usage_stream); //RG8
+					if (!gl_pixelBuffer_check(&pboDownload[i].speed)) {
+						error("Fail to create pixel buffer for speed downloading (%u)", i);
+						goto label_exit;
+					}
+					#ifdef USE_ROW_OCCUPANCY
+						pboDownload[i].occupancy = gl_pixelBuffer_create(road_boxROIpx.size[1] * OCCUPANCY_SPAN, 1, gl_usage_stream);
+						if (!gl_pixelBuffer_check(&pboDownload[i].occupancy)) {
+							error("Fail to create pixel buffer for row occupancy downloading (%u)", i);
+							goto label_exit;
+						}
+					#endif
+				}
+			} else {
+				for (uint i = 0; i < cfg.analysisQueue; i++) {
+					speedData[i] = malloc(road_boxROIpx.size[0] * road_boxROIpx.size[1] * sizeof(speedData[i][0])); //FBO dump
+					if (!speedData[i]) {
+						error("Fail to create buffer to download speed framebuffer (%u)", i);
+						goto label_exit;
+					}
+					#ifdef USE_ROW_OCCUPANCY
+						occupancyData[i] = malloc(road_boxROIpx.size[1] * sizeof(occupancyData[i][0]));
+						if (!occupancyData[i]) {
+							error("Fail to create buffer to download row occupancy (%u)", i);
+							goto label_exit;
+						}
+					#endif
+				}
+			}
+
+			if (cfg.speedmapDump) {
+				speedmapDump = fopen(cfg.speedmapDump, "ab");
+				if (!speedmapDump) {
+					error("Fail to open speed map dump file (errno = %d)", errno);
+					goto label_exit;
+				}
+			}
+		}
 		
 		info("Init output thread...");
-		if (!th_output_init()) {
+		if (!th_output_init((output_config){
+			.mode = cfg.outputMode,
+			.trackGateX = cfg.trackGateX,
+			.trackGateY = cfg.maxSpeed / 3.6 / fps, //km/h to m/s to m/frame
+			.trackTimeout = cfg.trackTimeout,
+			.trackMinCount = cfg.trackMinCount,
+			.rollupFile = cfg.rollupFile,
+			.rollupInterval = cfg.rollupInterval * fps, //Second to frame
+			.laneOrigin = cfg.laneOrigin,
+			.laneWidth = cfg.laneWidth,
+			.laneCnt = cfg.laneCnt,
+			.archiveFile = cfg.archiveFile,
+			.fps = fps,
+			.eventSpeed = cfg.eventSpeed
+		})) {
 			error("Fail to create output thread");
 			goto label_exit;
 		}
+
+		info("Init analysis thread...");
+		char* statue;
+		if (!th_analysis_init((analysis_config){
+			.width = sizeData[0],
+			.height = sizeData[1],
+			.roiOffset = {road_boxROIpx.offset[0], road_boxROIpx.offset[1]},
+			.roiSize = {road_boxROIpx.size[0], road_boxROIpx.size[1]},
+			.roadmap = &roadmap,
+			.queueDepth = cfg.pboDownload ? cfg.pboDownloadDepth : cfg.analysisQueue, //Each mapped PBO is a job
+			.objCnt = cfg.speedometerCnt,
+			.occupancySpan = OCCUPANCY_SPAN
+		}, &statue)) {
+			error("Fail to create analysis thread: %s", statue);
+			goto label_exit;
+		}
+
+		if (cfg.eventSpeed) {
+			info("Init event thread...");
+			char* statue;
+			if (!th_event_init((event_config){
+				.frameSize = sizeData[0] * sizeData[1] * 4, //RGBA8
+				.ringDepth = cfg.eventRing,
+				.pre = cfg.eventPre,
+				.post = cfg.eventPost,
+				.frameOffset = EVENT_FRAME_OFFSET,
+				.dir = cfg.eventDir
+			}, &statue)) {
+				error("Fail to create event thread: %s", statue);
+				goto label_exit;
+			}
+			th_reader_tap(th_event_capture);
+		}
 	}
 
 	/* Create final display mesh */ {
@@ -348,6 +809,8 @@ int main(int argc, char* argv[]) {
 		};
 
 		for (unsigned int i = 0; i < arrayLength(fb_raw); i++) {
+			if (cfg.denoise)
+				fb_raw[i].format = gl_texformat_RGBA16F; //Temporal filter state, the small steps of the average are lost in RGBA8
 			fb_raw[i].tex = gl_texture_create(fb_raw[i].format, gl_textype_2d, gl_tex_dimFilter_nearest, gl_tex_dimFilter_nearest, dim); //Video data
 			if (!gl_texture_check(&fb_raw[i].tex)) {
 				error("Fail to create texture to store raw video data (%u)", i);
@@ -358,9 +821,10 @@ int main(int argc, char* argv[]) {
 				error("Fail to create FBO to store raw video data (%u)", i);
 				goto label_exit;
 			}
+			gl_frameBuffer_bind(&fb_raw[i].fbo, gl_frameBuffer_clearAll); //Temporal filter reads the previous one as state, 0 before the first frame
 		}
 
-		for (unsigned int i = 0; i < arrayLength(fb_object); i++) {
+		for (unsigned int i = 0; i <= cfg.measureInterlace; i++) {
 			fb_object[i].tex = gl_texture_create(fb_object[i].format, gl_textype_2d, gl_tex_dimFilter_nearest, gl_tex_dimFilter_nearest, dim); //Object in video
 			if (!gl_texture_check(&fb_object[i].tex)) {
 				error("Fail to create texture to store object (%u)", i);
@@ -373,7 +837,7 @@ int main(int argc, char* argv[]) {
 			}
 		}
 
-		for (uint i = 0; i < arrayLength(fb_speed); i++) {
+		for (uint i = 0; i <= cfg.speedDownloadLatency; i++) {
 			fb_speed[i].tex = gl_texture_create(fb_speed[i].format, gl_textype_2d, gl_tex_dimFilter_nearest, gl_tex_dimFilter_nearest, dim); //Speed data, discrete
 			if (!gl_texture_check(&fb_speed[i].tex)) {
 				error("Fail to create texture to store speed (%u)", i);
@@ -386,6 +850,26 @@ int main(int argc, char* argv[]) {
 			}
 		}
 
+		#ifdef USE_ROW_OCCUPANCY
+		for (uint i = 0; i <= cfg.speedDownloadLatency && !cfg.compact; i++) { //Scan path only
+			gl_tex_dim dimOccupancy[3] = {
+				{.size = OCCUPANCY_SPAN, .wrapping = gl_tex_dimWrapping_edge},
+				{.size = sizeData[1], .wrapping = gl_tex_dimWrapping_edge},
+				{.size = 0, .wrapping = gl_tex_dimWrapping_edge}
+			};
+			fb_occupancy[i].tex = gl_texture_create(fb_occupancy[i].format, gl_textype_2d, gl_tex_dimFilter_nearest, gl_tex_dimFilter_nearest, dimOccupancy); //Row occupancy, bool
+			if (!gl_texture_check(&fb_occupancy[i].tex)) {
+				error("Fail to create texture to store row occupancy (%u)", i);
+				goto label_exit;
+			}
+			fb_occupancy[i].fbo = gl_frameBuffer_create(1, (const gl_tex[]){fb_occupancy[i].tex}, (const gl_fboattach[]){gl_fboattach_color0});
+			if (!gl_frameBuffer_check(&fb_occupancy[i].fbo) ) {
+				error("Fail to create FBO to store row occupancy (%u)", i);
+				goto label_exit;
+			}
+		}
+		#endif
+
 		fb_display.tex = gl_texture_create(fb_display.format, gl_textype_2d, gl_tex_dimFilter_nearest, gl_tex_dimFilter_nearest, dim); //Video display to user
 		if (!gl_texture_check(&fb_display.tex)) {
 			error("Fail to create texture to store speed display");
@@ -397,27 +881,126 @@ int main(int argc, char* argv[]) {
 			goto label_exit;
 		}
 
-		fb_stageA.tex = gl_texture_create(fb_stageA.format, gl_textype_2d, gl_tex_dimFilter_nearest, gl_tex_dimFilter_nearest, dim); //General Data
-		fb_stageB.tex = gl_texture_create(fb_stageB.format, gl_textype_2d, gl_tex_dimFilter_nearest, gl_tex_dimFilter_nearest, dim);
-		if ( !gl_texture_check(&fb_stageA.tex) || !gl_texture_check(&fb_stageB.tex) ) {
-			error("Fail to create texture to store moving edge");
-			goto label_exit;
+		for (uint i = 0; i <= cfg.speedDownloadLatency; i++) {
+			fb_stageA[i].tex = gl_texture_create(fb_stageA[i].format, gl_textype_2d, gl_tex_dimFilter_nearest, gl_tex_dimFilter_nearest, dim); //General Data
+			fb_stageB[i].tex = gl_texture_create(fb_stageB[i].format, gl_textype_2d, gl_tex_dimFilter_nearest, gl_tex_dimFilter_nearest, dim);
+			if ( !gl_texture_check(&fb_stageA[i].tex) || !gl_texture_check(&fb_stageB[i].tex) ) {
+				error("Fail to create texture to store moving edge (%u)", i);
+				goto label_exit;
+			}
+			fb_stageA[i].fbo = gl_frameBuffer_create(1, (const gl_tex[]){fb_stageA[i].tex}, (const gl_fboattach[]){gl_fboattach_color0});
+			fb_stageB[i].fbo = gl_frameBuffer_create(1, (const gl_tex[]){fb_stageB[i].tex}, (const gl_fboattach[]){gl_fboattach_color0});
+			if ( !gl_frameBuffer_check(&fb_stageA[i].fbo) || !gl_frameBuffer_check(&fb_stageB[i].fbo) ) {
+				error("Fail to create FBO to store moving edge (%u)", i);
+				goto label_exit;
+			}
 		}
-		fb_stageA.fbo = gl_frameBuffer_create(1, (const gl_tex[]){fb_stageA.tex}, (const gl_fboattach[]){gl_fboattach_color0});
-		fb_stageB.fbo = gl_frameBuffer_create(1, (const gl_tex[]){fb_stageB.tex}, (const gl_fboattach[]){gl_fboattach_color0});
-		if ( !gl_frameBuffer_check(&fb_stageA.fbo) || !gl_frameBuffer_check(&fb_stageB.fbo) ) {
-			error("Fail to create FBO to store moving edge");
-			goto label_exit;
+
+		for (uint i = 0; cfg.fusedEdge && i <= cfg.speedDownloadLatency; i++) {
+			fb_edge[i].tex = gl_texture_create(fb_edge[i].format, gl_textype_2d, gl_tex_dimFilter_nearest, gl_tex_dimFilter_nearest, dim); //Refined edge
+			if (!gl_texture_check(&fb_edge[i].tex)) {
+				error("Fail to create texture to store refined edge (%u)", i);
+				goto label_exit;
+			}
+			fb_edge[i].fbo = gl_frameBuffer_create(1, (const gl_tex[]){fb_edge[i].tex}, (const gl_fboattach[]){gl_fboattach_color0});
+			if (!gl_frameBuffer_check(&fb_edge[i].fbo) ) {
+				error("Fail to create FBO to store refined edge (%u)", i);
+				goto label_exit;
+			}
+			gl_frameBuffer_bind(&fb_edge[i].fbo, gl_frameBuffer_clearAll); //fusedEdge writes tiles covering the focus region only, the rest is 0
 		}
 
 		fb_check.tex = gl_texture_create(fb_check.format, gl_textype_2d, gl_tex_dimFilter_nearest, gl_tex_dimFilter_nearest, dim);
 		fb_check.fbo = gl_frameBuffer_create(1, (const gl_tex[]){fb_check.tex}, (const gl_fboattach[]){gl_fboattach_color0});
 	}
 
+	/* Edge refine by scan: tiles from the max search distance in ROI box, search loops if the halo does not fit in the window */ {
+		if (cfg.edgeRefineScan) {
+			const float bottomDenoise = config_getFloat(config, "edgeRefine.SHADER_EDGEREFINE_BOTTOMDENOISE", CPU_EDGEREFINE_BOTTOMDENOISE);
+			const float sideMargin = config_getFloat(config, "edgeRefine.SHADER_EDGEREFINE_SIDEMARGIN", CPU_EDGEREFINE_SIDEMARGIN);
+			const uint boxEnd[2] = {road_boxROIpx.offset[0] + road_boxROIpx.size[0], road_boxROIpx.offset[1] + road_boxROIpx.size[1]};
+			float pixelWidth = 0.0f;
+			for (uint y = road_boxROIpx.offset[1]; y < boxEnd[1] && y < sizeData[1]; y++) {
+				for (uint x = road_boxROIpx.offset[0]; x < boxEnd[0] && x < sizeData[0]; x++) {
+					const float pw = roadmap.t1[ y * roadmap.header.height / sizeData[1] * roadmap.header.width + x * roadmap.header.width / sizeData[0] ].pw; //Roadmap may have different size
+					if (pw > pixelWidth)
+						pixelWidth = pw;
+				}
+			}
+			const float reach = (bottomDenoise > sideMargin ? bottomDenoise : sideMargin) * pixelWidth; //Walk (may go up or down) or bottom search, same as the shader, in px
+			const uint halo = reach + 1.0f < SHADER_EDGEREFINE_WINDOW ? (uint)reach + 1 : SHADER_EDGEREFINE_WINDOW; //1px for mediump rounding
+			const uint haloRows = (halo + 31) & ~31u; //Rows of window are in words of 32 rows
+			if (haloRows * 2 + 32 > SHADER_EDGEREFINE_WINDOW) {
+				info("\tEdge refine scan: halo %upx (pixel width %.1f) too large, use search loops", halo, pixelWidth);
+				cfg.edgeRefineScan = 0;
+			} else {
+				const uint top = road_boxROIpx.offset[1] & ~31u;
+				const uint tile[2] = {SHADER_EDGEREFINE_WINDOW - 2 * halo, SHADER_EDGEREFINE_WINDOW - 2 * haloRows};
+				const uint tiles[2] = {(road_boxROIpx.size[0] + tile[0] - 1) / tile[0], (boxEnd[1] - top + tile[1] - 1) / tile[1]};
+				memcpy(program_edgeRefineScan.grid, (const int[4]){road_boxROIpx.offset[0], top, tile[0], tile[1]}, sizeof(program_edgeRefineScan.grid));
+				memcpy(program_edgeRefineScan.halo, (const int[2]){halo, haloRows}, sizeof(program_edgeRefineScan.halo));
+				program_edgeRefineScan.groups[0] = (tiles[0] + SHADER_EDGEREFINE_TILES - 1) / SHADER_EDGEREFINE_TILES;
+				program_edgeRefineScan.groups[1] = tiles[1];
+				program_edgeRefineScan.groups[2] = 1;
+				info("\tEdge refine scan: halo %upx (pixel width %.1f), tile %u*%upx, %u*%u tiles", halo, pixelWidth, tile[0], tile[1], tiles[0], tiles[1]);
+			}
+		}
+	}
+
+	/* CPU backend: same passes as the shaders on CPU, shader macros in config file are used the same way */ {
+		if (cfg.backend != backend_gpu) {
+			info("Init CPU backend...");
+			char* statue;
+			cpu = cpu_init((cpu_config){
+				.width = sizeData[0],
+				.height = sizeData[1],
+				.roadmap = &roadmap,
+				.measureInterlace = cfg.measureInterlace,
+				.bias = fps * 3.6f / cfg.measureInterlace, //Same as uniform of measure shader
+				.mono = config_getUint(config, "blurFilter.MONO", UINT_MAX) != UINT_MAX, //Defined in any value
+				.bilinear = config_getUint(config, "blurFilter.BILINEAR", UINT_MAX) != UINT_MAX,
+				.temporal = cfg.denoise,
+				.alpha = config_getFloat(config, "temporalFilter.ALPHA", CPU_TEMPORALFILTER_ALPHA),
+				.motion = config_getFloat(config, "temporalFilter.MOTION", CPU_TEMPORALFILTER_MOTION),
+				.threshold = config_getFloat(config, "changingSensor.THRESHOLD", CPU_CHANGINGSENSOR_THRESHOLD),
+				.searchDistance = config_getFloat(config, "objectFix.SEARCH_DISTANCE", CPU_OBJECTFIX_SEARCH_DISTANCE),
+				.bottomDenoise = config_getFloat(config, "edgeRefine.SHADER_EDGEREFINE_BOTTOMDENOISE", CPU_EDGEREFINE_BOTTOMDENOISE),
+				.sideMargin = config_getFloat(config, "edgeRefine.SHADER_EDGEREFINE_SIDEMARGIN", CPU_EDGEREFINE_SIDEMARGIN),
+				.minSampleSize = config_getFloat(config, "sample.MIN_SAMPLE_SIZE", CPU_SAMPLE_MIN_SAMPLE_SIZE),
+				.threads = cfg.cpuThreads
+			}, &statue);
+			if (!cpu) {
+				error("Fail to create CPU backend: %s", statue);
+				goto label_exit;
+			}
+			info("\tThreads: %u", cpu_threads(cpu));
+
+			for (uint i = 0; i < (cfg.backend == backend_cpu ? cfg.analysisQueue : 2); i++) {
+				uint8_t (** const buffer)[2] = cfg.backend == backend_cpu ? &cpuSpeedData[i] : &cpuCheckData[i];
+				*buffer = malloc(road_boxROIpx.size[0] * road_boxROIpx.size[1] * sizeof(cpuSpeedData[0][0]));
+				if (!*buffer) {
+					error("Fail to create buffer for CPU backend speed map (%u)", i);
+					goto label_exit;
+				}
+			}
+		}
+	}
+
 	/* Load shader programs */ {
 		info("Load shaders...");
-		gl_program_setCommonHeader("#version 310 es\n");
 		#define NL "\n"
+		gl_program shaderLoadHeader(const char* const name, const char* const version, gl_programArg* const arg) { //Load SHADER_DIR/name.glsl, version (and defines) then "name.MACRO = value" in config file are in its common header
+			char src[256];
+			snprintf(src, sizeof(src), SHADER_DIR"%s.glsl", name);
+			const char* header = config_shaderHeader(config, name, version);
+			if (!header)
+				return GL_INIT_DEFAULT_PROGRAM;
+			gl_program_setCommonHeader(header);
+			return gl_program_load(src, arg);
+		}
+		gl_program shaderLoad(const char* const name, gl_programArg* const arg) {
+			return shaderLoadHeader(name, "#version 310 es\n", arg);
+		}
 
 		/* Create program: Roadmap check */ {
 			gl_programArg arg[] = {
@@ -425,7 +1008,7 @@ int main(int argc, char* argv[]) {
 				{.name = NULL}
 			};
 
-			if (!( program_roadmapCheck.pid = gl_program_load(SHADER_DIR"roadmapCheck.glsl", arg) )) {
+			if (!( program_roadmapCheck.pid = shaderLoad("roadmapCheck", arg) )) {
 				error("Fail to create shader program: Roadmap check");
 				goto label_exit;
 			}
@@ -442,7 +1025,7 @@ int main(int argc, char* argv[]) {
 				{.name = NULL}
 			};
 
-			if (!( program_project.pid = gl_program_load(SHADER_DIR"project.glsl", arg) )) {
+			if (!( program_project.pid = shaderLoad("project", arg) )) {
 				error("Fail to create shader program: Project perspective to orthographic");
 				goto label_exit;
 			}
@@ -459,18 +1042,33 @@ int main(int argc, char* argv[]) {
 				{.name = NULL}
 			};
 
-			if (!( program_blurFilter.pid = gl_program_load(SHADER_DIR"blurFilter.glsl", arg) )) {
+			if (!( program_blurFilter.pid = shaderLoad("blurFilter", arg) )) {
 				error("Fail to create shader program: Blur filter");
 				goto label_exit;
 			}
 			program_blurFilter.src = arg[0].id;
 
-			if (!( program_edgeFilter.pid = gl_program_load(SHADER_DIR"edgeFilter.glsl", arg) )) {
+			if (!( program_edgeFilter.pid = shaderLoad("edgeFilter", arg) )) {
 				error("Fail to create shader program: Edge filter");
 				goto label_exit;
 			}
 			program_edgeFilter.src = arg[0].id;
 		}
+
+		/* Create program: Temporal filter */ {
+			gl_programArg arg[] = {
+				{gl_programArgType_normal,	"current"},
+				{gl_programArgType_normal,	"previous"},
+				{.name = NULL}
+			};
+
+			if (!( program_temporalFilter.pid = shaderLoad("temporalFilter", arg) )) {
+				error("Fail to create shader program: Temporal filter");
+				goto label_exit;
+			}
+			program_temporalFilter.current = arg[0].id;
+			program_temporalFilter.previous = arg[1].id;
+		}
 		
 		/* Create program: Changing sensor */ {
 			gl_programArg arg[] = {
@@ -479,7 +1077,7 @@ int main(int argc, char* argv[]) {
 				{.name = NULL}
 			};
 
-			if (!( program_changingSensor.pid = gl_program_load(SHADER_DIR"changingSensor.glsl", arg) )) {
+			if (!( program_changingSensor.pid = shaderLoad("changingSensor", arg) )) {
 				error("Fail to create shader program: Changing sensor");
 				goto label_exit;
 			}
@@ -487,42 +1085,221 @@ int main(int argc, char* argv[]) {
 			program_changingSensor.previous = arg[1].id;
 		}
 
-		/* Create program: Object fix */ {
+		/* Create program: Object fix, by scan (nearest blocks of each px, then a lookup) if lines fit in the scan shader, else by search loops */ {
+			if (cfg.objectFixScan) {
+				uint words = 1; //Words of the scanned part of a line, power of 2, local size of the scan
+				for (uint i = 0; i < 2; i++) { //Rows then columns of the ROI box, the fix pass does not go out of the box; blocks in a line start from 1px before the box (the block of the px before the box has the first px of the box)
+					const int first = road_boxROIpx.offset[i] ? (road_boxROIpx.offset[i] - 1) & ~1 : 0, end = road_boxROIpx.offset[i] + road_boxROIpx.size[i];
+					program_objectFixScan.lines[i][0] = road_boxROIpx.offset[1-i];
+					program_objectFixScan.lines[i][1] = first;
+					program_objectFixScan.lines[i][2] = end;
+					program_objectFixScan.groups[i][0] = road_boxROIpx.size[1-i];
+					program_objectFixScan.groups[i][1] = 1;
+					program_objectFixScan.groups[i][2] = 1;
+					while (words * 32 < (uint)(end - first))
+						words <<= 1;
+				}
+				if (words * 32 > SHADER_OBJECTFIX_LINE) {
+					info("\tObject fix scan: line of ROI box up to %upx, longer than %upx, use search loops", words * 32, SHADER_OBJECTFIX_LINE);
+					cfg.objectFixScan = 0;
+				}
+				else {
+					info("\tObject fix scan: %u words a line", words);
+					gl_programArg arg[] = {
+						{gl_programArgType_normal,	"src"},
+						{gl_programArgType_normal,	"direction"},
+						{gl_programArgType_normal,	"range"},
+						{.name = NULL}
+					};
+
+					char header[64];
+					snprintf(header, sizeof(header), "#version 310 es\n#define WORDS %u\n", words);
+					if (!( program_objectFixScan.pid = shaderLoadHeader("objectFixScan", header, arg) )) {
+						error("Fail to create shader program: Object fix scan");
+						goto label_exit;
+					}
+					program_objectFixScan.src = arg[0].id;
+					program_objectFixScan.direction = arg[1].id;
+					program_objectFixScan.range = arg[2].id;
+
+					gl_tex_dim dim[3] = {
+						{.size = sizeData[0], .wrapping = gl_tex_dimWrapping_edge},
+						{.size = sizeData[1], .wrapping = gl_tex_dimWrapping_edge},
+						{.size = 0, .wrapping = gl_tex_dimWrapping_edge}
+					};
+					for (uint i = 0; i < 2; i++) {
+						texture_gap[i] = gl_texture_create(gl_texformat_R32UI, gl_textype_2d, gl_tex_dimFilter_nearest, gl_tex_dimFilter_nearest, dim);
+						if (!gl_texture_check(&texture_gap[i])) {
+							error("Fail to create texture for object fix scan");
+							goto label_exit;
+						}
+					}
+				}
+			}
+
 			gl_programArg arg[] = {
 				{gl_programArgType_normal,	"src"},
 				{gl_programArgType_normal,	"roadmap"},
-				{gl_programArgType_normal,	"direction"},
+				{gl_programArgType_normal,	cfg.objectFixScan ? "gap" : "direction"}, //Lookup has no direction, the scan has
 				{.name = NULL}
 			};
 
-			if (!( program_objectFix.pid = gl_program_load(SHADER_DIR"objectFix.glsl", arg) )) {
+			if (!( program_objectFix.pid = shaderLoadHeader("objectFix", cfg.objectFixScan ? "#version 310 es\n#define SCAN\n" : "#version 310 es\n", arg) )) {
 				error("Fail to create shader program: Object fix");
 				goto label_exit;
 			}
 			program_objectFix.src = arg[0].id;
-			program_objectFix.direction = arg[2].id;
+			if (cfg.objectFixScan)
+				program_objectFix.gap = arg[2].id;
+			else
+				program_objectFix.direction = arg[2].id;
 
 			gl_program_use(&program_objectFix.pid);
 			gl_texture_bind(&texture_roadmap, arg[1].id, TEXUNIT_ROADMAP);
 		}
 
-		/* Create program: Edge refine */ {
+		/* Create program: Edge refine, by lookup of the walk lengths from edgeRefineScan, or by search loops */ {
+			if (cfg.edgeRefineScan) {
+				gl_programArg arg[] = {
+					{gl_programArgType_normal,	"src"},
+					{gl_programArgType_normal,	"grid"},
+					{gl_programArgType_normal,	"halo"},
+					{gl_programArgType_normal,	"boxEnd"},
+					{.name = NULL}
+				};
+
+				if (!( program_edgeRefineScan.pid = shaderLoad("edgeRefineScan", arg) )) {
+					error("Fail to create shader program: Edge refine scan");
+					goto label_exit;
+				}
+				program_edgeRefineScan.src = arg[0].id;
+
+				gl_program_use(&program_edgeRefineScan.pid);
+				gl_program_setParam(arg[1].id, 4, gl_datatype_int, program_edgeRefineScan.grid);
+				gl_program_setParam(arg[2].id, 2, gl_datatype_int, program_edgeRefineScan.halo);
+				gl_program_setParam(arg[3].id, 2, gl_datatype_int, (const int[2]){road_boxROIpx.offset[0] + road_boxROIpx.size[0], road_boxROIpx.offset[1] + road_boxROIpx.size[1]});
+
+				gl_tex_dim dim[3] = {
+					{.size = sizeData[0], .wrapping = gl_tex_dimWrapping_edge},
+					{.size = (sizeData[1] + 31) / 32 * SHADER_EDGEREFINE_LAYERS, .wrapping = gl_tex_dimWrapping_edge},
+					{.size = 0, .wrapping = gl_tex_dimWrapping_edge}
+				};
+				texture_run = gl_texture_create(gl_texformat_R32UI, gl_textype_2d, gl_tex_dimFilter_nearest, gl_tex_dimFilter_nearest, dim);
+				if (!gl_texture_check(&texture_run)) {
+					error("Fail to create texture for edge refine scan");
+					goto label_exit;
+				}
+			}
+
 			gl_programArg arg[] = {
 				{gl_programArgType_normal,	"src"},
 				{gl_programArgType_normal,	"roadmap"},
+				{gl_programArgType_normal,	cfg.edgeRefineScan ? "run" : NULL}, //Search loops have no lookup
 				{.name = NULL}
 			};
 
-			if (!( program_edgeRefine.pid = gl_program_load(SHADER_DIR"edgeRefine.glsl", arg) )) {
+			if (!( program_edgeRefine.pid = shaderLoadHeader("edgeRefine", cfg.edgeRefineScan ? "#version 310 es\n#define SCAN\n" : "#version 310 es\n", arg) )) {
 				error("Fail to create shader program: Edge refine");
 				goto label_exit;
 			}
 			program_edgeRefine.src = arg[0].id;
+			if (cfg.edgeRefineScan)
+				program_edgeRefine.run = arg[2].id;
 
 			gl_program_use(&program_edgeRefine.pid);
 			gl_texture_bind(&texture_roadmap, arg[1].id, TEXUNIT_ROADMAP);
 		}
 
+		/* Create program: Fused edge, tile size from the max search distance in focus region */ {
+			if (cfg.fusedEdge) {
+				const float param[4] = { //Same macros as the separated shaders and CPU backend
+					config_getFloat(config, "changingSensor.THRESHOLD", CPU_CHANGINGSENSOR_THRESHOLD),
+					config_getFloat(config, "objectFix.SEARCH_DISTANCE", CPU_OBJECTFIX_SEARCH_DISTANCE),
+					config_getFloat(config, "edgeRefine.SHADER_EDGEREFINE_BOTTOMDENOISE", CPU_EDGEREFINE_BOTTOMDENOISE),
+					config_getFloat(config, "edgeRefine.SHADER_EDGEREFINE_SIDEMARGIN", CPU_EDGEREFINE_SIDEMARGIN)
+				};
+
+				uint8_t (* const focus)[4] = calloc(sizeData[0] * sizeData[1], sizeof(focus[0]) + 1); //RGBA8 texture, followed by R8 mask
+				if (!focus) {
+					error("Fail to create buffer for focus region");
+					goto label_exit;
+				}
+				uint8_t* const mask = (uint8_t*)(focus + sizeData[0] * sizeData[1]);
+				cpu_rasterize(mask, sizeData[0], sizeData[1], roadmap.roadPoints, roadmap.header.pCnt - 4); //Same coverage as mesh_persp
+				float pixelWidth = 0.0f;
+				uint box[4] = {UINT_MAX, UINT_MAX, 0, 0}; //Left, top, right, bottom (inclusive) of the focus region
+				for (uint y = 0; y < sizeData[1]; y++) {
+					for (uint x = 0; x < sizeData[0]; x++) {
+						const uint i = y * sizeData[0] + x;
+						if (!mask[i])
+							continue;
+						focus[i][0] = 255;
+						const float pw = roadmap.t1[ y * roadmap.header.height / sizeData[1] * roadmap.header.width + x * roadmap.header.width / sizeData[0] ].pw; //Roadmap may have different size
+						if (pw > pixelWidth)
+							pixelWidth = pw;
+						if (x < box[0]) box[0] = x;
+						if (y < box[1]) box[1] = y;
+						if (x > box[2]) box[2] = x;
+						if (y > box[3]) box[3] = y;
+					}
+				}
+
+				const int fix = 0.5f * param[1] * pixelWidth, bottom = param[2] * pixelWidth, side = param[3] * pixelWidth; //Same as the shader, in px
+				const uint reachFix = 2 * fix + 1 + 1, reachRefine = (side > bottom ? side : bottom) + 1; //Object fix 2px a step on 2*2 block, edge refine path (may go up or down) or bottom search; 1px for mediump rounding
+				const uint halo = reachRefine + reachFix;
+				if (box[2] < box[0] || halo * 2 + 16 > SHADER_FUSED_WINDOW) {
+					info("\tFused edge: halo %upx (pixel width %.1f) too large for window %upx, use separated passes", halo, pixelWidth, SHADER_FUSED_WINDOW);
+					cfg.fusedEdge = 0;
+					free(focus);
+				} else {
+					const uint tile = SHADER_FUSED_WINDOW - 2 * halo;
+					program_fusedEdge.groups[0] = (box[2] - box[0] + tile) / tile;
+					program_fusedEdge.groups[1] = (box[3] - box[1] + tile) / tile;
+					program_fusedEdge.groups[2] = 1;
+					info("\tFused edge: tile %upx, halo %upx, %u*%u work groups", tile, halo, program_fusedEdge.groups[0], program_fusedEdge.groups[1]);
+
+					gl_tex_dim dim[3] = {
+						{.size = sizeData[0], .wrapping = gl_tex_dimWrapping_edge},
+						{.size = sizeData[1], .wrapping = gl_tex_dimWrapping_edge},
+						{.size = 0, .wrapping = gl_tex_dimWrapping_edge}
+					};
+					texture_focus = gl_texture_create(gl_texformat_RGBA8, gl_textype_2d, gl_tex_dimFilter_nearest, gl_tex_dimFilter_nearest, dim);
+					if (!gl_texture_check(&texture_focus)) {
+						free(focus);
+						error("Fail to create texture for focus region");
+						goto label_exit;
+					}
+					gl_texture_update(&texture_focus, focus, zeros, sizeData);
+					free(focus);
+
+					gl_programArg arg[] = {
+						{gl_programArgType_normal,	"current"},
+						{gl_programArgType_normal,	"previous"},
+						{gl_programArgType_normal,	"focus"},
+						{gl_programArgType_normal,	"roadmap"},
+						{gl_programArgType_normal,	"param"},
+						{gl_programArgType_normal,	"grid"},
+						{gl_programArgType_normal,	"reach"},
+						{.name = NULL}
+					};
+
+					if (!( program_fusedEdge.pid = shaderLoad("fusedEdge", arg) )) {
+						error("Fail to create shader program: Fused edge");
+						goto label_exit;
+					}
+					program_fusedEdge.current = arg[0].id;
+					program_fusedEdge.previous = arg[1].id;
+
+					gl_program_use(&program_fusedEdge.pid);
+					gl_texture_bind(&texture_focus, arg[2].id, TEXUNIT_FOCUS);
+					gl_texture_bind(&texture_roadmap, arg[3].id, TEXUNIT_ROADMAP);
+					gl_program_setParam(arg[4].id, 4, gl_datatype_float, param);
+					gl_program_setParam(arg[5].id, 4, gl_datatype_int, (const int[4]){box[0], box[1], tile, halo});
+					gl_program_setParam(arg[6].id, 1, gl_datatype_int, (const int[1]){reachFix});
+				}
+			}
+		}
+
 		/* Create program: Measure */ {
 			gl_programArg arg[] = {
 				{gl_programArgType_normal,	"current"},
@@ -533,7 +1310,7 @@ int main(int argc, char* argv[]) {
 				{.name = NULL}
 			};
 
-			if (!( program_measure.pid = gl_program_load(SHADER_DIR"measure.glsl", arg) )) {
+			if (!( program_measure.pid = shaderLoad("measure", arg) )) {
 				error("Fail to create shader program: Measure");
 				goto label_exit;
 			}
@@ -543,7 +1320,7 @@ int main(int argc, char* argv[]) {
 
 			gl_program_use(&program_measure.pid);
 			gl_texture_bind(&texture_roadmap, arg[3].id, TEXUNIT_ROADMAP);
-			gl_program_setParam(arg[4].id, 1, gl_datatype_float, (const float[1]){fps * 3.6f / SHADER_MEASURE_INTERLACE}); //m/Nframe to m/frame to km/frame
+			gl_program_setParam(arg[4].id, 1, gl_datatype_float, (const float[1]){fps * 3.6f / cfg.measureInterlace}); //m/Nframe to m/frame to km/frame
 		}
 
 		/* Create program: Sample */ {
@@ -552,20 +1329,67 @@ int main(int argc, char* argv[]) {
 				{.name = NULL}
 			};
 
-			if (!( program_sample.pid = gl_program_load(SHADER_DIR"sample.glsl", arg) )) {
+			if (!( program_sample.pid = shaderLoad("sample", arg) )) {
 				error("Fail to create shader program: Sample");
 				goto label_exit;
 			}
 			program_sample.src = arg[0].id;
 		}
 
+		/* Create program: Compact */ {
+			if (cfg.compact) {
+				gl_programArg arg[] = {
+					{gl_programArgType_normal,	"src"},
+					{gl_programArgType_normal,	"roi"},
+					{.name = NULL}
+				};
+
+				if (!( program_compact.pid = shaderLoad("compact", arg) )) {
+					error("Fail to create shader program: Compact");
+					goto label_exit;
+				}
+				program_compact.src = arg[0].id;
+
+				const uint roi[4] = { //Same box as CPU-side scan
+					road_boxROIpx.offset[0], road_boxROIpx.offset[1],
+					road_boxROIpx.offset[0] + road_boxROIpx.size[0] - 1, road_boxROIpx.offset[1] + road_boxROIpx.size[1] - 1
+				};
+				program_compact.groups[0] = (roi[2] - roi[0] + 1 + 15) / 16; //Local size 16 * 16
+				program_compact.groups[1] = (roi[3] - roi[1] + 1 + 15) / 16;
+				program_compact.groups[2] = 1;
+				gl_program_use(&program_compact.pid);
+				gl_program_setParam(arg[1].id, 4, gl_datatype_uint, roi);
+			}
+		}
+
+		#ifdef USE_ROW_OCCUPANCY
+		/* Create program: Occupancy */ {
+			if (!cfg.compact) {
+				gl_programArg arg[] = {
+					{gl_programArgType_normal,	"src"},
+					{gl_programArgType_normal,	"range"},
+					{.name = NULL}
+				};
+
+				if (!( program_occupancy.pid = shaderLoad("occupancy", arg) )) {
+					error("Fail to create shader program: Occupancy");
+					goto label_exit;
+				}
+				program_occupancy.src = arg[0].id;
+
+				gl_program_use(&program_occupancy.pid);
+				gl_program_setParam(arg[1].id, 2, gl_datatype_int, (const int[2]){road_boxROIpx.offset[0], road_boxROIpx.offset[0] + road_boxROIpx.size[0] - 1}); //Same box as CPU-side scan
+			}
+		}
+		#endif
+
 		/* Create program: Display */ {
 			gl_programArg arg[] = {
 				{gl_programArgType_normal,	"glyphmap"},
 				{.name = NULL}
 			};
 
-			if (!( program_display.pid = gl_program_load(SHADER_DIR"display.glsl", arg) )) {
+			if (!( program_display.pid = shaderLoad("display", arg) )) {
 				error("Fail to create shader program: Display");
 				goto label_exit;
 			}
@@ -581,13 +1405,21 @@ int main(int argc, char* argv[]) {
 				{.name = NULL}
 			};
 
-			if (!( program_final.pid = gl_program_load(SHADER_DIR"final.glsl", arg) )) {
+			if (!( program_final.pid = shaderLoad("final", arg) )) {
 				error("Fail to create shader program: Final");
 				goto label_exit;
 			}
 			program_final.orginal = arg[0].id;
 			program_final.result = arg[1].id;
 		}
+
+		char* statue;
+		if (!config_check(config, &statue)) {
+			error("Cannot load config: %s", statue);
+			goto label_exit;
+		}
+		config_destroy(config); //All config is read
+		config = NULL;
 	}
 
 	void ISR_SIGINT() {
@@ -598,19 +1430,39 @@ int main(int argc, char* argv[]) {
 	
 	#ifdef VERBOSE_TIME
 		uint64_t timestamp = 0;
-		uint64_t (* benchmark)[16] = malloc(sizeof(uint64_t) * 600 * 16); //600 frame, 16 stages
+	#endif
+	if (benchmarkArg.enable) {
+		char* statue;
+		if (benchmarkArg.frames)
+			benchmarkEnd = benchmarkArg.warmup + benchmarkArg.frames;
+		benchmark = benchmark_init(arrayLength(benchmark_stageName), benchmark_stageName, benchmarkArg.warmup, benchmarkArg.frames ? benchmarkEnd : 0, &statue);
 		if (!benchmark) {
-			error("Fail to create benchmark record");
+			error("Fail to create benchmark record: %s", statue);
 			goto label_exit;
 		}
-	#endif
+		if (cfg.backend != backend_cpu) {
+			benchmark_timer = gl_timer_create(8, BENCHMARK_GPU_CNT + 1);
+			if (!gl_timer_check(&benchmark_timer)) {
+				error("Fail to create benchmark GPU timer");
+				goto label_exit;
+			}
+		}
+	}
+
+	/* Region of the blur, by the readers of its result: changing sensor and fused edge read in and around the focus region, the final shader reads the entire frame only if the viewer is on */
+	const gl_mesh* const region_blur = cfg.headless ? &mesh_perspMargin : &mesh_final;
+	info("\tBlur region: %s", region_blur == &mesh_final ? "entire frame" : "focus region with margin");
+
 	info("Program ready!");
-	fprintf(stdout, "R %u*%u : I %u\n", sizeData[0], sizeData[1], SHADER_MEASURE_INTERLACE);
+	fprintf(stdout, "R %u*%u : I %u\n", sizeData[0], sizeData[1], cfg.measureInterlace);
 	
 	/* Main process loop here */
 	uint current, previous; //Two level queue
 	uint current_obj, hint_obj, previous_obj; //Object queue
 	uint current_speed, previous_speed; //Speedmap queue
+	uint download_speed; unsigned int downloadFrame; //Speed map to download in this frame and its frame number: current frame (low latency) or the oldest frame in flight
+	uint64_t frameArrival[SHADER_QUEUE_MAX * 4] = {0}; //Time the frame is read from input (0 if unknown), indexed by frame number (2^n). Read in loop i, processed in loop i+2, downloaded in loop i+2 (low latency) or i+2+speedDownloadLatency
+	int displayCnt = 0; //Number of speedometers to display, from the last analyzed frame
 	while(!gl_close(-1)) {
 		gl_drawStart();
 		char winTitle[200];
@@ -619,237 +1471,416 @@ int main(int argc, char* argv[]) {
 		int cursorPosData[2] = {winsizeNcursor.curPos[0] * sizeData[0], winsizeNcursor.curPos[1] * sizeData[1]};
 
 		if ( /*frameCnt != 330*/ /*!inBox(cursorPosData[0], cursorPosData[1], 0, sizeData[0], 0, sizeData[1], -1)*/ 1 == 1 ) {
-			#ifdef VERBOSE_TIME
-				uint64_t benchmark_current[16] = {[0 ... 15] = 0};
-				int benchmark_currentIdx = 0;
-				benchmark_current[benchmark_currentIdx++] = nanotime(); //Start of frame
-			#endif
+			uint64_t benchmark_current[BENCHMARK_CPU_CNT + 1]; //Time of each step of main thread, for benchmark mode
+			int benchmark_currentIdx = 0;
+			benchmark_current[benchmark_currentIdx++] = nanotime(); //Start of frame
+			gl_timer_stamp(&benchmark_timer);
 
 			current = (uint)frameCnt & (uint)0b1 ? 1 : 0; //Front
 			previous = 1 - current; //Back
-			current_obj = (uint)frameCnt & (uint)SHADER_MEASURE_INTERLACE;
-			hint_obj = ( (uint)frameCnt - (uint)1 ) & (uint)SHADER_MEASURE_INTERLACE;
-			previous_obj = ( (uint)frameCnt + (uint)1 ) & (uint)SHADER_MEASURE_INTERLACE;
-			current_speed = (uint)frameCnt & (uint)SHADER_SPEED_DOWNLOADLATENCY;
-			previous_speed = ( (uint)frameCnt + (uint)1 ) & (uint)SHADER_SPEED_DOWNLOADLATENCY;
+			current_obj = (uint)frameCnt & cfg.measureInterlace;
+			hint_obj = ( (uint)frameCnt - (uint)1 ) & cfg.measureInterlace;
+			previous_obj = ( (uint)frameCnt + (uint)1 ) & cfg.measureInterlace;
+			current_speed = (uint)frameCnt & cfg.speedDownloadLatency;
+			previous_speed = ( (uint)frameCnt + (uint)1 ) & cfg.speedDownloadLatency;
+			if (cfg.lowLatency) {
+				download_speed = current_speed;
+				downloadFrame = frameCnt;
+			} else {
+				download_speed = previous_speed;
+				downloadFrame = frameCnt - cfg.speedDownloadLatency;
+			}
 		
 			// Asking the read thread to upload next frame while the main thread processing current frame
 			void* reader_addr; // Note: 3-stage uploading scheme: reader thread - main thread uploading - GPU processing
-			#ifdef USE_PBO_UPLOAD
+			if (cfg.pboUpload) {
 				gl_pixelBuffer_updateToTexture(&pboUpload[current], &texture_orginalBuffer[previous]);
 				reader_addr = gl_pixelBuffer_updateStart(&pboUpload[previous], sizeData[0] * sizeData[1] * 4);
-			#else
+			} else {
 				gl_texture_update(&texture_orginalBuffer[previous], rawData[current], zeros, sizeData);
 				reader_addr = rawData[previous];
-			#endif
+			}
 			th_reader_start(reader_addr);
 
-			// Start Download data processed in previous frame (if use PBO), this call starts download in background, non-stall
-			#ifdef USE_PBO_DOWNLOAD
-				gl_pixelBuffer_downloadStart(&pboDownload, &fb_speed[previous_speed].fbo, fb_speed->format, 0, zeros, sizeData);
-				//pboDownloadSynch = gl_synchSet(); //See no difference, probally because PBO download must be synch
-			#endif
+			// Start Download data processed in the oldest frame in flight (if use PBO), this call starts download in background, non-stall
+			void pboDownloadPush() { //Start download of speed map, low latency mode starts it after the current frame is issued
+				struct PboDownload* pboDownloadNew = &pboDownload[(pboDownloadTail + pboDownloadCnt++) % pboDownloadDepth]; //Always free, analysis frees one if the ring is full
+				gl_pixelBuffer_downloadStart(&pboDownloadNew->speed, &fb_speed[download_speed].fbo, fb_speed->format, 0, road_boxROIpx.offset, road_boxROIpx.size); //ROI only, nothing outside
+				#ifdef USE_ROW_OCCUPANCY
+					gl_pixelBuffer_downloadStart(&pboDownloadNew->occupancy, &fb_occupancy[download_speed].fbo, fb_occupancy->format, 0, (const uint[2]){0, road_boxROIpx.offset[1]}, (const uint[2]){OCCUPANCY_SPAN, road_boxROIpx.size[1]});
+				#endif
+				pboDownloadNew->synch = gl_synchSet();
+				pboDownloadNew->frame = downloadFrame;
+				pboDownloadNew->arrival = frameArrival[downloadFrame % arrayLength(frameArrival)];
+			}
+			if (cfg.pboDownload && !cfg.lowLatency)
+				pboDownloadPush();
 
 			#ifdef VERBOSE_TIME
 				uint64_t timestampRenderStart = nanotime();
 			#endif
-			#ifdef VERBOSE_TIME
-				benchmark_current[benchmark_currentIdx++] = nanotime(); //Start upload and download
-			#endif
+			benchmark_current[benchmark_currentIdx++] = nanotime(); //Start upload and download
+			gl_timer_stamp(&benchmark_timer);
 			//gl_rsync(); //Request the GL driver start the queue
 
-			gl_setViewport(zeros, sizeData);
-
-			// Debug use ONLY: Check roadmap
-			/*gl_frameBuffer_bind(&fb_check.fbo, gl_frameBuffer_clearAll);
-			gl_program_use(&program_roadmapCheck.pid);
-			gl_mesh_draw(&mesh_ortho, 0, 0);*/
-
-			// Blur the raw to remove noise
-			gl_frameBuffer_bind(&fb_raw[current].fbo, gl_frameBuffer_clearAll); //Mesa: Clear buffer allows the driver to discard old buffer (the doc says it is faster)
-			gl_program_use(&program_blurFilter.pid);
-			gl_texture_bind(&texture_orginalBuffer[current], program_blurFilter.src, 0);
-			gl_mesh_draw(&mesh_final, 0, 0); //Process the entire scene. Although we only need to process ROI, but we want to display the entir scene
-			#ifdef VERBOSE_TIME
-				gl_synch synch_blur = gl_synchSet();
-			#endif
-
-			// Finding changing to detect moving object
-			gl_frameBuffer_bind(&fb_stageA.fbo, gl_frameBuffer_clearAll);
-			gl_program_use(&program_changingSensor.pid);
-			gl_texture_bind(&fb_raw[current].tex, program_changingSensor.current, 0);
-			gl_texture_bind(&fb_raw[previous].tex, program_changingSensor.previous, 1);
-			gl_mesh_draw(&mesh_persp, 0, 0);
-			#ifdef VERBOSE_TIME
-				gl_synch synch_changingDetect = gl_synchSet();
-			#endif
-
-			// Fix object
-			gl_frameBuffer_bind(&fb_stageB.fbo, gl_frameBuffer_clearAll);
-			gl_program_use(&program_objectFix.pid);
-			gl_program_setParam(program_objectFix.direction, 2, gl_datatype_float, (const float[2]){1, 0}); //Has more gap pixels, needs better cache locality (horizontal pixels are togerther in memory)
-			gl_texture_bind(&fb_stageA.tex, program_objectFix.src, 0);
-			gl_mesh_draw(&mesh_persp, 0, 0);
-
-			gl_frameBuffer_bind(&fb_stageA.fbo, gl_frameBuffer_clearAll);
-			gl_program_setParam(program_objectFix.direction, 2, gl_datatype_float, (const float[2]){0, 1}); //Most gap removed by h-fix, less gap and higher chance of intercepted
-			gl_texture_bind(&fb_stageB.tex, program_objectFix.src, 0);
-			gl_mesh_draw(&mesh_persp, 0, 0);
-			#ifdef VERBOSE_TIME
-				gl_synch synch_changingFix = gl_synchSet();
-			#endif
-
-			// Refine edge, thinning the thick edge
-			gl_frameBuffer_bind(&fb_stageB.fbo, gl_frameBuffer_clearAll);
-			gl_program_use(&program_edgeRefine.pid);
-			gl_texture_bind(&fb_stageA.tex, program_edgeRefine.src, 0);
-			gl_mesh_draw(&mesh_persp, 0, 0);
-			#ifdef VERBOSE_TIME
-				gl_synch synch_edgeRefine = gl_synchSet();
-			#endif
-
-			// Project from perspective to orthographic
-			gl_frameBuffer_bind(&fb_object[current_obj].fbo, gl_frameBuffer_clearAll);
-			gl_program_use(&program_project.pid);
-			gl_program_setParam(program_project.mode, 1, gl_datatype_int, (const int[1]){2});
-			gl_texture_bind(&fb_stageB.tex, program_project.src, 0);
-			gl_mesh_draw(&mesh_ortho, 0, 0);
-			#ifdef VERBOSE_TIME
-				gl_synch synch_p2o = gl_synchSet();
-			#endif
-
-			// Measure the distance of edge moving between current frame and previous frame
-			gl_frameBuffer_bind(&fb_stageA.fbo, gl_frameBuffer_clearAll);
-			gl_program_use(&program_measure.pid);
-			gl_texture_bind(&fb_object[current_obj].tex, program_measure.current, 0);
-			gl_texture_bind(&fb_object[hint_obj].tex, program_measure.hint, 1);
-			gl_texture_bind(&fb_object[previous_obj].tex, program_measure.previous, 2);
-			gl_mesh_draw(&mesh_ortho, 0, 0);
-			#ifdef VERBOSE_TIME
-				gl_synch synch_measure = gl_synchSet();
-			#endif
+			void cpuProcess() { //CPU backend: process the frame to be uploaded (processed by GPU in next loop), so it has the same frame number
+				uint64_t cpuTime[cpu_pass_cnt];
+				cpu_process(cpu, rawData[current], frameCnt + 1, cpuTime);
+				uint64_t total = 0;
+				for (uint i = 0; i < cpu_pass_cnt; i++) {
+					cpuTimeTotal[i] += cpuTime[i];
+					total += cpuTime[i];
+					if (benchmark && frameCnt + 1 < benchmarkEnd)
+						benchmark_stage(benchmark, frameCnt + 1, BENCHMARK_REF + i, cpuTime[i]);
+				}
+				if (benchmark && frameCnt + 1 < benchmarkEnd)
+					benchmark_stage(benchmark, frameCnt + 1, BENCHMARK_REF + cpu_pass_cnt, total);
+				cpuFrameCnt++;
+			}
 
-			// Project from orthographic to perspective
-			gl_frameBuffer_bind(&fb_stageB.fbo, gl_frameBuffer_clearAll);
-			gl_program_use(&program_project.pid);
-			gl_program_setParam(program_project.mode, 1, gl_datatype_int, (const int[1]){3});
-			gl_texture_bind(&fb_stageA.tex, program_project.src, 0);
-			gl_mesh_draw(&mesh_persp, 0, 0);
-			#ifdef VERBOSE_TIME
-				gl_synch synch_o2p = gl_synchSet();
-			#endif
+			if (cfg.backend == backend_cpu) {
+				cpuProcess();
+			} else {
+				gl_setViewport(zeros, sizeData);
+
+				// Debug use ONLY: Check roadmap
+				/*gl_frameBuffer_bind(&fb_check.fbo, gl_frameBuffer_clearAll);
+				gl_program_use(&program_roadmapCheck.pid);
+				gl_mesh_draw(&mesh_ortho, 0, 0);*/
+
+				// Blur the raw to remove noise, or average it with previous frames
+				gl_frameBuffer_bind(&fb_raw[current].fbo, gl_frameBuffer_clearAll); //Mesa: Clear buffer allows the driver to discard old buffer (the doc says it is faster)
+				if (cfg.denoise) {
+					gl_program_use(&program_temporalFilter.pid);
+					gl_texture_bind(&texture_orginalBuffer[current], program_temporalFilter.current, 0);
+					gl_texture_bind(&fb_raw[previous].tex, program_temporalFilter.previous, 1);
+				} else {
+					gl_program_use(&program_blurFilter.pid);
+					gl_texture_bind(&texture_orginalBuffer[current], program_blurFilter.src, 0);
+				}
+				gl_mesh_draw(region_blur, 0, 0); //Entire scene if displayed, focus region only in headless mode
+				gl_timer_stamp(&benchmark_timer);
+
+				if (cfg.fusedEdge) {
+					// Changing sensor, object fix and edge refine in one compute shader, a tile a work group, no intermediate texture
+					gl_program_use(&program_fusedEdge.pid);
+					gl_texture_bind(&fb_raw[current].tex, program_fusedEdge.current, 0);
+					gl_texture_bind(&fb_raw[previous].tex, program_fusedEdge.previous, 1);
+					gl_texture_bindImage(&fb_edge[current_speed].tex, IMAGE_EDGE);
+					gl_program_dispatch(program_fusedEdge.groups);
+					gl_texture_syncImage();
+					gl_timer_stamp(&benchmark_timer); //Time of the shader is counted as changing sensor, object fix and edge refine are 0
+					gl_timer_stamp(&benchmark_timer);
+					gl_timer_stamp(&benchmark_timer);
+				} else {
+					// Finding changing to detect moving object
+					gl_frameBuffer_bind(&fb_stageA[current_speed].fbo, gl_frameBuffer_clearAll);
+					gl_program_use(&program_changingSensor.pid);
+					gl_texture_bind(&fb_raw[current].tex, program_changingSensor.current, 0);
+					gl_texture_bind(&fb_raw[previous].tex, program_changingSensor.previous, 1);
+					gl_mesh_draw(&mesh_persp, 0, 0);
+					gl_timer_stamp(&benchmark_timer);
+
+					// Fix object, h-fix then v-fix: h-fix has more gap pixels, needs better cache locality (horizontal pixels are togerther in memory); most gap removed by h-fix, less gap and higher chance of intercepted
+					const fb* const fixSrc[2] = {&fb_stageA[current_speed], &fb_stageB[current_speed]};
+					for (uint i = 0; i < 2; i++) {
+						if (program_objectFixScan.pid) { //Nearest blocks of each px of the lines, so the fix is a lookup
+							gl_program_use(&program_objectFixScan.pid);
+							gl_program_setParam(program_objectFixScan.direction, 2, gl_datatype_int, (const int[2]){1 - i, i});
+							gl_program_setParam(program_objectFixScan.range, 3, gl_datatype_int, program_objectFixScan.lines[i]);
+							gl_texture_bind(&fixSrc[i]->tex, program_objectFixScan.src, 0);
+							gl_texture_bindImage(&texture_gap[i], IMAGE_GAP);
+							gl_program_dispatch(program_objectFixScan.groups[i]);
+							gl_texture_syncImage();
+						}
+						gl_frameBuffer_bind(&fixSrc[1-i]->fbo, gl_frameBuffer_clearAll);
+						gl_program_use(&program_objectFix.pid);
+						gl_texture_bind(&fixSrc[i]->tex, program_objectFix.src, 0);
+						if (program_objectFixScan.pid)
+							gl_texture_bind(&texture_gap[i], program_objectFix.gap, 1);
+						else
+							gl_program_setParam(program_objectFix.direction, 2, gl_datatype_float, (const float[2]){1 - i, i});
+						gl_mesh_draw(&mesh_persp, 0, 0);
+					}
+					gl_timer_stamp(&benchmark_timer);
+
+					// Refine edge, thinning the thick edge
+					if (program_edgeRefineScan.pid) { //Walk length and empty px below of each px, so the refine is a lookup
+						gl_program_use(&program_edgeRefineScan.pid);
+						gl_texture_bind(&fb_stageA[current_speed].tex, program_edgeRefineScan.src, 0);
+						gl_texture_bindImage(&texture_run, IMAGE_RUN);
+						gl_program_dispatch(program_edgeRefineScan.groups);
+						gl_texture_syncImage();
+					}
+					gl_frameBuffer_bind(&fb_stageB[current_speed].fbo, gl_frameBuffer_clearAll);
+					gl_program_use(&program_edgeRefine.pid);
+					gl_texture_bind(&fb_stageA[current_speed].tex, program_edgeRefine.src, 0);
+					if (program_edgeRefineScan.pid)
+						gl_texture_bind(&texture_run, program_edgeRefine.run, 1);
+					gl_mesh_draw(&mesh_persp, 0, 0);
+					gl_timer_stamp(&benchmark_timer);
+				}
 
-			// Sample measure result, get single point
-			gl_frameBuffer_bind(&fb_speed[current_speed].fbo, gl_frameBuffer_clearAll);
-			gl_program_use(&program_sample.pid);
-			gl_texture_bind(&fb_stageB.tex, program_sample.src, 0);
-			gl_mesh_draw(&mesh_persp, 0, 0);
-			#ifdef VERBOSE_TIME
-				gl_synch synch_sample = gl_synchSet();
-			#endif
+				// Project from perspective to orthographic
+				gl_frameBuffer_bind(&fb_object[current_obj].fbo, gl_frameBuffer_clearAll);
+				gl_program_use(&program_project.pid);
+				gl_program_setParam(program_project.mode, 1, gl_datatype_int, (const int[1]){2});
+				gl_texture_bind(cfg.fusedEdge ? &fb_edge[current_speed].tex : &fb_stageB[current_speed].tex, program_project.src, 0);
+				gl_mesh_draw(&mesh_ortho, 0, 0);
+				gl_timer_stamp(&benchmark_timer);
+
+				// Measure the distance of edge moving between current frame and previous frame
+				gl_frameBuffer_bind(&fb_stageA[current_speed].fbo, gl_frameBuffer_clearAll);
+				gl_program_use(&program_measure.pid);
+				gl_texture_bind(&fb_object[current_obj].tex, program_measure.current, 0);
+				gl_texture_bind(&fb_object[hint_obj].tex, program_measure.hint, 1);
+				gl_texture_bind(&fb_object[previous_obj].tex, program_measure.previous, 2);
+				gl_mesh_draw(&mesh_ortho, 0, 0);
+				gl_timer_stamp(&benchmark_timer);
+
+				// Project from orthographic to perspective
+				gl_frameBuffer_bind(&fb_stageB[current_speed].fbo, gl_frameBuffer_clearAll);
+				gl_program_use(&program_project.pid);
+				gl_program_setParam(program_project.mode, 1, gl_datatype_int, (const int[1]){3});
+				gl_texture_bind(&fb_stageA[current_speed].tex, program_project.src, 0);
+				gl_mesh_draw(&mesh_persp, 0, 0);
+				gl_timer_stamp(&benchmark_timer);
+
+				// Sample measure result, get single point
+				gl_frameBuffer_bind(&fb_speed[current_speed].fbo, gl_frameBuffer_clearAll);
+				gl_program_use(&program_sample.pid);
+				gl_texture_bind(&fb_stageB[current_speed].tex, program_sample.src, 0);
+				gl_mesh_draw(&mesh_persp, 0, 0);
+
+				// Compact non-zero samples into a list, so we only need to download the list instead of the entire speed map
+				if (cfg.compact) {
+					if (sboCompactCap[current_speed] < compactCap) { //Grown by a busy frame, the list of a frame in flight keeps its size until its slot is used again
+						gl_storageBuffer_resize(&sboCompact[current_speed], 2 * sizeof(uint32_t) + compactCap * sizeof(compactData[0][0]), gl_usage_stream);
+						sboCompactCap[current_speed] = compactCap;
+					}
+					gl_storageBuffer_update(&sboCompact[current_speed], 0, sizeof(uint32_t), (const uint32_t[1]){0}); //Reset counter
+					gl_storageBuffer_bind(&sboCompact[current_speed], SBO_COMPACT);
+					gl_program_use(&program_compact.pid);
+					gl_texture_bind(&fb_speed[current_speed].tex, program_compact.src, 0);
+					gl_program_dispatch(program_compact.groups);
+					if (compactSynch[current_speed])
+						gl_synchDelete(compactSynch[current_speed]);
+					compactSynch[current_speed] = gl_synchSet();
+				}
 
-			#ifdef VERBOSE_TIME
-				gl_synchWait(synch_blur, GL_SYNCH_TIMEOUT); //Here we are benchmark, let's assume it will success, we are sure after the function test
-				gl_synchDelete(synch_blur);
-				benchmark_current[benchmark_currentIdx++] = nanotime();
-
-				gl_synchWait(synch_changingDetect, GL_SYNCH_TIMEOUT);
-				gl_synchDelete(synch_changingDetect);
-				benchmark_current[benchmark_currentIdx++] = nanotime();
-				gl_synchWait(synch_changingFix, GL_SYNCH_TIMEOUT);
-				gl_synchDelete(synch_changingFix);
-				benchmark_current[benchmark_currentIdx++] = nanotime();
-
-				gl_synchWait(synch_edgeRefine, GL_SYNCH_TIMEOUT);
-				gl_synchDelete(synch_edgeRefine);
-				benchmark_current[benchmark_currentIdx++] = nanotime();
-
-				gl_synchWait(synch_p2o, GL_SYNCH_TIMEOUT);
-				gl_synchDelete(synch_p2o);
-				benchmark_current[benchmark_currentIdx++] = nanotime();
-				gl_synchWait(synch_measure, GL_SYNCH_TIMEOUT);
-				gl_synchDelete(synch_measure);
-				benchmark_current[benchmark_currentIdx++] = nanotime();
-				gl_synchWait(synch_o2p, GL_SYNCH_TIMEOUT);
-				gl_synchDelete(synch_o2p);
-				benchmark_current[benchmark_currentIdx++] = nanotime();
-
-				gl_synchWait(synch_sample, GL_SYNCH_TIMEOUT);
-				gl_synchDelete(synch_sample);
-				benchmark_current[benchmark_currentIdx++] = nanotime();
-			#endif
+				// Mark rows having non-zero samples, so CPU-side scan can skip empty rows without reading them
+				#ifdef USE_ROW_OCCUPANCY
+				if (!cfg.compact) {
+					gl_setViewport(zeros, (const uint[2]){OCCUPANCY_SPAN, sizeData[1]});
+					gl_frameBuffer_bind(&fb_occupancy[current_speed].fbo, gl_frameBuffer_clearAll);
+					gl_program_use(&program_occupancy.pid);
+					gl_texture_bind(&fb_speed[current_speed].tex, program_occupancy.src, 0);
+					gl_mesh_draw(&mesh_final, 0, 0);
+					gl_setViewport(zeros, sizeData);
+				}
+				#endif
+				gl_timer_stamp(&benchmark_timer);
+			}
 
-			// Download data from previous frame
-			#ifdef USE_PBO_DOWNLOAD //Background download starts at beginning of frame
-				//gl_synchWait(pboDownloadSynch, GL_SYNCH_TIMEOUT);
-				//gl_synchDelete(pboDownloadSynch);
-				speedData = gl_pixelBuffer_downloadFinish(sizeData[0] * sizeData[1] * sizeof(speedData[0][0]));
-			#else //Command queue of previous frame should be finished by now
-				gl_frameBuffer_download(speedData, &fb_speed[previous_speed].fbo, fb_speed->format, 0, zeros, sizeData); //Download current speed data so we can process in next iteration (blocking op)
-			#endif
+			benchmark_current[benchmark_currentIdx++] = nanotime(); //All passes issued, GPU time is measured by timer without waiting
 
-			#ifdef VERBOSE_TIME
-				benchmark_current[benchmark_currentIdx++] = nanotime(); //Download
-			#endif
+			// Download data from the oldest frame in flight (current frame in low latency mode) and hand it to analysis thread, download buffers are released in submission order once analyzed
+			void downloadPoll(gl_synch synch) { //Low latency mode: poll until GPU finishes the current frame instead of blocking in the driver, reader and analysis threads keep working meanwhile
+				while (gl_synchWait(synch, 0) == gl_synch_timeout)
+					sched_yield();
+			}
+			if (cfg.lowLatency) {
+				if (cfg.pboDownload) {
+					pboDownloadPush();
+				} else {
+					gl_synch downloadSynch = gl_synchSet();
+					downloadPoll(downloadSynch);
+					gl_synchDelete(downloadSynch);
+				}
+			}
+			if (cfg.pboDownload) { //Background download starts at beginning of frame (after the current frame in low latency mode), mapped when GPU finishes it, unmapped when analysis finishes it
+				void pboDownloadRelease() { //Unmap PBOs of analyzed frames, oldest first
+					for (uint i = th_analysis_collect(); i; i--) {
+						struct PboDownload* pboDownloadOld = &pboDownload[pboDownloadTail];
+						#ifdef USE_ROW_OCCUPANCY
+							gl_pixelBuffer_downloadDiscard(&pboDownloadOld->occupancy);
+						#endif
+						gl_pixelBuffer_downloadDiscard(&pboDownloadOld->speed);
+						pboDownloadTail = (pboDownloadTail + 1) % pboDownloadDepth;
+						pboDownloadCnt--;
+						pboDownloadMapped--;
+					}
+				}
+				pboDownloadRelease();
+				while (pboDownloadMapped < pboDownloadCnt) { //Map all finished downloads, oldest first; wait for GPU only if the ring is full and analysis thread has nothing to free
+					struct PboDownload* pboDownloadOld = &pboDownload[(pboDownloadTail + pboDownloadMapped) % pboDownloadDepth];
+					if (cfg.lowLatency) { //Current frame is the newest, all downloads must be mapped in this frame
+						downloadPoll(pboDownloadOld->synch);
+					} else if (pboDownloadCnt < pboDownloadDepth || pboDownloadMapped) {
+						if (gl_synchWait(pboDownloadOld->synch, 0) == gl_synch_timeout)
+							break;
+					} else if (gl_synchWait(pboDownloadOld->synch, GL_SYNCH_TIMEOUT) != gl_synch_done) {
+						pboDownloadStall++;
+					}
+					gl_synchDelete(pboDownloadOld->synch);
+					pboDownloadOld->synch = NULL;
+					pboDownloadMapped++;
+
+					analysis_job job = {.frame = pboDownloadOld->frame, .source = analysis_source_speedmap, .arrival = pboDownloadOld->arrival};
+					#ifdef USE_ROW_OCCUPANCY
+						job.occupancy = gl_pixelBuffer_downloadFinish(&pboDownloadOld->occupancy, road_boxROIpx.size[1] * OCCUPANCY_SPAN); //Scan all rows if fail
+					#endif
+					job.data = gl_pixelBuffer_downloadFinish(&pboDownloadOld->speed, road_boxROIpx.size[0] * road_boxROIpx.size[1] * 2);
+					if (!job.data) //Fail to map, keep the frame in order with an empty list
+						job = (analysis_job){.frame = pboDownloadOld->frame, .source = analysis_source_list, .arrival = pboDownloadOld->arrival};
+					else if (speedmapDump)
+						fwrite(job.data, 2, road_boxROIpx.size[0] * road_boxROIpx.size[1], speedmapDump);
+					th_analysis_submit(job);
+				}
+				if (pboDownloadCnt == pboDownloadDepth) { //All PBOs are with analysis thread, wait for one so there is a free PBO for next frame
+					th_analysis_wait();
+					pboDownloadRelease();
+				}
+			} else { //Download to a free CPU-side buffer, wait for analysis thread if all are in use
+				analysisBufferCnt -= th_analysis_collect();
+				if (analysisBufferCnt == cfg.analysisQueue) {
+					th_analysis_wait();
+					analysisBufferCnt -= th_analysis_collect();
+				}
+				if (cfg.backend == backend_cpu) { //Speed map of the frame processed by CPU in this loop
+					uint8_t (* const speedBuffer)[2] = cpuSpeedData[analysisBufferNext];
+					cpu_download(cpu, speedBuffer, road_boxROIpx.offset, road_boxROIpx.size);
+					if (speedmapDump)
+						fwrite(speedBuffer, sizeof(speedBuffer[0]), road_boxROIpx.size[0] * road_boxROIpx.size[1], speedmapDump);
+					th_analysis_submit((analysis_job){.frame = frameCnt + 1, .source = analysis_source_speedmap, .data = speedBuffer, .arrival = frameArrival[(frameCnt + 1) % arrayLength(frameArrival)]});
+				} else {
+					if (cfg.compact) { //Download counter first, download the list only if not empty
+						if (compactSynch[download_speed]) { //Map only after GPU passes the fence, so the map does not block in the driver
+							if (gl_synchWait(compactSynch[download_speed], 0) == gl_synch_timeout) {
+								compactStall++;
+								gl_synchWait(compactSynch[download_speed], GL_SYNCH_TIMEOUT);
+							}
+							gl_synchDelete(compactSynch[download_speed]);
+							compactSynch[download_speed] = NULL;
+						}
+						uint32_t* compactCntPtr = gl_storageBuffer_download(&sboCompact[download_speed], 0, sizeof(uint32_t));
+						uint32_t compactCnt = compactCntPtr ? *compactCntPtr : 0;
+						gl_storageBuffer_downloadDiscard();
+						if (compactCnt > sboCompactCap[download_speed]) { //List is cut (which samples are kept depends on the order of atomic add), grow and compact the frame again, its speed map is kept until its slot is used again
+							compactOverflow++;
+							while (compactCap < compactCnt)
+								compactCap *= 2;
+							gl_storageBuffer_resize(&sboCompact[download_speed], 2 * sizeof(uint32_t) + compactCap * sizeof(compactData[0][0]), gl_usage_stream);
+							sboCompactCap[download_speed] = compactCap;
+							gl_storageBuffer_update(&sboCompact[download_speed], 0, sizeof(uint32_t), (const uint32_t[1]){0});
+							gl_storageBuffer_bind(&sboCompact[download_speed], SBO_COMPACT);
+							gl_program_use(&program_compact.pid);
+							gl_texture_bind(&fb_speed[download_speed].tex, program_compact.src, 0);
+							gl_program_dispatch(program_compact.groups);
+							compactCntPtr = gl_storageBuffer_download(&sboCompact[download_speed], 0, sizeof(uint32_t)); //Wait for GPU, rare
+							compactCnt = compactCntPtr ? *compactCntPtr : 0;
+							gl_storageBuffer_downloadDiscard();
+						}
+						if (compactDataCap[analysisBufferNext] < compactCnt) { //Not in use by analysis thread
+							uint32_t (* new)[2] = realloc(compactData[analysisBufferNext], compactCap * sizeof(compactData[0][0]));
+							if (new) {
+								compactData[analysisBufferNext] = new;
+								compactDataCap[analysisBufferNext] = compactCap;
+							} else {
+								error("Fail to grow buffer to download compact speed sample, %u of %u samples are kept", compactDataCap[analysisBufferNext], compactCnt);
+								compactCnt = compactDataCap[analysisBufferNext];
+							}
+						}
+						uint32_t (* const compactBuffer)[2] = compactData[analysisBufferNext];
+						if (compactCnt) {
+							void* compactPtr = gl_storageBuffer_download(&sboCompact[download_speed], 2 * sizeof(uint32_t), compactCnt * sizeof(compactBuffer[0]));
+							if (compactPtr)
+								memcpy(compactBuffer, compactPtr, compactCnt * sizeof(compactBuffer[0]));
+							else
+								compactCnt = 0;
+							gl_storageBuffer_downloadDiscard();
+						}
+						th_analysis_submit((analysis_job){.frame = downloadFrame, .source = analysis_source_list, .data = compactBuffer, .count = compactCnt, .arrival = frameArrival[downloadFrame % arrayLength(frameArrival)]}); //Sorted by analysis thread
+					} else { //Command queue of previous frame should be finished by now, download current speed data so we can process in next iteration (blocking op)
+						uint8_t (* const speedBuffer)[2] = speedData[analysisBufferNext];
+						#ifdef USE_ROW_OCCUPANCY //Small, 4 bytes per row. Then download occupied rows only, consecutive rows in one call
+							uint8_t (* const occupancyBuffer)[OCCUPANCY_SPAN] = occupancyData[analysisBufferNext];
+							gl_frameBuffer_download(&fb_occupancy[download_speed].fbo, occupancyBuffer, fb_occupancy->format, 0, (const uint[2]){0, road_boxROIpx.offset[1]}, (const uint[2]){OCCUPANCY_SPAN, road_boxROIpx.size[1]});
+							for (uint y = 0, run = 0; y <= road_boxROIpx.size[1]; y++) {
+								uint32_t occupied = 0;
+								if (y < road_boxROIpx.size[1])
+									memcpy(&occupied, occupancyBuffer[y], sizeof(occupied));
+								if (occupied) {
+									run++;
+									continue;
+								}
+								if (run)
+									gl_frameBuffer_download(&fb_speed[download_speed].fbo, speedBuffer + (y - run) * road_boxROIpx.size[0], fb_speed->format, 0, (const uint[2]){road_boxROIpx.offset[0], road_boxROIpx.offset[1] + y - run}, (const uint[2]){road_boxROIpx.size[0], run});
+								if (speedmapDump && y < road_boxROIpx.size[1]) //Not downloaded, keep the dump clean
+									memset(speedBuffer + y * road_boxROIpx.size[0], 0, road_boxROIpx.size[0] * sizeof(speedBuffer[0]));
+								run = 0;
+							}
+						#else
+							gl_frameBuffer_download(&fb_speed[download_speed].fbo, speedBuffer, fb_speed->format, 0, road_boxROIpx.offset, road_boxROIpx.size);
+						#endif
+						if (speedmapDump)
+							fwrite(speedBuffer, sizeof(speedBuffer[0]), road_boxROIpx.size[0] * road_boxROIpx.size[1], speedmapDump);
+						th_analysis_submit((analysis_job){
+							.frame = downloadFrame,
+							.source = analysis_source_speedmap,
+							.data = speedBuffer,
+							.arrival = frameArrival[downloadFrame % arrayLength(frameArrival)],
+							#ifdef USE_ROW_OCCUPANCY
+								.occupancy = occupancyBuffer[0]
+							#endif
+						});
+					}
+				}
+				analysisBufferNext = (analysisBufferNext + 1) % cfg.analysisQueue;
+				analysisBufferCnt++;
+			}
 
-			// Analysis the processed data
-			output_data speedAnalysisObj[SHADER_SPEEDOMETER_CNT]; //Not too mush data, OK to use stack
-
-			output_data* objPtr = speedAnalysisObj;
-			float* instancePtr = instance_speedometer_data;
-			int limit = SHADER_SPEEDOMETER_CNT;
-			unsigned int edgeTop = road_boxROI.top * sizeData[1], edgeBottom = road_boxROI.bottom * sizeData[1];
-			unsigned int edgeLeft = road_boxROI.left * sizeData[0], edgeRight = road_boxROI.right * sizeData[0];
-			for (unsigned int y = edgeTop; y <= edgeBottom && limit; y++) { //Get number speed data from downloaded framebuffer
-				for (unsigned int x = edgeLeft; x <= edgeRight && limit; x++) {
-					int16_t speed = speedData[y][x][0];
-					int16_t screenDy = speedData[y][x][1];
-					if (speed > 1) {
-						vec2 coordNorm = { (float)x / sizeData[0] , (float)y / sizeData[1] };
-						ivec2 coordScreen = {x,y};
-						ivec2 coordRoadmap = { x * roadmap.header.width / sizeData[0] , y * roadmap.header.height / sizeData[1] };
-						struct Roadmap_Table1 geoData = roadmap.t1[ coordRoadmap.y * roadmap.header.width + coordRoadmap.x ];
-						*objPtr++ = (output_data){
-							.rx = geoData.px,
-							.ry = geoData.py,
-							.sx = coordScreen.x,
-							.sy = coordScreen.y,
-							.speed = speed,
-							.osy = screenDy - 128
-						};
-						*instancePtr++ = coordNorm.x;
-						*instancePtr++ = coordNorm.y;
-						*instancePtr++ = speed;
-//						*instancePtr++ = abs(screenDy - 128);
-						limit--;
+			// Check mode: compare speed map of the current frame by GPU (wait for GPU) and by CPU (processed in last loop), then CPU processes the next frame
+			if (cfg.backend == backend_check) {
+				if (cpuFrameCnt) {
+					gl_frameBuffer_download(&fb_speed[current_speed].fbo, cpuCheckData[0], fb_speed->format, 0, road_boxROIpx.offset, road_boxROIpx.size);
+					cpu_download(cpu, cpuCheckData[1], road_boxROIpx.offset, road_boxROIpx.size);
+					unsigned int diff = 0;
+					for (uint i = 0; i < road_boxROIpx.size[0] * road_boxROIpx.size[1]; i++)
+						diff += cpuCheckData[0][i][0] != cpuCheckData[1][i][0] || cpuCheckData[0][i][1] != cpuCheckData[1][i][1];
+					if (diff) {
+						info("CPU check: frame %u, %u pixels differ", frameCnt, diff);
+						cpuCheckFrame++;
+						cpuCheckPixel += diff;
 					}
+					cpuCheckCnt++;
 				}
+				cpuProcess();
 			}
-			#ifdef USE_PBO_DOWNLOAD
-				gl_pixelBuffer_downloadDiscard();
-			#endif
 
-			#ifdef VERBOSE_TIME
-				benchmark_current[benchmark_currentIdx++] = nanotime(); //All done except display
-			#endif
+			benchmark_current[benchmark_currentIdx++] = nanotime(); //Download
+
+			// Analysis the processed data, done by analysis thread, which also writes the result to output
 
-			// Render the analysis result and write to output
-			int objCnt = SHADER_SPEEDOMETER_CNT - limit;
-			#ifndef HEADLESS //Clean display, disabled in headless mode
+			// Render the analysis result (result is written to output by analysis thread)
+			if (!cfg.headless) { //Clean display and upload speed data to display, disabled in headless mode
+				int analysisDisplayCnt = th_analysis_display(&instance_speedometer_data, &instance_speedometer_cap);
+				if (analysisDisplayCnt >= 0) //Keep the last analyzed frame if analysis thread has nothing new
+					displayCnt = analysisDisplayCnt;
 				gl_frameBuffer_bind(&fb_display.fbo, gl_frameBuffer_clearAll);
-			#endif
-			if (objCnt) {
-				#ifndef HEADLESS //Upload speed data to display, disabled in headless mode
-					gl_frameBuffer_bind(&fb_display.fbo, gl_frameBuffer_clearAll);
-					gl_mesh_updateInstances(&mesh_display, instance_speedometer_data, 0, objCnt * 3);
+				if (displayCnt) {
+					if (mesh_displayCap < instance_speedometer_cap) { //Grow with instance_speedometer_data
+						mesh_displayCap = instance_speedometer_cap;
+						gl_mesh_resizeInstances(&mesh_display, mesh_displayCap * 3);
+					}
+					gl_mesh_updateInstances(&mesh_display, instance_speedometer_data, 0, displayCnt * 3);
 					gl_program_use(&program_display.pid);
-					gl_mesh_draw(&mesh_display, 0, objCnt);
-				#endif
-				th_output_write(frameCnt - 1, objCnt, speedAnalysisObj);
+					gl_mesh_draw(&mesh_display, 0, displayCnt);
+				}
 			}
 
-//			#define RESULT fb_stageA
-//			#define RESULT fb_stageB
+//			#define RESULT fb_stageA[current_speed]
+//			#define RESULT fb_stageB[current_speed]
 //			#define RESULT fb_raw[current]
 //			#define RESULT fb_object[current_obj]
 //			#define RESULT fb_speed[current_speed]
@@ -857,14 +1888,16 @@ int main(int argc, char* argv[]) {
 //			#define RESULT fb_check
 
 			// Draw final result on screen
-			#ifndef HEADLESS //Draw result on display, disabled in headless mode
+			if (!cfg.headless) { //Draw result on display, disabled in headless mode
 				gl_setViewport(zeros, winsizeNcursor.framesize);
 				gl_frameBuffer_bind(NULL, 0);
 				gl_program_use(&program_final.pid);
-				gl_texture_bind(&fb_raw[current].tex, program_final.orginal, 0);
+				gl_texture_bind(cfg.backend == backend_cpu ? &texture_orginalBuffer[current] : &fb_raw[current].tex, program_final.orginal, 0); //Blurred video is not on GPU in CPU backend
 				gl_texture_bind(&RESULT.tex, program_final.result, 1);
 				gl_mesh_draw(&mesh_final, 0, 0);
-			#endif
+			}
+			gl_timer_stamp(&benchmark_timer);
+			benchmark_current[benchmark_currentIdx++] = nanotime(); //Display
 
 			#ifdef VERBOSE_TIME
 				uint64_t timestampRenderEnd = nanotime();
@@ -875,15 +1908,24 @@ int main(int argc, char* argv[]) {
 			#endif
 			
 			th_reader_wait(); //Wait reader thread finish uploading frame data
-			#ifdef USE_PBO_UPLOAD
+			frameArrival[(frameCnt + 2) % arrayLength(frameArrival)] = th_reader_timestamp();
+			if (cfg.pboUpload)
 				gl_pixelBuffer_updateFinish();
-			#endif
 
-			#ifdef VERBOSE_TIME
-				benchmark_current[benchmark_currentIdx++] = nanotime(); //All done include display
-				memcpy(benchmark + frameCnt, benchmark_current, sizeof(benchmark_current));
-				if (frameCnt == 600) gl_close(1);
-			#endif
+			benchmark_current[benchmark_currentIdx++] = nanotime(); //All done include display
+			if (benchmark) {
+				gl_timer_frameEnd(&benchmark_timer, frameCnt);
+				if (benchmarkEnd == UINT_MAX && !th_reader_timestamp())
+					benchmarkEnd = frameCnt + 2; //End of input, the frame read in this loop (processed 2 loops later) is not from the input
+				if (frameCnt < benchmarkEnd) {
+					benchmark_frame(benchmark, frameCnt, benchmark_current[0], benchmark_current[BENCHMARK_CPU_CNT]);
+					for (uint i = 0; i < BENCHMARK_CPU_CNT; i++)
+						benchmark_stage(benchmark, frameCnt, i, benchmark_current[i + 1] - benchmark_current[i]);
+				}
+				benchmarkGpuRead(0);
+				if (benchmarkEnd != UINT_MAX && frameCnt + 1 >= benchmarkEnd + cfg.speedDownloadLatency) //Quit once the last measured frame is downloaded
+					gl_close(1);
+			}
 
 			frameCnt++;
 		} else {
@@ -900,35 +1942,57 @@ int main(int argc, char* argv[]) {
 			usleep(50000);
 		}
 
-		#ifndef HEADLESS //Do not swap buffer if in headless mode
+		if (!cfg.headless) //Do not swap buffer if in headless mode
 			gl_drawEnd(winTitle);
-		#endif
 	}
 
 	/* Free all resources, house keeping */
 	status = EXIT_SUCCESS;
 label_exit:
 
+	if (benchmark) {
+		benchmarkGpuRead(1); //Frames in flight
+		if (benchmark_timer.drop)
+			info("GPU timer: %u frames not read in time", benchmark_timer.drop);
+	}
+	gl_timer_delete(&benchmark_timer);
+
 	gl_program_delete(&program_final.pid);
 	gl_program_delete(&program_display.pid);
+	gl_program_delete(&program_occupancy.pid);
+	gl_program_delete(&program_compact.pid);
 	gl_program_delete(&program_sample.pid);
 	gl_program_delete(&program_measure.pid);
+	gl_program_delete(&program_fusedEdge.pid);
 	gl_program_delete(&program_edgeRefine.pid);
+	gl_program_delete(&program_edgeRefineScan.pid);
+	gl_program_delete(&program_objectFixScan.pid);
 	gl_program_delete(&program_objectFix.pid);
 	gl_program_delete(&program_changingSensor.pid);
 	gl_program_delete(&program_edgeFilter.pid);
+	gl_program_delete(&program_temporalFilter.pid);
 	gl_program_delete(&program_blurFilter.pid);
 	gl_program_delete(&program_project.pid);
 	gl_program_delete(&program_roadmapCheck.pid);
 
 	gl_texture_delete(&fb_check.tex);
 	gl_frameBuffer_delete(&fb_check.fbo);
-	gl_texture_delete(&fb_stageB.tex);
-	gl_frameBuffer_delete(&fb_stageB.fbo);
-	gl_texture_delete(&fb_stageA.tex);
-	gl_frameBuffer_delete(&fb_stageA.fbo);
+	for (uint i = arrayLength(fb_edge); i; i--) {
+		gl_texture_delete(&fb_edge[i-1].tex);
+		gl_frameBuffer_delete(&fb_edge[i-1].fbo);
+	}
+	for (uint i = arrayLength(fb_stageA); i; i--) {
+		gl_texture_delete(&fb_stageB[i-1].tex);
+		gl_frameBuffer_delete(&fb_stageB[i-1].fbo);
+		gl_texture_delete(&fb_stageA[i-1].tex);
+		gl_frameBuffer_delete(&fb_stageA[i-1].fbo);
+	}
 	gl_texture_delete(&fb_display.tex);
 	gl_frameBuffer_delete(&fb_display.fbo);
+	for (uint i = arrayLength(fb_occupancy); i; i--) {
+		gl_texture_delete(&fb_occupancy[i-1].tex);
+		gl_frameBuffer_delete(&fb_occupancy[i-1].fbo);
+	}
 	for (uint i = arrayLength(fb_speed); i; i--) {
 		gl_texture_delete(&fb_speed[i-1].tex);
 		gl_frameBuffer_delete(&fb_speed[i-1].fbo);
@@ -944,48 +2008,89 @@ label_exit:
 	
 	gl_mesh_delete(&mesh_final);
 
+	th_analysis_destroy(); //Pending jobs are written to output, download buffers are not used after this
+	if (cpu) {
+		char passTime[256] = "";
+		for (uint i = 0, len = 0; i < cpu_pass_cnt && cpuFrameCnt && len < sizeof(passTime); i++)
+			len += snprintf(passTime + len, sizeof(passTime) - len, " %s %.3f", cpu_passName(i), cpuTimeTotal[i] / 1e6 / cpuFrameCnt);
+		info("CPU backend: %u frames, %u threads, mean time of each pass (ms):%s", cpuFrameCnt, cpu_threads(cpu), passTime);
+		if (cfg.backend == backend_check)
+			info("CPU check: %u frames compared, %u frames differ (%u pixels)", cpuCheckCnt, cpuCheckFrame, cpuCheckPixel);
+	}
+	cpu_destroy(cpu);
+	for (uint i = ANALYSIS_QUEUE_MAX; i; i--)
+		free(cpuSpeedData[i-1]);
+	free(cpuCheckData[1]);
+	free(cpuCheckData[0]);
 	th_output_write(0, -1, NULL);
 	th_output_destroy();
-	#ifdef USE_PBO_DOWNLOAD
-		gl_pixelBuffer_delete(&pboDownload);
-//		gl_synchDelete(pboDownloadSynch);
-	#else
-		free(speedData);
-	#endif
+	for (uint i = ANALYSIS_QUEUE_MAX; i; i--)
+		free(compactData[i-1]);
+	if (cfg.compact)
+		info("Speed map download: %u stalls in %u frames, compact list", compactStall, frameCnt);
+	if (compactOverflow)
+		info("Speed map download: %u frames over compact list capacity, compacted again, capacity %u", compactOverflow, compactCap);
+	for (uint i = arrayLength(compactSynch); i; i--) {
+		if (compactSynch[i-1])
+			gl_synchDelete(compactSynch[i-1]);
+	}
+	for (uint i = arrayLength(sboCompact); i; i--)
+		gl_storageBuffer_delete(&sboCompact[i-1]);
+	if (pboDownload) {
+		info("Speed map download: %u stalls in %u frames, %u PBOs", pboDownloadStall, frameCnt, pboDownloadDepth);
+		for (uint i = pboDownloadDepth; i; i--) {
+			if (pboDownload[i-1].synch)
+				gl_synchDelete(pboDownload[i-1].synch);
+			#ifdef USE_ROW_OCCUPANCY
+				gl_pixelBuffer_delete(&pboDownload[i-1].occupancy);
+			#endif
+			gl_pixelBuffer_delete(&pboDownload[i-1].speed);
+		}
+	}
+	free(pboDownload);
+	for (uint i = ANALYSIS_QUEUE_MAX; i; i--) {
+		free(speedData[i-1]);
+		#ifdef USE_ROW_OCCUPANCY
+			free(occupancyData[i-1]);
+		#endif
+	}
+	if (speedmapDump)
+		fclose(speedmapDump);
 
 	gl_mesh_delete(&mesh_display);
 	free(instance_speedometer_data);
 	gl_texture_delete(&texture_speedometer);
 
+	gl_texture_delete(&texture_focus);
+	gl_texture_delete(&texture_run);
+	gl_texture_delete(&texture_gap[1]);
+	gl_texture_delete(&texture_gap[0]);
 	gl_texture_delete(&texture_roadmap);
+	gl_mesh_delete(&mesh_perspMargin);
 	gl_mesh_delete(&mesh_ortho);
 	gl_mesh_delete(&mesh_persp);
 	roadmap_destroy(&roadmap);
 
 	th_reader_destroy();
+	th_event_destroy(); //After reader, no more frames will be captured
 	gl_texture_delete(&texture_orginalBuffer[1]);
 	gl_texture_delete(&texture_orginalBuffer[0]);
-	#ifdef USE_PBO_UPLOAD
-		gl_pixelBuffer_delete(&pboUpload[1]);
-		gl_pixelBuffer_delete(&pboUpload[0]);
-	#else
-		free(rawData[0]);
-		free(rawData[1]);
-	#endif
+	gl_pixelBuffer_delete(&pboUpload[1]);
+	gl_pixelBuffer_delete(&pboUpload[0]);
+	free(rawData[0]);
+	free(rawData[1]);
 
 	gl_destroy();
-
-	#ifdef VERBOSE_TIME
-		FILE* fd = fopen("benchmark.csv", "w");
-		for (int i = 0; i < 600; i++) {
-			for (int j = 0; j < 15; j++) {
-				fprintf(fd, "%f,", benchmark[i][j] / 1e6); //ns to ms
-			}
-			fprintf(fd, "%f\n", benchmark[i][15] / 1e6);
-		}
-		fclose(fd);
-		free(benchmark);
-	#endif
+	config_destroy(config);
+
+	if (benchmark) { //Report of the measured frames, and time of each step of every frame in ms (GPU time is empty if not read)
+		benchmark_report(benchmark, stderr);
+		if (benchmarkArg.json && !benchmark_writeJson(benchmark, benchmarkArg.json))
+			error("Fail to write benchmark report to %s", benchmarkArg.json);
+		if (!benchmark_writeCsv(benchmark, BENCHMARK_CSV))
+			error("Fail to write benchmark record to %s", BENCHMARK_CSV);
+		benchmark_destroy(benchmark);
+	}
 
 	info("\n%u frames displayed.\n", frameCnt);
 	return status;
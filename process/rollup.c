@@ -0,0 +1,176 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <math.h>
+
+#include "rollup.h"
+
+struct Rollup_Stat {
+	uint32_t count, sum;
+	uint8_t min, max;
+	uint16_t late;
+	uint32_t histogram[256];
+};
+
+struct Rollup_ClassDataStructure {
+	FILE* fp;
+	unsigned int interval, delay;
+	float laneOrigin, laneWidth;
+	unsigned int laneCnt;
+	unsigned int openCnt; //Number of intervals waiting for late vehicles
+	uint32_t first; //Index of oldest open interval
+	uint32_t last; //Index of latest interval seen
+	int started; //First interval is set by the first call
+	struct Rollup_Stat* stat; //[openCnt][laneCnt], interval i at (i % openCnt)
+};
+
+static inline struct Rollup_Stat* rollup_slot(const Rollup this, const uint32_t index) {
+	return &this->stat[(index % this->openCnt) * this->laneCnt];
+}
+
+/** Write the oldest open interval and reuse its slot for the next one
+ */
+static void rollup_write(const Rollup this) {
+	struct Rollup_Stat* stat = rollup_slot(this, this->first);
+	for (unsigned int lane = 0; lane < this->laneCnt; lane++) {
+		struct Rollup_Stat* s = &stat[lane];
+		rollup_bin bins[256];
+		uint16_t binCnt = 0;
+		for (unsigned int speed = 0; speed < 256; speed++) {
+			if (s->histogram[speed])
+				bins[binCnt++] = (rollup_bin){.speed = speed, .count = s->histogram[speed] > UINT16_MAX ? UINT16_MAX : s->histogram[speed]};
+		}
+		rollup_record record = {
+			.index = this->first,
+			.lane = lane,
+			.binCnt = binCnt,
+			.count = s->count, .sum = s->sum,
+			.min = s->min, .max = s->max,
+			.late = s->late
+		};
+		fwrite(&record, sizeof(record), 1, this->fp);
+		fwrite(bins, sizeof(rollup_bin), binCnt, this->fp);
+	}
+	fflush(this->fp); //One write per interval, let reader see it now
+
+	memset(stat, 0, this->laneCnt * sizeof(struct Rollup_Stat));
+	this->first++;
+}
+
+Rollup rollup_init(const char* const file, const unsigned int interval, const unsigned int delay, const float fps, const float laneOrigin, const float laneWidth, const unsigned int laneCnt, char** const statue) {
+	if (!interval || !laneCnt || laneCnt > UINT16_MAX || !(laneWidth > 0.0f)) {
+		if (statue)
+			*statue = "Bad interval or lane config";
+		return NULL;
+	}
+
+	Rollup this = malloc(sizeof(struct Rollup_ClassDataStructure));
+	if (!this) {
+		if (statue)
+			*statue = "Fail to create rollup class object data structure";
+		return NULL;
+	}
+	*this = (struct Rollup_ClassDataStructure){
+		.fp = NULL,
+		.interval = interval, .delay = delay,
+		.laneOrigin = laneOrigin, .laneWidth = laneWidth,
+		.laneCnt = laneCnt,
+		.openCnt = (delay + interval - 1) / interval + 1, //Current interval plus intervals still within delay
+		.first = 0, .last = 0,
+		.started = 0,
+		.stat = NULL
+	};
+
+	this->stat = calloc(this->openCnt * laneCnt, sizeof(struct Rollup_Stat));
+	if (!this->stat) {
+		if (statue)
+			*statue = "Fail to allocate memory for rollup statistics";
+		rollup_destroy(this);
+		return NULL;
+	}
+
+	this->fp = fopen(file, "ab");
+	if (!this->fp) {
+		if (statue)
+			*statue = "Fail to open rollup file";
+		rollup_destroy(this);
+		return NULL;
+	}
+	if (!ftell(this->fp)) { //New file
+		rollup_fileHeader header = {
+			.magic = ROLLUP_MAGIC,
+			.version = ROLLUP_VERSION,
+			.laneCnt = laneCnt,
+			.interval = interval,
+			.fps = fps
+		};
+		if (!fwrite(&header, sizeof(header), 1, this->fp)) {
+			if (statue)
+				*statue = "Fail to write rollup file header";
+			rollup_destroy(this);
+			return NULL;
+		}
+	}
+
+	return this;
+}
+
+void rollup_add(const Rollup this, const int frame, const float x, const int16_t speed) {
+	float lane = floorf((x - this->laneOrigin) / this->laneWidth);
+	if (!(lane >= 0.0f && lane < this->laneCnt))
+		return;
+
+	uint32_t index = frame < 0 ? 0 : frame / this->interval;
+	if (!this->started) {
+		this->first = this->last = index;
+		this->started = 1;
+	}
+	if (index > this->last)
+		this->last = index;
+	while (index >= this->first + this->openCnt) //Should not happen if delay is correct, write old intervals to make room
+		rollup_write(this);
+
+	struct Rollup_Stat* s = &rollup_slot(this, index < this->first ? this->first : index)[(unsigned int)lane];
+	uint8_t v = speed < 0 ? 0 : speed > 255 ? 255 : speed;
+	if (!s->count || v < s->min)
+		s->min = v;
+	if (!s->count || v > s->max)
+		s->max = v;
+	s->count++;
+	s->sum += v;
+	s->histogram[v]++;
+	if (index < this->first && s->late < UINT16_MAX)
+		s->late++;
+}
+
+void rollup_tick(const Rollup this, const int frame) {
+	if (frame == INT_MAX) {
+		while (this->started && this->first <= this->last)
+			rollup_write(this);
+		return;
+	}
+	uint32_t index = frame < 0 ? 0 : frame / this->interval;
+	if (!this->started) { //Write empty intervals from the first frame, so time-series has no hole
+		this->first = this->last = index;
+		this->started = 1;
+	}
+	if (index > this->last)
+		this->last = index;
+	while ((long long int)(this->first + 1) * this->interval + this->delay <= (long long int)frame)
+		rollup_write(this);
+}
+
+void rollup_destroy(const Rollup this) {
+	if (!this)
+		return;
+
+	if (this->fp) {
+		if (this->stat)
+			rollup_tick(this, INT_MAX);
+		fclose(this->fp);
+	}
+	free(this->stat);
+	free(this);
+}
@@ -0,0 +1,86 @@
+/** Class - Rollup.class.
+ * Per-lane, per-interval traffic statistics.
+ * Each vehicle (closed track) is put into an interval by its exit frame, and into a lane by its road-domain x-coord.
+ * For each lane and interval, count, sum, min and max of speed, and a speed histogram are kept.
+ * Speed is 8-bit (see sample shader), so the histogram is an exact quantile sketch, and it is mergeable: histograms of
+ * different intervals (or lanes) can be added to get the statistics of a longer period (or the whole road).
+ * When an interval is complete, its statistics are appended to a binary file.
+ */
+
+#ifndef INCLUDE_ROLLUP_H
+#define INCLUDE_ROLLUP_H
+
+#include <inttypes.h>
+
+#define ROLLUP_MAGIC "SCRU"
+#define ROLLUP_VERSION 1
+
+/** File header, at the beginning of the file
+ */
+typedef struct Rollup_FileHeader {
+	char magic[4]; //ROLLUP_MAGIC
+	uint16_t version; //ROLLUP_VERSION
+	uint16_t laneCnt; //Number of lanes
+	uint32_t interval; //Length of interval in frames
+	float fps; //Frame per second, to convert interval into time
+} rollup_fileHeader;
+
+/** Record of one lane in one interval. For each interval, there is one record for each lane, including empty lane.
+ * Followed by binCnt bins of the speed histogram.
+ */
+typedef struct Rollup_Record {
+	uint32_t index; //Interval index, interval starts at frame = index * interval
+	uint16_t lane; //Lane index [0, laneCnt)
+	uint16_t binCnt; //Number of non-zero bins followed
+	uint32_t count; //Number of vehicles
+	uint32_t sum; //Sum of speed (km/h)
+	uint8_t min, max; //Speed (km/h), 0 if no vehicle
+	uint16_t late; //Number of vehicles reported after the record of its interval is written, they are counted in this record instead
+} rollup_record;
+
+/** One non-zero bin of speed histogram
+ */
+typedef struct Rollup_Bin {
+	uint8_t speed; //Speed (km/h)
+	uint8_t reserved;
+	uint16_t count; //Number of vehicles, saturated
+} rollup_bin;
+
+/** Rollup class object data structure
+ */
+typedef struct Rollup_ClassDataStructure* Rollup;
+
+/** Init a rollup object, open (append) the file.
+ * Lane i covers road-domain x-coord [laneOrigin + i * laneWidth, laneOrigin + (i+1) * laneWidth).
+ * @param file File to append the records to; if the file is empty, a header is written first
+ * @param interval Length of interval in frames
+ * @param delay A vehicle may be reported up to this number of frames after its exit frame (tracker timeout), interval is written after this delay
+ * @param fps Frame per second, written in file header
+ * @param laneOrigin Road-domain x-coord (meter) of the left side of the first lane
+ * @param laneWidth Width of lane (meter)
+ * @param laneCnt Number of lanes
+ * @param statue If not NULL, return error message in case this function fail
+ * @return $this(Opaque) rollup class object upon success. If fail, free all resource and return NULL
+ */
+Rollup rollup_init(const char* const file, const unsigned int interval, const unsigned int delay, const float fps, const float laneOrigin, const float laneWidth, const unsigned int laneCnt, char** const statue);
+
+/** Add a vehicle.
+ * @param this This rollup class object
+ * @param frame Frame number of the vehicle (exit frame)
+ * @param x Road-domain x-coord of the vehicle, vehicle outside of all lanes is ignored
+ * @param speed Speed of the vehicle (km/h)
+ */
+void rollup_add(const Rollup this, const int frame, const float x, const int16_t speed);
+
+/** Write all intervals that will not be updated anymore.
+ * @param this This rollup class object
+ * @param frame Current frame number, pass INT_MAX to write all intervals (flush)
+ */
+void rollup_tick(const Rollup this, const int frame);
+
+/** Write all intervals, destroy this rollup class object, frees resources.
+ * @param this This rollup class object
+ */
+void rollup_destroy(const Rollup this);
+
+#endif /* #ifndef INCLUDE_ROLLUP_H */
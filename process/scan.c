@@ -0,0 +1,72 @@
+#include <string.h>
+#include <inttypes.h>
+#if defined(__AVX2__) || defined(__SSE2__)
+	#include <immintrin.h>
+#endif
+
+#include "scan.h"
+
+/* Each step produces a hit mask, bit 2i (SIMD, one bit per byte, speed is the even byte) or bit 16i+15 (SWAR, one bit per 16-bit pixel) is set if pixel i is hit */
+
+unsigned int scan_rowScalar(const uint8_t* const row, const unsigned int left, const unsigned int right, const uint8_t threshold, unsigned int* const xs, const unsigned int limit) {
+	unsigned int cnt = 0;
+	for (unsigned int x = left; x <= right && cnt < limit; x++) {
+		if (row[2 * x] > threshold)
+			xs[cnt++] = x;
+	}
+	return cnt;
+}
+
+unsigned int scan_row(const uint8_t* const row, const unsigned int left, const unsigned int right, const uint8_t threshold, unsigned int* const xs, const unsigned int limit) {
+	unsigned int cnt = 0, x = left;
+	const unsigned int end = right + 1;
+	if (left > right)
+		return 0;
+
+	#if defined(__AVX2__)
+		const __m256i t = _mm256_set1_epi8(threshold), zero = _mm256_setzero_si256();
+		for (; end - x >= 32 && cnt < limit; x += 32) {
+			__m256i a = _mm256_loadu_si256((const __m256i*)(row + 2 * x));
+			__m256i b = _mm256_loadu_si256((const __m256i*)(row + 2 * x + 32));
+			uint32_t ma = ~_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_subs_epu8(a, t), zero)); //Unsigned: speed > t <=> speed - t (saturated) != 0
+			uint32_t mb = ~_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_subs_epu8(b, t), zero));
+			uint64_t m = ( (uint64_t)mb << 32 | ma ) & 0x5555555555555555LLU; //Speed channel only
+			for (; m && cnt < limit; m &= m - 1)
+				xs[cnt++] = x + (__builtin_ctzll(m) >> 1);
+		}
+	#elif defined(__SSE2__)
+		const __m128i t = _mm_set1_epi8(threshold), zero = _mm_setzero_si128();
+		for (; end - x >= 16 && cnt < limit; x += 16) {
+			__m128i a = _mm_loadu_si128((const __m128i*)(row + 2 * x));
+			__m128i b = _mm_loadu_si128((const __m128i*)(row + 2 * x + 16));
+			uint32_t ma = ~_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_subs_epu8(a, t), zero)) & 0xFFFF;
+			uint32_t mb = ~_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_subs_epu8(b, t), zero)) & 0xFFFF;
+			uint32_t m = ( mb << 16 | ma ) & 0x55555555U;
+			for (; m && cnt < limit; m &= m - 1)
+				xs[cnt++] = x + (__builtin_ctz(m) >> 1);
+		}
+	#else //Little-endian: each 16-bit lane is speed | target_yCoord << 8
+		const uint64_t t = (0x7FFFLLU - threshold) * 0x0001000100010001LLU; //speed + 0x7FFF - threshold sets bit 15 if speed > threshold, never carries into next lane
+		for (; end - x >= 4 && cnt < limit; x += 4) {
+			uint64_t w;
+			memcpy(&w, row + 2 * x, sizeof(w));
+			uint64_t m = ( (w & 0x00FF00FF00FF00FFLLU) + t ) & 0x8000800080008000LLU;
+			for (; m && cnt < limit; m &= m - 1)
+				xs[cnt++] = x + (__builtin_ctzll(m) >> 4);
+		}
+	#endif
+
+	if (cnt < limit) //Remaining pixels at the end of the range
+		cnt += scan_rowScalar(row, x, right, threshold, xs + cnt, limit - cnt);
+	return cnt;
+}
+
+const char* scan_isa() {
+	#if defined(__AVX2__)
+		return "AVX2";
+	#elif defined(__SSE2__)
+		return "SSE2";
+	#else
+		return "SWAR";
+	#endif
+}
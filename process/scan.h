@@ -0,0 +1,31 @@
+/** Scan the speed map (RG8: speed, target_yCoord) on CPU side for non-zero samples.
+ * The speed map is mostly empty, the scan is vectorized to skip empty pixels quickly: AVX2 (32 pixels at a time) or
+ * SSE2 (16 pixels at a time) if the compiler targets them, otherwise a portable 64-bit SWAR scan (4 pixels at a time).
+ */
+
+#ifndef INCLUDE_SCAN_H
+#define INCLUDE_SCAN_H
+
+#include <inttypes.h>
+
+/** Find pixels with speed greater than threshold in a row of speed map, in ascending order of x-coord.
+ * @param row Pointer to the first pixel of the row, 2 bytes (speed, target_yCoord) per pixel
+ * @param left Left end of the range (px), inclusive
+ * @param right Right end of the range (px), inclusive
+ * @param threshold Pixel with speed greater than this is returned
+ * @param xs Return x-coord of pixels found
+ * @param limit Max number of pixels to find, size of @param xs
+ * @return Number of pixels found
+ */
+unsigned int scan_row(const uint8_t* const row, const unsigned int left, const unsigned int right, const uint8_t threshold, unsigned int* const xs, const unsigned int limit);
+
+/** Same as scan_row(), but check byte by byte, reference for test and benchmark.
+ */
+unsigned int scan_rowScalar(const uint8_t* const row, const unsigned int left, const unsigned int right, const uint8_t threshold, unsigned int* const xs, const unsigned int limit);
+
+/** Get the name of the instruction set used by scan_row().
+ * @return "AVX2", "SSE2" or "SWAR"
+ */
+const char* scan_isa();
+
+#endif /* #ifndef INCLUDE_SCAN_H */
@@ -16,6 +16,7 @@ in mediump vec2 pxPos;
 out lowp vec4 result; //lowp for RGBA8 video
 
 //#define MONO Get gray-scale result
+//#define BILINEAR Use 4 bilinear taps at the corners of the px instead of 9 texel fetches, same 3*3 weights; src must use linear filter (the program does if this is defined), edge px is repeated instead of 0
 //#define BINARY 0.5 Get black/white image
 //#define BINARY vec4(0.3, 0.4, 0.5, -0.1) //Get black/white image, use different threshold for different channels
 
@@ -25,15 +26,26 @@ void main() {
 	mediump ivec2 pxIdx = ivec2( srcSizeF * pxPos );
 
 	//During accum, may excess lowp range, especially for edge filter when accum may get negative
-	mediump vec4 accum = texelFetchOffset(src, pxIdx, 0, ivec2(-1,-1)) / 16.0;
-	accum += texelFetchOffset(src, pxIdx, 0, ivec2(-1, 0)) /  8.0;
-	accum += texelFetchOffset(src, pxIdx, 0, ivec2(-1,+1)) / 16.0;
-	accum += texelFetchOffset(src, pxIdx, 0, ivec2( 0,-1)) /  8.0;
-	accum += texelFetchOffset(src, pxIdx, 0, ivec2( 0, 0)) /  4.0;
-	accum += texelFetchOffset(src, pxIdx, 0, ivec2( 0,+1)) /  8.0;
-	accum += texelFetchOffset(src, pxIdx, 0, ivec2(+1,-1)) / 16.0;
-	accum += texelFetchOffset(src, pxIdx, 0, ivec2(+1, 0)) /  8.0;
-	accum += texelFetchOffset(src, pxIdx, 0, ivec2(+1,+1)) / 16.0;
+	#ifdef BILINEAR
+		//A tap at the corner of 4 px is their mean, 4 taps give 1/16 for corner, 2/16 for side and 4/16 for center px
+		//highp operands so the tap is exactly at the corner (mediump misses it by up to 1/3 px in 720p), same px as pxIdx
+		highp vec2 idxF = vec2(pxIdx), sizeF = vec2(srcSize);
+		highp vec2 corner = idxF / sizeF, texel = 1.0 / sizeF;
+		mediump vec4 accum = texture(src, corner) / 4.0;
+		accum += texture(src, corner + vec2(texel.x, 0.0)) / 4.0;
+		accum += texture(src, corner + vec2(0.0, texel.y)) / 4.0;
+		accum += texture(src, corner + texel) / 4.0;
+	#else
+		mediump vec4 accum = texelFetchOffset(src, pxIdx, 0, ivec2(-1,-1)) / 16.0;
+		accum += texelFetchOffset(src, pxIdx, 0, ivec2(-1, 0)) /  8.0;
+		accum += texelFetchOffset(src, pxIdx, 0, ivec2(-1,+1)) / 16.0;
+		accum += texelFetchOffset(src, pxIdx, 0, ivec2( 0,-1)) /  8.0;
+		accum += texelFetchOffset(src, pxIdx, 0, ivec2( 0, 0)) /  4.0;
+		accum += texelFetchOffset(src, pxIdx, 0, ivec2( 0,+1)) /  8.0;
+		accum += texelFetchOffset(src, pxIdx, 0, ivec2(+1,-1)) / 16.0;
+		accum += texelFetchOffset(src, pxIdx, 0, ivec2(+1, 0)) /  8.0;
+		accum += texelFetchOffset(src, pxIdx, 0, ivec2(+1,+1)) / 16.0;
+	#endif
 
 	#ifdef MONO
 		mediump float mono = dot(accum.rgb, vec3(0.299, 0.587, 0.114)) * accum.a;
@@ -16,7 +16,9 @@ uniform lowp sampler2D previous; //lowp for RGBA8 video
 in mediump vec2 pxPos;
 out lowp float result; //lowp for enum
 
-#define THRESHOLD 0.2
+#ifndef THRESHOLD
+	#define THRESHOLD 0.2
+#endif
 //#define THRESHOLD vec4(0.05, 0.03, 0.05, -0.1) //Use different threshold for different channels
 
 //lowp vec3 rgb2hsv(lowp vec3 c) {
@@ -0,0 +1,25 @@
+@CS
+
+layout (local_size_x = 16, local_size_y = 16) in;
+
+uniform lowp sampler2D src; //Data: Speed map from sample shader, vec2(speed, target_yCoord), resolution is 1/256
+uniform highp uvec4 roi; //Box of interest in px: left, top, right, bottom (inclusive)
+
+layout (std430, binding = 0) buffer Compact { //Output: List of non-zero samples
+	highp uint count; //Number of samples found, may be greater than the list capacity
+	highp uint reserved;
+	highp uvec2 data[]; //x: x | y << 16; y: speed | target_yCoord << 8
+};
+
+void main() {
+	highp uvec2 pxIdx = roi.xy + gl_GlobalInvocationID.xy;
+	if (any(greaterThan(pxIdx, roi.zw)) || any(greaterThanEqual(pxIdx, uvec2(textureSize(src, 0)))))
+		return;
+
+	highp uvec2 value = uvec2(round(texelFetch(src, ivec2(pxIdx), 0).xy * 255.0));
+	if (value.x > 1u) { //Same as CPU-side scan
+		highp uint idx = atomicAdd(count, 1u);
+		if (idx < uint(data.length()))
+			data[idx] = uvec2(pxIdx.x | pxIdx.y << 16, value.x | value.y << 8);
+	}
+}
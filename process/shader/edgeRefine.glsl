@@ -14,6 +14,9 @@ void main() {
 
 uniform lowp sampler2D src; //lowp for enum
 uniform mediump sampler2DArray roadmap;
+#ifdef SCAN
+uniform highp usampler2D run; //From edgeRefineScan: a word of 32 rows in LAYERS texels, bit-sliced walk length to the left and right, and object px
+#endif
 
 in mediump vec2 pxPos;
 #ifndef HUMAN 
@@ -22,14 +25,46 @@ out lowp float result; //lowp for enum
 out lowp vec2 result;
 #endif
 
-#define SHADER_EDGEREFINE_BOTTOMDENOISE 0.2
-#define SHADER_EDGEREFINE_SIDEMARGIN 0.6
+#ifndef SHADER_EDGEREFINE_BOTTOMDENOISE
+	#define SHADER_EDGEREFINE_BOTTOMDENOISE 0.2
+#endif
+#ifndef SHADER_EDGEREFINE_SIDEMARGIN
+	#define SHADER_EDGEREFINE_SIDEMARGIN 0.6
+#endif
 
 #define RESULT_NOTOBJ 0.0
 #define RESULT_OBJECT 0.3
 #define RESULT_BOTTOM 0.6
 #define RESULT_CBEDGE 1.0
 
+#ifdef SCAN
+#define LAYERS 16 //Same as in edgeRefineScan shader
+#define PLANES 7
+
+highp uint ones(mediump int n) { //Mask of the lowest n bits
+	highp uint one = 1u; //Shift in highp, mediump may be 16 bits
+	return n >= 32 ? 0xFFFFFFFFu : (one << uint(max(n, 0))) - 1u;
+}
+
+// Return true if found valid pixel in limit, object px from edgeRefineScan
+bool searchBottom(mediump ivec2 idx, mediump int limit, mediump int height) {
+	mediump int end = min(limit, height); //Out of frame is 0
+	for (mediump int y = idx.y & ~31; y < end; y += 32) { //A word of 32 rows from y
+		highp uint rows = texelFetch(run, ivec2(idx.x, (y >> 5) * LAYERS + 2 * PLANES), 0).r;
+		if ((rows & ~ones(idx.y + 1 - y) & ones(end - y)) != 0u)
+			return true;
+	}
+	return false;
+}
+
+// Return length of walk, from edgeRefineScan
+mediump int walk(mediump ivec2 idx, mediump int layer) {
+	mediump int n = 0;
+	for (mediump int j = 0; j < PLANES; j++)
+		n |= int(texelFetch(run, ivec2(idx.x, (idx.y >> 5) * LAYERS + layer + j), 0).r >> uint(idx.y & 31) & 1u) << j;
+	return n;
+}
+#else
 // Return true if found valid pixel in limit
 bool searchBottom(lowp sampler2D map, mediump ivec2 idx, mediump int limit) {
 	for (mediump ivec2 i = idx; i.y < limit; i.y++) {
@@ -72,6 +107,7 @@ bvec2 minPath(lowp sampler2D map, mediump ivec2 start, lowp float threshold, med
 
 	return bvec2(start.x - lPtr.x >= goal, rPtr.x - start.x >= goal);
 }
+#endif
 
 lowp float refine() {
 	mediump ivec2 srcSize = textureSize(src, 0);
@@ -86,6 +122,15 @@ lowp float refine() {
 	mediump int limitSide = int(SHADER_EDGEREFINE_SIDEMARGIN * pixelWidth);
 	mediump int limitBottom = int(SHADER_EDGEREFINE_BOTTOMDENOISE * pixelWidth);
 
+#ifdef SCAN
+	//Bottom clearence fail, so this is not bottom edge
+	if (searchBottom( pxIdx , limitBottom + pxIdx.y + 1 , srcSize.y ))
+		return RESULT_OBJECT;
+
+	//If any side has space (edge not at center pertion), then this is not center portion
+	if (walk(pxIdx, 0) < limitSide || walk(pxIdx, PLANES) < limitSide)
+		return RESULT_BOTTOM;
+#else
 	//Bottom clearence fail, so this is not bottom edge
 	if (searchBottom( src , pxIdx + ivec2(0,1) , limitBottom + pxIdx.y + 1 )) //Atleast search 1, do not include self
 		return RESULT_OBJECT;
@@ -93,6 +138,7 @@ lowp float refine() {
 	//If any side has space (edge not at center pertion), then this is not center portion
 	if (!all( minPath(src, pxIdx, 0.5, limitSide) ))
 		return RESULT_BOTTOM;
+#endif
 	
 	//Centered bottom edge
 	return RESULT_CBEDGE;
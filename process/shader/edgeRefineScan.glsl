@@ -0,0 +1,122 @@
+@CS
+
+#define WINDOW 256 //Columns and rows of a tile and halo around it, same as SHADER_EDGEREFINE_WINDOW in main.c
+#define WORDS 8 //WINDOW / 32, 32 rows of a column a word
+#define PLANES 7 //Bits of walk length, saturated at 127
+#define LAYERS 16 //Texels of a word in result, same as in edgeRefine shader
+
+layout (local_size_x = 8) in; //A tile an invocation, same as SHADER_EDGEREFINE_TILES in main.c
+
+uniform lowp sampler2D src; //lowp for enum, 1 ch
+uniform highp ivec4 grid; //Left and top (aligned to word) of the ROI box, tile width and height
+uniform highp ivec2 halo; //Halo columns and rows (multiple of word)
+uniform highp ivec2 boxEnd; //Right and bottom (exclusive) of the ROI box, out of the box is 0 (focus region is in the box)
+layout (r32ui, binding = 2) writeonly uniform highp uimage2D run; //A word of 32 rows at (x, word * LAYERS): walk length to the left (layer 0-6, bit-sliced, bit n of layer j is bit j of the length of row n), walk length to the right (layer 7-13), object px (layer 14)
+
+/* Edge refine searches below each object px for the bottom clearance, then walks to the left and right for the side margin; both loops grow with the pixel width, worst on large vehicles near the camera.
+ * A step of the walk goes to the next column, same row first, then up, then down; so the walk from a px only depends on the px, its length is 1 plus the length from the px it steps to.
+ * An invocation sweeps the window of a tile column by column to find the walk length of all px (to the right for walks to the left, and back), keeping a column in registers.
+ * Lengths are bit-sliced, so a step of 32 rows is a few bitwise operations, without branch. Walks and searches do not go further than the halo, so the tile is the same as a full-frame result.
+ */
+
+highp ivec2 tileStart, origin; //Tile and window in frame
+highp uint rowBox[WORDS]; //Rows of the window in the ROI box
+highp uint prev[WORDS], len[WORDS * PLANES]; //Object px and walk length of the previous column of the sweep
+
+highp uint ones(highp int n) { //Mask of the lowest n bits
+	highp uint one = 1u;
+	return n >= 32 ? 0xFFFFFFFFu : (one << uint(max(n, 0))) - 1u;
+}
+
+void fetch(highp int c, out highp uint b0[WORDS], out highp uint b1[WORDS]) { //Object px of 2 columns of the window, 2*2 px a fetch
+	highp vec2 srcSize = vec2(textureSize(src, 0));
+	for (highp int w = 0; w < WORDS; w++) {
+		b0[w] = 0u;
+		b1[w] = 0u;
+		if (rowBox[w] == 0u)
+			continue;
+		for (highp int k = 0; k < 32; k += 2) {
+			lowp vec4 g = textureGather(src, vec2(origin.x + c + 1, origin.y + w * 32 + k + 1) / srcSize, 0); //(c,k+1), (c+1,k+1), (c+1,k), (c,k)
+			b0[w] |= (g.w > 0.0 ? 1u : 0u) << k | (g.x > 0.0 ? 2u : 0u) << k;
+			b1[w] |= (g.z > 0.0 ? 1u : 0u) << k | (g.y > 0.0 ? 2u : 0u) << k;
+		}
+		b0[w] &= rowBox[w];
+		b1[w] &= rowBox[w];
+	}
+}
+
+void advance(highp uint cur[WORDS], highp int c, highp int dir) { //Walk length of a column from the previous column of the sweep
+	highp int x = origin.x + c;
+	highp uint next[WORDS * PLANES];
+	for (highp int w = 0; w < WORDS; w++) {
+		//Step to the same row, a row up, or a row down in the previous column
+		highp uint mid = prev[w];
+		highp uint up = ~mid & (mid << 1 | (w > 0 ? prev[w - 1] >> 31 : 0u));
+		highp uint down = ~mid & ~up & (mid >> 1 | (w < WORDS - 1 ? prev[w + 1] << 31 : 0u));
+		highp uint carry = (mid | up | down) & cur[w]; //Length + 1 if a step, else 0
+		for (highp int j = 0; j < PLANES; j++) {
+			highp uint p = len[w * PLANES + j];
+			highp uint s = p & mid;
+			s |= (p << 1 | (w > 0 ? len[(w - 1) * PLANES + j] >> 31 : 0u)) & up;
+			s |= (p >> 1 | (w < WORDS - 1 ? len[(w + 1) * PLANES + j] << 31 : 0u)) & down;
+			next[w * PLANES + j] = (s ^ carry) & cur[w];
+			carry &= s;
+		}
+		for (highp int j = 0; j < PLANES; j++)
+			next[w * PLANES + j] |= carry; //Saturate
+	}
+	len = next;
+	prev = cur;
+
+	if (x < tileStart.x || x >= tileStart.x + grid.z)
+		return;
+	highp int size = textureSize(src, 0).y;
+	for (highp int w = 0; w < WORDS; w++) {
+		highp int top = origin.y + w * 32, y = (top >> 5) * LAYERS;
+		if (top >= tileStart.y && top < tileStart.y + grid.w && cur[w] != 0u) { //Only read for object px
+			for (highp int j = 0; j < PLANES; j++)
+				imageStore(run, ivec2(x, y + (dir > 0 ? 0 : PLANES) + j), uvec4(next[w * PLANES + j], 0u, 0u, 0u));
+		}
+		if (dir > 0 && top >= tileStart.y && top < size) //Object px are also stored for the halo below, for the bottom search of the tile
+			imageStore(run, ivec2(x, y + 2 * PLANES), uvec4(cur[w], 0u, 0u, 0u));
+	}
+}
+
+void main() {
+	tileStart = grid.xy + ivec2(gl_GlobalInvocationID.xy) * grid.zw;
+	if (tileStart.x >= boxEnd.x)
+		return;
+	origin = tileStart - halo;
+	for (highp int w = 0; w < WORDS; w++) {
+		highp int top = origin.y + w * 32;
+		rowBox[w] = ones(boxEnd.y - top) & ~ones(grid.y - top);
+	}
+
+	//Out of the ROI box is 0, so the sweep starts and ends at the box; columns are fetched in pairs
+	highp int cStart = max(grid.x - origin.x, 0), cEnd = min(boxEnd.x - origin.x, WINDOW);
+	highp uint b0[WORDS], b1[WORDS];
+
+	//Sweep to the right for walks to the left (also object px for bottom search)
+	for (highp int i = 0; i < WORDS * PLANES; i++)
+		len[i] = 0u;
+	for (highp int w = 0; w < WORDS; w++)
+		prev[w] = 0u;
+	for (highp int c = cStart; c < cEnd; c += 2) {
+		fetch(c, b0, b1);
+		advance(b0, c, 1);
+		if (c + 1 < cEnd)
+			advance(b1, c + 1, 1);
+	}
+
+	//Sweep to the left for walks to the right
+	for (highp int i = 0; i < WORDS * PLANES; i++)
+		len[i] = 0u;
+	for (highp int w = 0; w < WORDS; w++)
+		prev[w] = 0u;
+	for (highp int c = cStart + (cEnd - 1 - cStart) / 2 * 2; c >= cStart; c -= 2) {
+		fetch(c, b0, b1);
+		if (c + 1 < cEnd)
+			advance(b1, c + 1, -1);
+		advance(b0, c, -1);
+	}
+}
@@ -17,8 +17,12 @@ uniform lowp sampler2D processedTexture;
 in mediump vec2 pxPos;
 out lowp vec4 result; //lowp for RGBA8 video
 
-#define RAW_WEIGHT 0.3
-#define PROCESSED_WEIGHT 0.9 //data.a
+#ifndef RAW_WEIGHT
+	#define RAW_WEIGHT 0.3
+#endif
+#ifndef PROCESSED_WEIGHT
+	#define PROCESSED_WEIGHT 0.9 //data.a
+#endif
 
 void main() {
 	lowp vec4 data = texture(processedTexture, pxPos); //Use texture instead of texelFetch because the window size may differ from data size
@@ -0,0 +1,174 @@
+@CS
+
+layout (local_size_x = 16, local_size_y = 16) in;
+
+uniform lowp sampler2D current; //lowp for RGBA8 video
+uniform lowp sampler2D previous; //lowp for RGBA8 video
+uniform lowp sampler2D focus; //Focus region, non-zero in perspective mesh
+uniform mediump sampler2DArray roadmap; //mediump for object size
+uniform mediump vec4 param; //Changing sensor THRESHOLD, object fix SEARCH_DISTANCE, edge refine BOTTOMDENOISE and SIDEMARGIN
+uniform highp ivec4 grid; //Top-left of the first tile (px), size of tile (px), halo on each side of tile (px)
+uniform highp int reach; //Reach of object fix (px), h-fix and v-fix skip the part of window not read by the next stage
+layout (rgba8, binding = 0) writeonly uniform lowp image2D dest; //Same as edge refine result (HUMAN), vec4(enum, alpha, 0, 0)
+
+/* A work group processes a tile: changing sensor, h-fix and v-fix on the tile and its halo, edge refine on the tile.
+ * All downstream tests of these results are "non-zero", so they are 1 bit a px, packed in shared memory.
+ * Window (tile and halo) must be large enough for the search distance of object fix and edge refine, see SHADER_FUSED_WINDOW in main.c.
+ */
+#define WINDOW 256 //Tile and halo on both side in px, same as SHADER_FUSED_WINDOW in main.c, multiple of 32
+#define WORDS (WINDOW / 32) //Words of a row of map
+#define MAP_SENSOR 0 //Changing sensor, then v-fix (edge refine source)
+#define MAP_FIX 1 //H-fix
+shared highp uint map[2][WINDOW * WORDS];
+
+#define RESULT_NOTOBJ vec2(0.0, 0.0)
+#define RESULT_OBJECT vec2(0.3, 0.1)
+#define RESULT_BOTTOM vec2(0.6, 1.0)
+#define RESULT_CBEDGE vec2(1.0, 1.0)
+
+highp ivec2 frameSize, windowOrigin;
+
+bool inFrame(highp ivec2 px) {
+	return all(greaterThanEqual(px, ivec2(0))) && all(lessThan(px, frameSize));
+}
+
+// Return the px of a map at window coord, clamped to window (px out of window is only read for px out of tile)
+bool bitWindow(int m, highp ivec2 w) {
+	w = clamp(w, ivec2(0), ivec2(WINDOW - 1));
+	return (map[m][w.y * WORDS + (w.x >> 5)] >> uint(w.x & 31) & 1u) != 0u;
+}
+
+// Return the px of a map, false if out of frame (same as texelFetch() of a cleared texture)
+bool bit(int m, highp ivec2 px) {
+	return inFrame(px) && bitWindow(m, px - windowOrigin);
+}
+
+// Return true if at least 2 px are set in the 2*2 block at px (top-left), edge px repeated (same as textureGather() with clamp to edge)
+bool block(int m, highp ivec2 px) {
+	highp ivec2 w0 = clamp(px, ivec2(0), frameSize - 1) - windowOrigin, w1 = clamp(px + 1, ivec2(0), frameSize - 1) - windowOrigin;
+	mediump int cnt = int(bitWindow(m, w0)) + int(bitWindow(m, ivec2(w1.x, w0.y))) + int(bitWindow(m, ivec2(w0.x, w1.y))) + int(bitWindow(m, w1));
+	return cnt >= 2;
+}
+
+bool inFocus(highp ivec2 px) {
+	return texelFetch(focus, px, 0).r > 0.0;
+}
+
+mediump float getPixelWidth(highp ivec2 px) { //Roadmap may have different size, scale px to roadmap px
+	highp ivec2 mapSize = textureSize(roadmap, 0).xy;
+	return texelFetch(roadmap, ivec3(px * mapSize / frameSize, 0), 0).w;
+}
+
+// Changing sensor
+bool sensor(highp ivec2 px) {
+	lowp vec3 d = abs(texelFetch(current, px, 0).rgb - texelFetch(previous, px, 0).rgb);
+	return inFocus(px) && dot(d, vec3(0.299, 0.587, 0.114)) >= param.x;
+}
+
+// Object fix, 2px a time in both directions
+bool fix(int src, highp ivec2 px, highp ivec2 direction) {
+	if (!inFocus(px))
+		return false;
+	if (bit(src, px))
+		return true;
+
+	mediump float pixelWidth = getPixelWidth(px);
+	mediump int cnt = int(0.5 * param.y * pixelWidth);
+	bool found = false;
+	for (mediump int i = 1; i <= cnt && !found; i++)
+		found = block(src, px + direction * 2 * i);
+	if (!found)
+		return false;
+	found = false;
+	for (mediump int i = 1; i <= cnt && !found; i++)
+		found = block(src, px - direction * 2 * i);
+	return found;
+}
+
+// Clear a map
+void clear(int dest) {
+	for (highp int i = int(gl_LocalInvocationIndex); i < WINDOW * WORDS; i += int(gl_WorkGroupSize.x * gl_WorkGroupSize.y))
+		map[dest][i] = 0u;
+}
+
+// Fill a cleared map of the window except margin, neighbour invocations on neighbour px
+void fill(int dest, int stage, highp ivec2 margin) {
+	highp ivec2 size = ivec2(WINDOW) - 2 * margin;
+	for (highp int i = int(gl_LocalInvocationIndex); i < size.x * size.y; i += int(gl_WorkGroupSize.x * gl_WorkGroupSize.y)) {
+		highp ivec2 w = margin + ivec2(i % size.x, i / size.x);
+		highp ivec2 px = windowOrigin + w;
+		if (!inFrame(px))
+			continue;
+		bool v = stage == 0 ? sensor(px) : stage == 1 ? fix(MAP_SENSOR, px, ivec2(1, 0)) : fix(MAP_FIX, px, ivec2(0, 1));
+		if (v)
+			atomicOr(map[dest][w.y * WORDS + (w.x >> 5)], 1u << uint(w.x & 31));
+	}
+}
+
+// Edge refine: follow the edge to left (direction -1) or right (+1), return true if it is longer than goal
+bool path(highp ivec2 start, mediump int direction, mediump int goal) {
+	highp ivec2 ptr = start;
+	while (abs(ptr.x - start.x) < goal) {
+		if (bit(MAP_SENSOR, ptr + ivec2(direction, 0)))
+			ptr += ivec2(direction, 0);
+		else if (bit(MAP_SENSOR, ptr + ivec2(direction, -1)))
+			ptr += ivec2(direction, -1);
+		else if (bit(MAP_SENSOR, ptr + ivec2(direction, +1)))
+			ptr += ivec2(direction, +1);
+		else
+			break;
+	}
+	return abs(ptr.x - start.x) >= goal;
+}
+
+lowp vec2 refine(highp ivec2 px) {
+	//Not object
+	if (!bit(MAP_SENSOR, px))
+		return RESULT_NOTOBJ;
+
+	mediump float pixelWidth = getPixelWidth(px);
+	mediump int limitSide = int(param.w * pixelWidth);
+	mediump int limitBottom = int(param.z * pixelWidth);
+
+	//Bottom clearence fail, so this is not bottom edge
+	for (mediump int i = 1; i <= limitBottom; i++) {
+		if (bit(MAP_SENSOR, px + ivec2(0, i)))
+			return RESULT_OBJECT;
+	}
+
+	//If any side has space (edge not at center pertion), then this is not center portion
+	if (!path(px, -1, limitSide) || !path(px, +1, limitSide))
+		return RESULT_BOTTOM;
+
+	//Centered bottom edge
+	return RESULT_CBEDGE;
+}
+
+void main() {
+	frameSize = textureSize(current, 0);
+	highp ivec2 tileOrigin = grid.xy + ivec2(gl_WorkGroupID.xy) * grid.z;
+	windowOrigin = tileOrigin - grid.w;
+
+	clear(MAP_SENSOR);
+	clear(MAP_FIX);
+	memoryBarrierShared();
+	barrier();
+	fill(MAP_SENSOR, 0, ivec2(0)); //Changing sensor
+	memoryBarrierShared();
+	barrier();
+	fill(MAP_FIX, 1, ivec2(reach - 1, 0)); //H-fix: has more gap pixels
+	memoryBarrierShared();
+	barrier();
+	clear(MAP_SENSOR);
+	memoryBarrierShared();
+	barrier();
+	fill(MAP_SENSOR, 2, ivec2(reach - 1)); //V-fix: most gap removed by h-fix
+	memoryBarrierShared();
+	barrier();
+
+	for (highp int i = int(gl_LocalInvocationIndex); i < grid.z * grid.z; i += int(gl_WorkGroupSize.x * gl_WorkGroupSize.y)) {
+		highp ivec2 px = tileOrigin + ivec2(i % grid.z, i / grid.z);
+		if (inFrame(px))
+			imageStore(dest, px, vec4(refine(px), 0.0, 0.0));
+	}
+}
@@ -12,13 +12,19 @@ void main() {
 
 uniform lowp sampler2D src; //lowp for enum, 1 ch
 uniform mediump sampler2DArray roadmap; //mediump for object size
-uniform lowp vec2 direction; //(1,0) for horizontal and (0,1) for vertical
+uniform lowp vec2 direction; //(1,0) for horizontal and (0,1) for vertical, not used with SCAN
+#ifdef SCAN
+	uniform highp usampler2D gap; //Steps to the nearest block forward and backward, from objectFixScan
+#endif
 
 in mediump vec2 pxPos;
 out lowp float result; //lowp for enum
 
-#define SEARCH_DISTANCE 0.7 //Should be object size / 2, or even less
+#ifndef SEARCH_DISTANCE
+	#define SEARCH_DISTANCE 0.7 //Should be object size / 2, or even less
+#endif
 
+#ifndef SCAN
 bool search(mediump vec2 center, mediump vec2 step, mediump int cnt, lowp sampler2D img) {
 	bvec2 found = bvec2(false);
 	mediump vec2 c1 = center, c2 = center;
@@ -38,6 +44,7 @@ bool search(mediump vec2 center, mediump vec2 step, mediump int cnt, lowp sample
 	}
 	return found.x && found.y;
 }
+#endif
 
 void main() {
 	lowp float ret = texture(src, pxPos).r;
@@ -49,8 +56,13 @@ void main() {
 		mediump float pixelWidth = texture(roadmap, vec3(pxPos, 0.0)).w;
 		mediump int searchDistancePx = int( 0.5 * SEARCH_DISTANCE * pixelWidth ); //2px a time, so half the count
 
-		mediump vec2 step = vec2(2.0) / srcSizeF; //2px a time for textureGather()
-		ret = search(pxPos, direction * step, searchDistancePx, src) ? 0.7 : 0.0;
+		#ifdef SCAN
+			highp uint steps = texelFetch(gap, ivec2(gl_FragCoord.xy), 0).r;
+			ret = int(steps & 0xFFFFu) <= searchDistancePx && int(steps >> 16) <= searchDistancePx ? 0.7 : 0.0;
+		#else
+			mediump vec2 step = vec2(2.0) / srcSizeF; //2px a time for textureGather()
+			ret = search(pxPos, direction * step, searchDistancePx, src) ? 0.7 : 0.0;
+		#endif
 	}
 
 	result = ret;
@@ -0,0 +1,97 @@
+@CS
+
+#ifndef WORDS
+	#define WORDS 256 //32px words of the scanned part of a line, a word an invocation; set by main.c from the ROI box
+#endif
+#define LINE (WORDS * 32) //Max length of the scanned part of a line in px
+
+layout (local_size_x = WORDS) in;
+
+uniform lowp sampler2D src; //lowp for enum, 1 ch
+uniform highp ivec2 direction; //(1,0) for rows (h-fix) and (0,1) for columns (v-fix)
+uniform highp ivec3 range; //Row or column of the first work group (a work group a line), first px (even) and end px (exclusive) of the scanned part of lines; blocks out of this part are 0 except out of frame
+layout (r32ui, binding = 1) writeonly uniform highp uimage2D gap; //Steps to the nearest block of the px: forward in low 16 bits, backward in high 16 bits, NONE if no block
+
+/* Object fix fills a gap px if a block (2*2 px with at least 2 object px, edge px repeated) is found both forward and backward within the search distance, 2px a step.
+ * Instead of searching from each gap px, a work group finds all blocks of a line once, then the nearest block of the same parity on each side of each px by a prefix scan over 32px words, so the cost does not depend on the search distance.
+ * Blocks out of frame repeat the block at the frame edge, same as textureGather() with clamp to edge.
+ */
+#define NONE 0xFFFFu
+#define FAR 0x40000000 //Position of no block
+
+shared highp uint bits[WORDS]; //Block at px (top-left of block)
+shared highp int last[2][WORDS]; //Last block of even and odd px in the word, then in the word and all words before
+shared highp int first[2][WORDS]; //First block of even and odd px in the word, then in the word and all words after
+
+highp ivec2 lineSize; //Length of line, number of lines
+
+bool obj(highp int i, highp int l) {
+	highp ivec2 p = clamp(ivec2(i, l), ivec2(0), lineSize - 1);
+	return texelFetch(src, direction * p.x + direction.yx * p.y, 0).r > 0.0;
+}
+
+void main() {
+	lineSize = direction.x != 0 ? textureSize(src, 0) : textureSize(src, 0).yx;
+	highp int line = range.x + int(gl_WorkGroupID.x);
+	highp int word = int(gl_LocalInvocationIndex);
+	highp int start = range.y + word * 32; //Even, so bit 0 of all words is an even px
+
+	//Blocks of the word
+	highp uint b = 0u;
+	if (start < range.z) {
+		mediump int cntPrev = int(obj(start, line)) + int(obj(start, line + 1));
+		for (highp int i = start; i < start + 32 && i < range.z; i++) {
+			mediump int cntNext = int(obj(i + 1, line)) + int(obj(i + 1, line + 1));
+			if (cntPrev + cntNext >= 2)
+				b |= 1u << uint(i - start);
+			cntPrev = cntNext;
+		}
+	}
+	bits[word] = b;
+	for (int p = 0; p < 2; p++) {
+		highp uint m = b & (p == 0 ? 0x55555555u : 0xAAAAAAAAu);
+		last[p][word] = m != 0u ? start + findMSB(m) : -FAR;
+		first[p][word] = m != 0u ? start + findLSB(m) : FAR;
+	}
+	memoryBarrierShared();
+	barrier();
+
+	//Prefix max of last, suffix min of first
+	for (highp int s = 1; s < WORDS; s <<= 1) {
+		highp ivec2 l = ivec2(last[0][word], last[1][word]), f = ivec2(first[0][word], first[1][word]);
+		if (word >= s)
+			l = max(l, ivec2(last[0][word - s], last[1][word - s]));
+		if (word + s < WORDS)
+			f = min(f, ivec2(first[0][word + s], first[1][word + s]));
+		memoryBarrierShared();
+		barrier();
+		last[0][word] = l.x;
+		last[1][word] = l.y;
+		first[0][word] = f.x;
+		first[1][word] = f.y;
+		memoryBarrierShared();
+		barrier();
+	}
+
+	//Nearest block on each side, blocks out of frame repeat the edge: before px 0 is the block of px 0 twice, after the last px is the block of the last px
+	bool outBackward = range.y == 0 && (obj(0, line) || obj(0, line + 1));
+	bool outForward = range.z == lineSize.x && (bits[(range.z - 1 - range.y) >> 5] >> uint((range.z - 1 - range.y) & 31) & 1u) != 0u;
+	for (highp int i = start; i < start + 32 && i < range.z; i++) {
+		mediump int p = i & 1;
+		highp uint m = b & (p == 0 ? 0x55555555u : 0xAAAAAAAAu);
+		highp uint below = m & ((1u << uint(i - start)) - 1u), above = m & ~((2u << uint(i - start)) - 1u);
+
+		highp int backward = below != 0u ? start + findMSB(below) : word > 0 ? last[p][word - 1] : -FAR;
+		if (backward == -FAR && outBackward)
+			backward = -2 + p; //-1 for odd px, -2 for even px
+		highp int forward = above != 0u ? start + findLSB(above) : word + 1 < WORDS ? first[p][word + 1] : FAR;
+		if (forward == FAR && outForward) {
+			highp int edge = max(i + 1, lineSize.x - 1);
+			forward = edge + ((edge - i) & 1);
+		}
+
+		highp uint f = forward == FAR ? NONE : min(uint(forward - i) >> 1, NONE);
+		highp uint k = backward == -FAR ? NONE : min(uint(i - backward) >> 1, NONE);
+		imageStore(gap, direction * i + direction.yx * line, uvec4(f | k << 16, 0u, 0u, 0u));
+	}
+}
@@ -0,0 +1,32 @@
+@VS
+
+layout (location = 0) in highp vec2 position;
+
+void main() {
+	gl_Position = vec4(position.x * 2.0 - 1.0, position.y * 2.0 - 1.0, 0.0, 1.0);
+}
+
+@FS
+
+uniform lowp sampler2D src; //Data: Speed map from sample shader, vec2(speed, target_yCoord), resolution is 1/256
+uniform mediump ivec2 range; //Left and right (inclusive) of box of interest in px
+
+out lowp float result; //Data: 1.0 if any pixel in this span of this row has speed, 0.0 if empty
+
+#define THRESHOLD (1.5 / 255.0) //Same as CPU-side scan: speed > 1
+#define OCCUPANCY_SPAN 4 //Number of spans in a row, width of framebuffer, 4 spans of R8 gives 4 bytes per row, no padding when download
+
+void main() {
+	mediump ivec2 pxIdx = ivec2(gl_FragCoord.xy); //Framebuffer is N spans wide and as high as the speed map
+	mediump int span = (range.y - range.x) / OCCUPANCY_SPAN + 1;
+	mediump int left = range.x + pxIdx.x * span;
+	mediump int right = min(left + span - 1, min(range.y, textureSize(src, 0).x - 1));
+
+	for (mediump int x = left; x <= right; x++) {
+		if (texelFetch(src, ivec2(x, pxIdx.y), 0).x > THRESHOLD) {
+			result = 1.0;
+			return;
+		}
+	}
+	result = 0.0;
+}
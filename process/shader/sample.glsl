@@ -15,7 +15,9 @@ uniform lowp sampler2D src; //Data: Normalied speed [0,255] and y-target offset
 in mediump vec2 pxPos;
 out lowp vec2 result; //Data: vec2(speed, target_yCoord), resolution is 1/256
 
-#define MIN_SAMPLE_SIZE 2.0
+#ifndef MIN_SAMPLE_SIZE
+	#define MIN_SAMPLE_SIZE 2.0
+#endif
 
 #define SEARCH_ROAD x
 #define SEARCH_SCREEN y
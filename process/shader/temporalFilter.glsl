@@ -0,0 +1,38 @@
+@VS
+
+layout (location = 0) in highp vec2 meshROI;
+out mediump vec2 pxPos;
+
+void main() {
+	gl_Position = vec4(meshROI.x * 2.0 - 1.0, meshROI.y * 2.0 - 1.0, 0.0, 1.0);
+	pxPos = meshROI.xy;
+}
+
+@FS
+
+uniform lowp sampler2D current; //lowp for RGBA8 video
+uniform mediump sampler2D previous; //mediump for RGBA16F state, the result of previous frame
+
+in mediump vec2 pxPos;
+out mediump vec4 result; //mediump for RGBA16F state, RGBA8 would lose the small steps of the average
+
+#ifndef ALPHA
+	#define ALPHA 0.25 //Weight of current frame on a still px, lower removes more noise but follows a slow change (e.g. light) later
+#endif
+#ifndef MOTION
+	#define MOTION 0.1 //Luma difference of current frame and state where the px is moving, the state is replaced by the frame so moving objects do not smear
+#endif
+
+/* Exponential moving average of frames: state = mix(state, frame, alpha), one fetch of each instead of 9 of the spatial blur.
+ * Alpha is ALPHA for still px, and grows linearly to 1.0 as the difference of frame and state grows to MOTION.
+ * The state of the first frame is 0 (cleared), so the difference is large and the state starts from the frame.
+ */
+
+void main() {
+	mediump vec4 frame = texture(current, pxPos);
+	mediump vec4 state = texture(previous, pxPos);
+
+	mediump float motion = dot(abs(frame.rgb - state.rgb), vec3(0.299, 0.587, 0.114));
+	mediump float alpha = mix(ALPHA, 1.0, min(motion / MOTION, 1.0));
+	result = vec4(mix(state.rgb, frame.rgb, alpha), frame.a); //Alpha is not averaged
+}
@@ -0,0 +1,305 @@
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "scan.h"
+#include "th_output.h"
+#include "th_analysis.h"
+
+#define analysis_info(format, ...) {fprintf(stderr, "[Analysis] Log:\t"format"\n" __VA_OPT__(,) __VA_ARGS__);} //Write log
+
+static int analysis_valid = 0;
+static pthread_t analysis_tid; //Analysis thread ID
+static analysis_config analysis_cfg;
+
+//Job queue, written by main thread, read by analysis thread. A job stays in the queue until finished, so its data is not released
+static analysis_job* queue = NULL;
+static unsigned int queueHead = 0, queueCnt = 0; //Oldest pending job, number of pending jobs (including the one in process)
+static unsigned int doneCnt = 0; //Finished and not collected
+static unsigned int waitCnt = 0; //Number of times main thread waits for analysis thread
+static uint64_t latencySum = 0, latencyMax = 0; //Time from frame arrival to result written to output, used by analysis thread only
+static uint64_t latencyFirst = 0, latencyLast = 0; //Time the first and last result is written to output, for throughput
+static unsigned int latencyCnt = 0;
+static int stop = 0;
+static pthread_mutex_t queueLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queueNew = PTHREAD_COND_INITIALIZER; //Fired when a job is submitted
+static pthread_cond_t queueDone = PTHREAD_COND_INITIALIZER; //Fired when a job is finished
+
+//Result of current frame, used by analysis thread only
+static output_data* obj = NULL;
+static float* instance = NULL;
+static unsigned int objCnt = 0, objCap = 0;
+
+//Speedometer instances of the latest frame, for display
+static float* display = NULL;
+static unsigned int displayCap = 0;
+static int displayCnt = -1; //-1 if not updated since last read
+static pthread_mutex_t displayLock = PTHREAD_MUTEX_INITIALIZER;
+
+void* th_analysis(void* arg);
+
+int th_analysis_init(analysis_config config, char** statue) {
+	if (!config.queueDepth || !config.objCnt) {
+		if (statue)
+			*statue = "Queue depth and object list size must be greater than 0";
+		return 0;
+	}
+	analysis_cfg = config;
+
+	queue = malloc(config.queueDepth * sizeof(analysis_job));
+	obj = malloc(config.objCnt * sizeof(output_data));
+	instance = malloc(config.objCnt * 3 * sizeof(float));
+	display = malloc(config.objCnt * 3 * sizeof(float));
+	if (!queue || !obj || !instance || !display) {
+		if (statue)
+			*statue = "Fail to allocate memory for job queue and object list";
+		free(display); display = NULL;
+		free(instance); instance = NULL;
+		free(obj); obj = NULL;
+		free(queue); queue = NULL;
+		return 0;
+	}
+	objCnt = 0;
+	objCap = displayCap = config.objCnt;
+	displayCnt = -1;
+	queueHead = 0; queueCnt = 0; doneCnt = 0; waitCnt = 0;
+	latencySum = 0; latencyMax = 0; latencyFirst = 0; latencyLast = 0; latencyCnt = 0;
+	stop = 0;
+
+	pthread_attr_t attr;
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+	int err = pthread_create(&analysis_tid, &attr, th_analysis, NULL);
+	if (err) {
+		if (statue)
+			*statue = "Fail to create analysis thread";
+		free(display); display = NULL;
+		free(instance); instance = NULL;
+		free(obj); obj = NULL;
+		free(queue); queue = NULL;
+		return 0;
+	}
+
+	analysis_valid = 1;
+	return 1;
+}
+
+void th_analysis_submit(const analysis_job job) {
+	if (!analysis_valid)
+		return;
+
+	pthread_mutex_lock(&queueLock);
+	if (queueCnt == analysis_cfg.queueDepth) {
+		waitCnt++;
+		while (queueCnt == analysis_cfg.queueDepth)
+			pthread_cond_wait(&queueDone, &queueLock);
+	}
+	queue[(queueHead + queueCnt) % analysis_cfg.queueDepth] = job;
+	queueCnt++;
+	pthread_cond_signal(&queueNew);
+	pthread_mutex_unlock(&queueLock);
+}
+
+unsigned int th_analysis_collect() {
+	if (!analysis_valid)
+		return 0;
+
+	pthread_mutex_lock(&queueLock);
+	unsigned int cnt = doneCnt;
+	doneCnt = 0;
+	pthread_mutex_unlock(&queueLock);
+	return cnt;
+}
+
+int th_analysis_wait() {
+	if (!analysis_valid)
+		return 0;
+
+	int wait = 0;
+	pthread_mutex_lock(&queueLock);
+	while (!doneCnt && queueCnt) {
+		wait = 1;
+		pthread_cond_wait(&queueDone, &queueLock);
+	}
+	waitCnt += wait;
+	pthread_mutex_unlock(&queueLock);
+	return wait;
+}
+
+int th_analysis_display(float** const instances, unsigned int* const cap) {
+	if (!analysis_valid)
+		return -1;
+
+	pthread_mutex_lock(&displayLock);
+	int cnt = displayCnt;
+	if (cnt > 0 && (unsigned int)cnt > *cap) {
+		float* new = realloc(*instances, cnt * 3 * sizeof(float));
+		if (new) {
+			*instances = new;
+			*cap = cnt;
+		} else { //Out of memory, display what fits
+			cnt = *cap;
+		}
+	}
+	if (cnt > 0)
+		memcpy(*instances, display, cnt * 3 * sizeof(float));
+	displayCnt = -1;
+	pthread_mutex_unlock(&displayLock);
+	return cnt;
+}
+
+void th_analysis_destroy() {
+	if (!analysis_valid)
+		return;
+	analysis_valid = 0;
+
+	pthread_mutex_lock(&queueLock); //Thread finishes pending jobs, then exits
+	stop = 1;
+	pthread_cond_signal(&queueNew);
+	pthread_mutex_unlock(&queueLock);
+	pthread_join(analysis_tid, NULL);
+
+	if (waitCnt)
+		analysis_info("Main thread waited for analysis %u times", waitCnt);
+	if (latencyCnt)
+		analysis_info("Latency from frame arrival to output: avg %.3lf ms, max %.3lf ms, %u frames", latencySum / 1e6 / latencyCnt, latencyMax / 1e6, latencyCnt);
+	if (latencyCnt > 1)
+		analysis_info("Throughput: %.2lf fps", (latencyCnt - 1) / ((latencyLast - latencyFirst) / 1e9));
+
+	free(display); display = NULL;
+	free(instance); instance = NULL;
+	free(obj); obj = NULL;
+	free(queue); queue = NULL;
+}
+
+/** Compare samples in list in raster order (y then x), y is in the higher bits */
+static int th_analysis_compare(const void* a, const void* b) {
+	uint32_t pa = ((const uint32_t*)a)[0], pb = ((const uint32_t*)b)[0];
+	return (pa > pb) - (pa < pb);
+}
+
+/** Non-zero sample in speed map, add to the object list of current frame */
+static void th_analysis_sample(const unsigned int x, const unsigned int y, const int16_t speed, const int16_t screenDy) {
+	if (objCnt == objCap) { //Grow both buffers together, amortized, no allocation once the pool is big enough for the busiest frame
+		output_data* newObj = realloc(obj, objCap * 2 * sizeof(output_data));
+		if (newObj)
+			obj = newObj;
+		float* newInstance = realloc(instance, objCap * 2 * 3 * sizeof(float));
+		if (newInstance)
+			instance = newInstance;
+		if (!newObj || !newInstance) //Out of memory, drop this sample
+			return;
+		objCap *= 2;
+	}
+
+	const roadmap* map = analysis_cfg.roadmap;
+	vec2 coordNorm = { (float)x / analysis_cfg.width , (float)y / analysis_cfg.height };
+	ivec2 coordScreen = {x,y};
+	ivec2 coordRoadmap = { x * map->header.width / analysis_cfg.width , y * map->header.height / analysis_cfg.height };
+	struct Roadmap_Table1 geoData = map->t1[ coordRoadmap.y * map->header.width + coordRoadmap.x ];
+	float* instancePtr = instance + objCnt * 3;
+	obj[objCnt++] = (output_data){
+		.rx = geoData.px,
+		.ry = geoData.py,
+		.sx = coordScreen.x,
+		.sy = coordScreen.y,
+		.speed = speed,
+		.osy = screenDy - 128
+	};
+	*instancePtr++ = coordNorm.x;
+	*instancePtr++ = coordNorm.y;
+	*instancePtr++ = speed;
+//	*instancePtr++ = abs(screenDy - 128);
+}
+
+/** Scan speed map of the box of interest */
+static void th_analysis_scan(const analysis_job* const job) {
+	const unsigned int roiWidth = analysis_cfg.roiSize[0], roiHeight = analysis_cfg.roiSize[1];
+	const uint8_t (* speedData)[2] = job->data;
+	for (unsigned int y = 0; y < roiHeight; y++) { //Coord relative to ROI
+		if (job->occupancy) {
+			const uint8_t* span = job->occupancy + y * analysis_cfg.occupancySpan;
+			unsigned int occupied = 0;
+			for (unsigned int i = 0; i < analysis_cfg.occupancySpan; i++)
+				occupied |= span[i];
+			if (!occupied)
+				continue;
+		}
+		const uint8_t (* row)[2] = speedData + y * roiWidth;
+		unsigned int xs[64];
+		for (unsigned int left = 0; left < roiWidth; ) {
+			unsigned int cnt = scan_row(row[0], left, roiWidth - 1, 1, xs, arrayLength(xs)); //Speed > 1
+			for (unsigned int i = 0; i < cnt; i++)
+				th_analysis_sample(analysis_cfg.roiOffset[0] + xs[i], analysis_cfg.roiOffset[1] + y, row[xs[i]][0], row[xs[i]][1]);
+			if (cnt < arrayLength(xs)) //Row done, a full xs means there may be more
+				break;
+			left = xs[cnt-1] + 1;
+		}
+	}
+}
+
+/** Samples in list */
+static void th_analysis_list(const analysis_job* const job) {
+	uint32_t (* list)[2] = job->data;
+	if (!job->count)
+		return;
+	qsort(list, job->count, sizeof(list[0]), th_analysis_compare); //Append order is random, sort so the result is the same as scanning the speed map
+	for (uint32_t (* ptr)[2] = list; ptr < list + job->count; ptr++)
+		th_analysis_sample((*ptr)[0] & 0xFFFF, (*ptr)[0] >> 16, (*ptr)[1] & 0xFF, (*ptr)[1] >> 8 & 0xFF);
+}
+
+void* th_analysis(void* arg) {
+	for(;;) {
+		pthread_mutex_lock(&queueLock);
+		while (!queueCnt && !stop)
+			pthread_cond_wait(&queueNew, &queueLock);
+		if (!queueCnt) { //Stop and no more pending job
+			pthread_mutex_unlock(&queueLock);
+			break;
+		}
+		analysis_job job = queue[queueHead];
+		pthread_mutex_unlock(&queueLock);
+
+		objCnt = 0;
+		if (job.source == analysis_source_list)
+			th_analysis_list(&job);
+		else
+			th_analysis_scan(&job);
+		if (objCnt)
+			th_output_write(job.frame, objCnt, obj);
+		if (job.arrival) { //Result of this frame is known to output now, with or without sample
+			latencyLast = nanotime();
+			if (!latencyCnt)
+				latencyFirst = latencyLast;
+			uint64_t latency = latencyLast - job.arrival;
+			latencySum += latency;
+			latencyCnt++;
+			if (latency > latencyMax)
+				latencyMax = latency;
+		}
+
+		pthread_mutex_lock(&displayLock);
+		if (objCnt > displayCap) {
+			float* new = realloc(display, objCnt * 3 * sizeof(float));
+			if (new) {
+				display = new;
+				displayCap = objCnt;
+			}
+		}
+		displayCnt = objCnt < displayCap ? objCnt : displayCap;
+		memcpy(display, instance, displayCnt * 3 * sizeof(float));
+		pthread_mutex_unlock(&displayLock);
+
+		pthread_mutex_lock(&queueLock);
+		queueHead = (queueHead + 1) % analysis_cfg.queueDepth;
+		queueCnt--;
+		doneCnt++;
+		pthread_cond_signal(&queueDone);
+		pthread_mutex_unlock(&queueLock);
+	}
+
+	return NULL;
+}
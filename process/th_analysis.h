@@ -0,0 +1,76 @@
+#ifndef INCLUDE_TH_ANALYSIS_H
+#define INCLUDE_TH_ANALYSIS_H
+
+#include <stdint.h>
+
+#include "roadmap.h"
+
+/** Where the data of a job comes from */
+typedef enum Analysis_Source {
+	analysis_source_speedmap,	//Speed map (RG8: speed, target_yCoord) of the box of interest
+	analysis_source_list		//List of non-zero samples (x | y << 16, speed | target_yCoord << 8), in any order
+} analysis_source;
+
+/** Downloaded speed data of one frame */
+typedef struct Analysis_Job {
+	unsigned int frame;		//Frame number of the data
+	analysis_source source;
+	void* data;			//Speed map or sample list, the list will be sorted in place
+	unsigned int count;		//List: number of samples
+	const uint8_t* occupancy;	//Speed map: row occupancy of the box of interest (occupancySpan bytes per row, non-zero if the span has sample), NULL to scan all rows
+	uint64_t arrival;		//Time (nanotime()) the frame was read from input, used to measure latency; 0 if unknown
+} analysis_job;
+
+/** Analysis config */
+typedef struct Analysis_Config {
+	unsigned int width, height;	//Frame size in px
+	unsigned int roiOffset[2];	//Box of interest in px {left, top}, speed map of a job covers this box only
+	unsigned int roiSize[2];	//Box of interest in px {width, height}
+	const roadmap* roadmap;		//Road-domain lookup, must be valid until th_analysis_destroy()
+	unsigned int queueDepth;	//Max number of jobs submitted but not finished
+	unsigned int objCnt;		//Init size of object list of a frame, grows when needed
+	unsigned int occupancySpan;	//Number of spans (bytes) per row in occupancy map
+} analysis_config;
+
+/** Analysis thread init.
+ * Prepare job queue, launch thread.
+ * The thread turns downloaded speed data into output_data records and passes them to th_output_write() in the order of submission,
+ * and keeps the speedometer instances of the latest frame for display.
+ * @param config Analysis config
+ * @param statue If not NULL, return error message in case this function fail
+ * @return If success, return 1; if fail, release all resources and return 0
+ */
+int th_analysis_init(analysis_config config, char** statue);
+
+/** Submit a job to the analysis thread.
+ * The data (and occupancy) of the job is used by the analysis thread until the job is collected by th_analysis_collect(),
+ * the caller should not modify or release it before that. This is designed for mapped PBO: no copy.
+ * Block if there are already queueDepth jobs not finished.
+ * @param job The job
+ */
+void th_analysis_submit(const analysis_job job);
+
+/** Get the number of jobs finished since last call, the data of these jobs (the oldest ones) can be released. Non-blocking.
+ * @return Number of jobs finished
+ */
+unsigned int th_analysis_collect();
+
+/** Wait until at least one job is finished and not collected, or no job is pending.
+ * @return 1 if this call has to wait for the analysis thread, 0 if not
+ */
+int th_analysis_wait();
+
+/** Get the speedometer instances (x, y, speed) of the latest analyzed frame.
+ * @param instances Buffer to copy the instances to, 3 floats per instance, grows (realloc) if not big enough
+ * @param cap Size of the buffer in number of instances, updated if the buffer grows
+ * @return Number of instances, -1 if no frame is analyzed since last call (buffer not changed)
+ */
+int th_analysis_display(float** const instances, unsigned int* const cap);
+
+/** Terminate analysis thread and release associate resources.
+ * Pending jobs are finished (and written to output) before this function returns.
+ * Latency (from frame arrival to the result written to output) and throughput (rate of results written to output) are logged.
+ */
+void th_analysis_destroy();
+
+#endif /* #ifndef INCLUDE_TH_ANALYSIS_H */
@@ -0,0 +1,224 @@
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "th_event.h"
+
+#define EVENT_QUEUE 16 //Max number of pending events
+
+#define event_info(format, ...) {fprintf(stderr, "[Event] Log:\t"format"\n" __VA_OPT__(,) __VA_ARGS__);} //Write log
+#define event_error(format, ...) {fprintf(stderr, "[Event] Err:\t"format"\n" __VA_OPT__(,) __VA_ARGS__);} //Write error log
+
+struct th_event_request {
+	int frame;
+	uint32_t id;
+	output_data sample;
+};
+
+static int event_valid = 0;
+static pthread_t event_tid; //Writer thread ID
+static event_config event_cfg;
+static char* event_dir = NULL; //Copy of event_cfg.dir
+
+//Frame ring, written by reader thread, read by writer thread. Each slot has its own lock, so reader only waits if writer is copying the same slot
+static uint8_t* ring = NULL;
+static struct {
+	pthread_mutex_t lock;
+	long long int seq; //Reader frame number in this slot, -1 if empty
+}* ringSlot = NULL;
+static long long int ringHead = -1; //Latest reader frame number in ring
+static pthread_mutex_t ringLock = PTHREAD_MUTEX_INITIALIZER; //Protect ringHead
+static pthread_cond_t ringNew = PTHREAD_COND_INITIALIZER; //Fired when a new frame is captured
+
+//Event queue, written by output thread, read by writer thread
+static struct th_event_request queue[EVENT_QUEUE];
+static unsigned int queueHead = 0, queueCnt = 0, queueDrop = 0;
+static int stop = 0;
+static pthread_mutex_t queueLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queueNew = PTHREAD_COND_INITIALIZER;
+
+void* th_event(void* arg);
+
+int th_event_init(event_config config, char** statue) {
+	if (config.ringDepth < config.pre + config.post + 1) {
+		if (statue)
+			*statue = "Frame ring is not deep enough to hold pre and post frames";
+		return 0;
+	}
+	event_cfg = config;
+
+	ring = malloc((size_t)config.ringDepth * config.frameSize);
+	ringSlot = malloc(config.ringDepth * sizeof(*ringSlot));
+	event_dir = strdup(config.dir);
+	if (!ring || !ringSlot || !event_dir) {
+		if (statue)
+			*statue = "Fail to allocate memory for frame ring";
+		free(event_dir); event_dir = NULL;
+		free(ringSlot); ringSlot = NULL;
+		free(ring); ring = NULL;
+		return 0;
+	}
+	for (unsigned int i = 0; i < config.ringDepth; i++) {
+		pthread_mutex_init(&ringSlot[i].lock, NULL);
+		ringSlot[i].seq = -1;
+	}
+	ringHead = -1;
+	queueHead = 0; queueCnt = 0; queueDrop = 0;
+	stop = 0;
+
+	pthread_attr_t attr;
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+	int err = pthread_create(&event_tid, &attr, th_event, NULL);
+	if (err) {
+		if (statue)
+			*statue = "Fail to create event writer thread";
+		for (unsigned int i = 0; i < config.ringDepth; i++)
+			pthread_mutex_destroy(&ringSlot[i].lock);
+		free(event_dir); event_dir = NULL;
+		free(ringSlot); ringSlot = NULL;
+		free(ring); ring = NULL;
+		return 0;
+	}
+
+	event_valid = 1;
+	return 1;
+}
+
+void th_event_capture(const void* const frame, const unsigned int seq) {
+	if (!event_valid)
+		return;
+
+	int cancelState; //Reader thread uses asynchronous cancel, do not get cancelled while holding the lock
+	pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &cancelState);
+
+	unsigned int slot = seq % event_cfg.ringDepth;
+	pthread_mutex_lock(&ringSlot[slot].lock);
+	memcpy(ring + (size_t)slot * event_cfg.frameSize, frame, event_cfg.frameSize);
+	ringSlot[slot].seq = seq;
+	pthread_mutex_unlock(&ringSlot[slot].lock);
+
+	pthread_mutex_lock(&ringLock);
+	ringHead = seq;
+	pthread_cond_signal(&ringNew);
+	pthread_mutex_unlock(&ringLock);
+
+	pthread_setcancelstate(cancelState, NULL);
+}
+
+void th_event_trigger(const int frame, const uint32_t id, const output_data* const sample) {
+	if (!event_valid)
+		return;
+
+	pthread_mutex_lock(&queueLock);
+	if (queueCnt == EVENT_QUEUE) {
+		queueDrop++;
+	} else {
+		queue[(queueHead + queueCnt) % EVENT_QUEUE] = (struct th_event_request){.frame = frame, .id = id, .sample = *sample};
+		queueCnt++;
+		pthread_cond_signal(&queueNew);
+	}
+	pthread_mutex_unlock(&queueLock);
+}
+
+void th_event_destroy() {
+	if (!event_valid)
+		return;
+	event_valid = 0;
+
+	pthread_mutex_lock(&ringLock); //Writer may wait on either of them
+	pthread_mutex_lock(&queueLock);
+	stop = 1;
+	pthread_cond_signal(&queueNew);
+	pthread_cond_signal(&ringNew);
+	pthread_mutex_unlock(&queueLock);
+	pthread_mutex_unlock(&ringLock);
+	pthread_join(event_tid, NULL);
+
+	if (queueDrop)
+		event_info("%u events dropped (queue full)", queueDrop);
+
+	for (unsigned int i = 0; i < event_cfg.ringDepth; i++)
+		pthread_mutex_destroy(&ringSlot[i].lock);
+	free(event_dir); event_dir = NULL;
+	free(ringSlot); ringSlot = NULL;
+	free(ring); ring = NULL;
+}
+
+void th_event_write(const struct th_event_request* const request, uint8_t* const buffer) {
+	long long int trigger = (long long int)request->frame - event_cfg.frameOffset;
+	long long int first = trigger - event_cfg.pre, last = trigger + event_cfg.post;
+	if (first < 0)
+		first = 0;
+
+	//Wait for post frames. Stop waiting if the program is terminating, write what we have
+	pthread_mutex_lock(&ringLock);
+	while (ringHead < last && !stop)
+		pthread_cond_wait(&ringNew, &ringLock);
+	pthread_mutex_unlock(&ringLock);
+
+	char path[256];
+	snprintf(path, sizeof(path), "%s/event_%u.data", event_dir, request->id);
+	FILE* fpData = fopen(path, "wb");
+	snprintf(path, sizeof(path), "%s/event_%u.txt", event_dir, request->id);
+	FILE* fpNote = fopen(path, "w");
+	if (!fpData || !fpNote) {
+		event_error("Fail to open event file for track %u (errno = %d)", request->id, errno);
+		if (fpData) fclose(fpData);
+		if (fpNote) fclose(fpNote);
+		return;
+	}
+
+	const output_data* s = &request->sample;
+	fprintf(fpNote, "E %u %d %d %.2f,%.2f %u,%u %d\n", request->id, request->frame, s->speed, s->rx, s->ry, s->sx, s->sy, s->osy);
+	unsigned int written = 0;
+	for (long long int seq = first; seq <= last; seq++) {
+		unsigned int slot = seq % event_cfg.ringDepth;
+		int valid;
+		pthread_mutex_lock(&ringSlot[slot].lock);
+		valid = ringSlot[slot].seq == seq;
+		if (valid)
+			memcpy(buffer, ring + (size_t)slot * event_cfg.frameSize, event_cfg.frameSize);
+		pthread_mutex_unlock(&ringSlot[slot].lock);
+
+		if (valid) {
+			fwrite(buffer, 1, event_cfg.frameSize, fpData);
+			fprintf(fpNote, "P %lld %u\n", seq + event_cfg.frameOffset, written++); //Frame number, index in data file
+		} else {
+			fprintf(fpNote, "M %lld\n", seq + event_cfg.frameOffset); //Missing: overwritten or not captured
+		}
+	}
+
+	fclose(fpNote);
+	fclose(fpData);
+}
+
+void* th_event(void* arg) {
+	uint8_t* buffer = malloc(event_cfg.frameSize); //Copy out of ring, so the slot is not locked during file I/O
+	if (!buffer) {
+		event_error("Fail to allocate memory for writer buffer, events will not be written");
+	}
+
+	for (;;) {
+		pthread_mutex_lock(&queueLock);
+		while (!queueCnt && !stop)
+			pthread_cond_wait(&queueNew, &queueLock);
+		if (!queueCnt) { //Stop and nothing pending
+			pthread_mutex_unlock(&queueLock);
+			break;
+		}
+		struct th_event_request request = queue[queueHead];
+		queueHead = (queueHead + 1) % EVENT_QUEUE;
+		queueCnt--;
+		pthread_mutex_unlock(&queueLock);
+
+		if (buffer)
+			th_event_write(&request, buffer);
+	}
+
+	free(buffer);
+	return NULL;
+}
\ No newline at end of file
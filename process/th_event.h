@@ -0,0 +1,46 @@
+#ifndef INCLUDE_TH_EVENT_H
+#define INCLUDE_TH_EVENT_H
+
+#include <stdint.h>
+
+#include "th_output.h"
+
+/** Event config */
+typedef struct Event_Config {
+	unsigned int frameSize;		//Size of one frame in bytes (RGBA8)
+	unsigned int ringDepth;		//Number of frames kept in memory
+	unsigned int pre, post;		//Number of frames before and after the trigger frame to write
+	int frameOffset;		//Reader frame = result frame - frameOffset (latency of the upload pipeline)
+	const char* dir;		//Directory to write event files, copied, so the caller can free it after init
+} event_config;
+
+/** Event thread init.
+ * Allocate frame ring, prepare event queue, launch writer thread.
+ * Event frames and annotation are written by the writer thread, so the caller will never block on file I/O.
+ * @param config Event config
+ * @param statue If not NULL, return error message in case this function fail
+ * @return If success, return 1; if fail, release all resources and return 0
+ */
+int th_event_init(event_config config, char** statue);
+
+/** Save a frame into the frame ring.
+ * Designed to be called by reader thread after a frame is read and converted to RGBA8 (see th_reader_tap()).
+ * @param frame Pointer to the frame data
+ * @param seq Reader frame number
+ */
+void th_event_capture(const void* const frame, const unsigned int seq);
+
+/** Request to write an event.
+ * This function only puts the request in a queue and returns immediately. If the queue is full, the event is dropped.
+ * @param frame Frame number (result frame number) of the trigger sample
+ * @param id Track ID of the trigger sample
+ * @param sample The trigger sample
+ */
+void th_event_trigger(const int frame, const uint32_t id, const output_data* const sample);
+
+/** Terminate event thread and release associate resources.
+ * Pending events will be written with frames currently available in the ring.
+ */
+void th_event_destroy();
+
+#endif /* #ifndef INCLUDE_TH_EVENT_H */
\ No newline at end of file
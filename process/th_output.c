@@ -1,13 +1,22 @@
 #include <pthread.h>
 #include <stdio.h>
+#include <limits.h>
 #include <unistd.h>
 #include <sys/types.h>
 
 #include "th_output.h"
+#include "tracker.h"
+#include "th_event.h"
+#include "rollup.h"
+#include "archive.h"
 
 int _valid = 0;
 int p[2] = {0, 0};
 pthread_t tid; //Reader thread ID
+output_config _config;
+Tracker tracker = NULL;
+Rollup rollup = NULL;
+Archive archive = NULL;
 
 struct itc_header {
 	int frame;
@@ -16,9 +25,40 @@ struct itc_header {
 
 void* th_output(void* arg);
 
-int th_output_init() {
+int th_output_init(output_config config) {
+	_config = config;
+
+	char* statue;
+	tracker = tracker_init(config.trackGateX, config.trackGateY, config.trackTimeout, config.trackMinCount, &statue);
+	if (!tracker) {
+		fprintf(stderr, "Fail to create tracker for output thread: %s\n", statue);
+		return 0;
+	}
+
+	if (config.rollupFile) {
+		rollup = rollup_init(config.rollupFile, config.rollupInterval, config.trackTimeout, config.fps, config.laneOrigin, config.laneWidth, config.laneCnt, &statue); //Track is reported once it has not been updated for timeout frames
+		if (!rollup) {
+			fprintf(stderr, "Fail to create rollup for output thread: %s\n", statue);
+			tracker_destroy(tracker); tracker = NULL;
+			return 0;
+		}
+	}
+
+	if (config.archiveFile) {
+		archive = archive_init(config.archiveFile, config.fps, &statue);
+		if (!archive) {
+			fprintf(stderr, "Fail to create archive for output thread: %s\n", statue);
+			rollup_destroy(rollup); rollup = NULL;
+			tracker_destroy(tracker); tracker = NULL;
+			return 0;
+		}
+	}
+
 	if (pipe(p) == -1) {
 		fprintf(stderr, "Fail to create inter thread communication between main thread and output thread\n");
+		archive_destroy(archive); archive = NULL;
+		rollup_destroy(rollup); rollup = NULL;
+		tracker_destroy(tracker); tracker = NULL;
 		return 0;
 	}
 
@@ -30,6 +70,9 @@ int th_output_init() {
 		fprintf(stderr, "Fail to create output thread: %d\n", err);
 		close(p[0]); p[0] = 0;
 		close(p[1]); p[1] = 0;
+		archive_destroy(archive); archive = NULL;
+		rollup_destroy(rollup); rollup = NULL;
+		tracker_destroy(tracker); tracker = NULL;
 		return 0;
 	}
 
@@ -38,12 +81,15 @@ int th_output_init() {
 }
 
 void th_output_write(const int frame, const int count, output_data* data) {
+	if (!_valid)
+		return;
 	output_header header = {
 		.frame = frame,
 		.count = count
 	};
 	!write(p[1], &header, sizeof(output_header));
-	!write(p[1], data, count * sizeof(output_data));
+	if (count > 0)
+		!write(p[1], data, count * sizeof(output_data));
 }
 
 void th_output_destroy() {
@@ -51,11 +97,43 @@ void th_output_destroy() {
 		return;
 	_valid = 0;
 
-	close(p[0]); p[0] = 0;
-	close(p[1]); p[1] = 0;
-	
-	pthread_cancel(tid);
+	close(p[1]); p[1] = 0; //Output thread gets EOF and flushes all pending results, wait for it instead of cancel
 	pthread_join(tid, NULL);
+	close(p[0]); p[0] = 0;
+
+	archive_destroy(archive);
+	archive = NULL;
+	rollup_destroy(rollup);
+	rollup = NULL;
+	tracker_destroy(tracker);
+	tracker = NULL;
+}
+
+void th_output_track(const int frame) {
+	unsigned int count;
+	const tracker_summary* summary = tracker_expire(tracker, frame, &count);
+	if (rollup) {
+		for (const tracker_summary* ptr = summary; ptr < summary + count; ptr++)
+			rollup_add(rollup, ptr->exit, ptr->laneX, ptr->speedMedian);
+		rollup_tick(rollup, frame);
+	}
+	if (!(_config.mode & output_mode_track))
+		return;
+	for (const tracker_summary* ptr = summary; ptr < summary + count; ptr++) {
+		fprintf(stdout, "T %u %d-%d %u %d %d %.2f %.2f,%.2f\n", ptr->id, ptr->entry, ptr->exit, ptr->count, ptr->speedMedian, ptr->speedMax, ptr->laneX, ptr->entryY, ptr->exitY);
+	}
+}
+
+/** Read exactly size bytes from the pipe, large payload may come in multiple pieces
+ */
+static int th_output_read(void* const buffer, const size_t size) {
+	for (size_t done = 0; done < size; ) {
+		ssize_t r = read(p[0], (char*)buffer + done, size - done);
+		if (r <= 0)
+			return 0;
+		done += r;
+	}
+	return 1;
 }
 
 void* th_output(void* arg) {
@@ -64,16 +142,37 @@ void* th_output(void* arg) {
 
 	output_header header;
 	for(;;) {
-		!read(p[0], &header, sizeof(output_header));
-		if (header.count == -1)
+		if (!th_output_read(&header, sizeof(output_header)) || header.count == -1) {
+			th_output_track(INT_MAX); //Flush all tracks
+			fflush(stdout);
 			break;
-		
+		}
+
 		output_data data[header.count];
-		!read(p[0], data, header.count * sizeof(output_data));
+		if (!th_output_read(data, header.count * sizeof(output_data))) {
+			th_output_track(INT_MAX);
+			fflush(stdout);
+			break;
+		}
+
+		uint32_t ids[header.count];
+		tracker_update(tracker, header.frame, header.count, data, ids);
+		if (_config.eventSpeed > 0) {
+			for (int i = 0; i < header.count; i++) {
+				if (data[i].speed >= _config.eventSpeed && ids[i] != UINT32_MAX && !tracker_mark(tracker, ids[i])) //Once per vehicle
+					th_event_trigger(header.frame, ids[i], &data[i]);
+			}
+		}
+		th_output_track(header.frame);
+
+		if (archive)
+			archive_append(archive, header.frame, header.count, data);
 
-		fprintf(stdout, "F %u %u\n", header.frame, header.count);
-		for (output_data* ptr = data; ptr < data + header.count; ptr++) {
-			fprintf(stdout, "O %d %.2f,%.2f %u,%u %d\n", ptr->speed, ptr->rx, ptr->ry, ptr->sx, ptr->sy, ptr->osy);
+		if (_config.mode & output_mode_raw) {
+			fprintf(stdout, "F %u %u\n", header.frame, header.count);
+			for (output_data* ptr = data; ptr < data + header.count; ptr++) {
+				fprintf(stdout, "O %d %.2f,%.2f %u,%u %d\n", ptr->speed, ptr->rx, ptr->ry, ptr->sx, ptr->sy, ptr->osy);
+			}
 		}
 	}
 
@@ -1,10 +1,13 @@
+#ifndef INCLUDE_TH_OUTPUT_H
+#define INCLUDE_TH_OUTPUT_H
+
 #include <stdint.h>
 
 typedef struct Output_Data {
 	float rx, ry; //Road- and screen-domain coord of current frame
 	uint16_t sx, sy;
 	int16_t speed; //Speed (avged by shader)
-	int16_t osy; //Change in y-coord 
+	int16_t osy; //Change in y-coord
 } output_data;
 
 typedef struct Output_Header {
@@ -12,19 +15,44 @@ typedef struct Output_Header {
 	int count; //Number of data for current frame, use -1 to terminate thread
 } output_header;
 
+/** What to write to stdout */
+typedef enum Output_Mode {
+	output_mode_raw = 0b01,		//Every sample of every frame ("F" and "O" lines)
+	output_mode_track = 0b10,	//One summary per vehicle ("T" lines)
+} output_mode;
+
+/** Output config */
+typedef struct Output_Config {
+	output_mode mode;		//Bit mask of output_mode_*
+	float trackGateX;		//Tracker: Max lateral displacement (meter) between a sample and its track
+	float trackGateY;		//Tracker: Max displacement (meter) of an object in one frame
+	unsigned int trackTimeout;	//Tracker: Close a track if not updated for this number of frames
+	unsigned int trackMinCount;	//Tracker: Tracks with less samples are noise
+	const char* rollupFile;		//Rollup: Append per-lane statistics to this file (see rollup.h), NULL to disable
+	unsigned int rollupInterval;	//Rollup: Length of interval in frames
+	float laneOrigin, laneWidth;	//Rollup: Road-domain x-coord (meter) of the left side of the first lane, width of lane
+	unsigned int laneCnt;		//Rollup: Number of lanes
+	const char* archiveFile;	//Archive: Append every sample to this columnar archive (see archive.h), NULL to disable
+	float fps;			//Rollup and archive: Frame per second, to convert frame number into time
+	int16_t eventSpeed;		//Event: Write an event (see th_event.h) the first time a track reaches this speed (km/h), 0 to disable
+} output_config;
+
 /** Output thread init.
- * Prepare communication pipe, launch thread. 
+ * Prepare communication pipe, launch thread.
+ * @param config Output config
  * @return If success, return 1; if fail, release all resources and return 0
  */
-int th_output_init();
+int th_output_init(output_config config);
 
-/** Pass data to output. 
+/** Pass data to output.
  * @param frame Frame number
  * @param count Number of data, use -1 to terminate
  * @param data An array of @param count data objects
  */
 void th_output_write(const int frame, const int count, output_data* data);
 
-/** Terminate Output thread and release associate resources. 
+/** Terminate Output thread and release associate resources.
  */
-void th_output_destroy();
\ No newline at end of file
+void th_output_destroy();
+
+#endif /* #ifndef INCLUDE_TH_OUTPUT_H */
\ No newline at end of file
@@ -8,6 +8,7 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 
+#include "common.h"
 #include "th_reader.h"
 
 #define BLOCKSIZE 64 //Height and width are multiple of 8, so frame size is multiple of 64. Read a block (64px) at once can increase performance
@@ -30,6 +31,8 @@ volatile void volatile* rawDataPtr; //Video raw data goes here. Main thread writ
 struct { unsigned int r, g, b, a; } colorChannel; //Private, for reader read function
 unsigned int blockCnt; //Private, for reader read function
 FILE* fp; //Private, for reader read function
+void (* volatile readerTap)(const void* const frame, const unsigned int seq) = NULL; //Called after each frame is read
+uint64_t readerTimestamp = 0; //Time when the last frame is read, passed to main thread by sem_readerDone
 
 int th_reader_init(const unsigned int size, const char* colorScheme, char** statue, int* ecode) {
 	if (sem_init(&sem_readerStart, 0, 0)) {
@@ -74,10 +77,18 @@ void th_reader_start(void* addr) {
 	sem_post(&sem_readerStart);
 }
 
+void th_reader_tap(void (*tap)(const void* const frame, const unsigned int seq)) {
+	readerTap = tap;
+}
+
 void th_reader_wait() {
 	sem_wait(&sem_readerDone);
 }
 
+uint64_t th_reader_timestamp() {
+	return readerTimestamp;
+}
+
 void th_reader_destroy() {
 	if (!valid)
 		return;
@@ -147,9 +158,14 @@ void* th_reader(void* arg) {
 	reader_info("FIFO '"FIFONAME"' data received");
 
 	int readerShouldContinue = 1;
+	unsigned int seq = 0;
 	do {
 		sem_wait(&sem_readerStart); //Wait until main thread issue new memory address for next frame
 		readerShouldContinue = readFunction();
+		readerTimestamp = readerShouldContinue ? nanotime() : 0;
+		if (readerShouldContinue && readerTap)
+			readerTap((const void*)rawDataPtr, seq);
+		seq++;
 		sem_post(&sem_readerDone); //Uploading done, allow main thread to use it
 	} while (readerShouldContinue);
 
@@ -160,6 +176,7 @@ void* th_reader(void* arg) {
 	while (1) { //Send dummy data to keep the main thread running
 		sem_wait(&sem_readerStart); //Wait until main thread issue new memory address for next frame
 		memset((void*)rawDataPtr, 0, size * 4);
+		readerTimestamp = 0; //Not a frame from input
 		sem_post(&sem_readerDone); //Uploading done, allow main thread to use it
 	}
 
@@ -1,3 +1,5 @@
+#include <stdint.h>
+
 struct th_reader_arg {
 	unsigned int size; //Number of pixels in one frame
 	const char* colorScheme; //Color scheme of the input raw data (numberOfChannel[1,3or4],orderOfChannelRGBA) RGB=3012, RGBA=40123, BGR=3210
@@ -19,10 +21,23 @@ int th_reader_init(const unsigned int size, const char* colorScheme, char** stat
  */
 void th_reader_start(void* addr);
 
+/** Register a function to be called by reader thread every time a frame is read and converted to RGBA8. 
+ * The function runs in reader thread before the main thread is unblocked, it should be quick. 
+ * Set the tap before sending the first frame into the FIFO. 
+ * @param tap Function to call with the address of the frame and the reader frame number (start from 0), pass NULL to remove
+ */
+void th_reader_tap(void (*tap)(const void* const frame, const unsigned int seq));
+
 /** Call this function to block the main thread until reader thread finishing video reading. 
  */
 void th_reader_wait();
 
+/** Get the time when the reader thread finished reading the last frame. 
+ * Call this function after th_reader_wait(). 
+ * @return Timestamp in ns, same clock as nanotime()
+ */
+uint64_t th_reader_timestamp();
+
 /** Terminate reader thread and release associate resources
  */
 void th_reader_destroy();
\ No newline at end of file
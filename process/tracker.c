@@ -0,0 +1,209 @@
+#include <stdlib.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <math.h>
+
+#include "tracker.h"
+
+#define TRACKER_BUCKET 256 //Number of buckets in spatial hash, must be 2^n
+#define TRACKER_INITCNT 64 //Init size of track pool, grows when needed
+
+struct Tracker_Track {
+	uint32_t id;
+	int entry, last; //Frame number of first and last sample
+	uint32_t count;
+	float x, y; //Road-domain location of last sample
+	float sumX; //Accum x-coord, for lane
+	float entryY;
+	int16_t speedMax;
+	int8_t marked; //See tracker_mark()
+	int32_t next; //Next track in the same hash bucket, -1 for end of list
+	uint16_t histogram[256]; //Speed histogram, speed is 8-bit (see sample shader), used to find median
+};
+
+struct Tracker_ClassDataStructure {
+	float gateX, gateY; //Gate in meter
+	float cellX, cellY; //Size of hash cell in meter
+	unsigned int timeout, minCount;
+	uint32_t nextId;
+	struct Tracker_Track* tracks; //Active tracks, [0, activeCnt)
+	unsigned int activeCnt, trackCap;
+	tracker_summary* summary; //Closed tracks, returned by tracker_expire()
+	unsigned int summaryCap;
+	int32_t bucket[TRACKER_BUCKET]; //Head of list of each bucket, -1 for empty
+};
+
+static inline unsigned int tracker_hash(const int cx, const int cy) {
+	return ( (unsigned int)cx * 73856093U ^ (unsigned int)cy * 19349663U ) & (TRACKER_BUCKET - 1);
+}
+
+static inline void tracker_hashInsert(const Tracker this, const int32_t idx) {
+	struct Tracker_Track* t = &this->tracks[idx];
+	unsigned int b = tracker_hash(floorf(t->x / this->cellX), floorf(t->y / this->cellY));
+	t->next = this->bucket[b];
+	this->bucket[b] = idx;
+}
+
+Tracker tracker_init(const float gateX, const float gateY, const unsigned int timeout, const unsigned int minCount, char** const statue) {
+	Tracker this = malloc(sizeof(struct Tracker_ClassDataStructure));
+	if (!this) {
+		if (statue)
+			*statue = "Fail to create tracker class object data structure";
+		return NULL;
+	}
+	*this = (struct Tracker_ClassDataStructure){
+		.gateX = gateX, .gateY = gateY,
+		.cellX = gateX, .cellY = gateY * (timeout ? timeout : 1), //A track can move at most gateY * timeout before closed, so search in neighbor cells is enough
+		.timeout = timeout, .minCount = minCount,
+		.nextId = 0,
+		.tracks = NULL, .activeCnt = 0, .trackCap = TRACKER_INITCNT,
+		.summary = NULL, .summaryCap = TRACKER_INITCNT
+	};
+
+	this->tracks = malloc(this->trackCap * sizeof(struct Tracker_Track));
+	this->summary = malloc(this->summaryCap * sizeof(tracker_summary));
+	if (!this->tracks || !this->summary) {
+		if (statue)
+			*statue = "Fail to allocate memory for track pool";
+		tracker_destroy(this);
+		return NULL;
+	}
+
+	return this;
+}
+
+void tracker_update(const Tracker this, const int frame, const unsigned int count, const output_data* const data, uint32_t* const ids) {
+	for (unsigned int i = 0; i < TRACKER_BUCKET; i++) //Tracks move every frame, rebuild the hash
+		this->bucket[i] = -1;
+	for (unsigned int i = 0; i < this->activeCnt; i++)
+		tracker_hashInsert(this, i);
+
+	for (unsigned int i = 0; i < count; i++) {
+		const output_data* s = &data[i];
+		int cx = floorf(s->rx / this->cellX), cy = floorf(s->ry / this->cellY);
+
+		//Find closest track in gate, gate in y-axis grows if the track missed some frames
+		int32_t best = -1;
+		float bestDistance = INFINITY;
+		for (int dy = -1; dy <= 1; dy++) {
+			for (int dx = -1; dx <= 1; dx++) {
+				for (int32_t idx = this->bucket[tracker_hash(cx + dx, cy + dy)]; idx != -1; idx = this->tracks[idx].next) {
+					struct Tracker_Track* t = &this->tracks[idx];
+					int gap = frame - t->last;
+					if (gap > (int)this->timeout)
+						continue;
+					float gateY = this->gateY * (gap > 1 ? gap : 1);
+					float distanceX = fabsf(s->rx - t->x), distanceY = fabsf(s->ry - t->y);
+					if (distanceX > this->gateX || distanceY > gateY)
+						continue;
+					float distance = distanceX / this->gateX + distanceY / gateY; //Normalized to gate
+					if (distance < bestDistance) {
+						bestDistance = distance;
+						best = idx;
+					}
+				}
+			}
+		}
+
+		//No track nearby, this is a new object
+		if (best == -1) {
+			if (this->activeCnt == this->trackCap) {
+				struct Tracker_Track* new = realloc(this->tracks, this->trackCap * 2 * sizeof(struct Tracker_Track));
+				if (!new) { //Out of memory, drop this sample
+					if (ids)
+						ids[i] = UINT32_MAX;
+					continue;
+				}
+				this->tracks = new;
+				this->trackCap *= 2;
+			}
+			best = this->activeCnt++;
+			struct Tracker_Track* t = &this->tracks[best];
+			*t = (struct Tracker_Track){
+				.id = this->nextId++,
+				.entry = frame,
+				.entryY = s->ry,
+				.histogram = {0}
+			};
+			t->x = s->rx; //Set location before insert, hash is based on location
+			t->y = s->ry;
+			tracker_hashInsert(this, best);
+		}
+
+		struct Tracker_Track* t = &this->tracks[best];
+		int16_t speed = s->speed < 0 ? 0 : s->speed > 255 ? 255 : s->speed;
+		t->last = frame;
+		t->count++;
+		t->x = s->rx;
+		t->y = s->ry;
+		t->sumX += s->rx;
+		t->histogram[speed]++;
+		if (speed > t->speedMax)
+			t->speedMax = speed;
+		if (ids)
+			ids[i] = t->id;
+	}
+}
+
+int tracker_mark(const Tracker this, const uint32_t id) {
+	for (unsigned int i = 0; i < this->activeCnt; i++) { //Only a few active tracks, linear search is fine
+		struct Tracker_Track* t = &this->tracks[i];
+		if (t->id == id) {
+			int marked = t->marked;
+			t->marked = 1;
+			return marked;
+		}
+	}
+	return -1;
+}
+
+const tracker_summary* tracker_expire(const Tracker this, const int frame, unsigned int* const count) {
+	unsigned int summaryCnt = 0;
+	for (unsigned int i = 0; i < this->activeCnt; ) {
+		struct Tracker_Track* t = &this->tracks[i];
+		if (frame != INT_MAX && frame - t->last <= (int)this->timeout) {
+			i++;
+			continue;
+		}
+
+		if (t->count >= this->minCount) {
+			if (summaryCnt == this->summaryCap) {
+				tracker_summary* new = realloc(this->summary, this->summaryCap * 2 * sizeof(tracker_summary));
+				if (new) {
+					this->summary = new;
+					this->summaryCap *= 2;
+				}
+			}
+			if (summaryCnt < this->summaryCap) {
+				int16_t median = 0;
+				for (uint32_t accum = 0, half = (t->count + 1) / 2; median < 256; median++) {
+					accum += t->histogram[median];
+					if (accum >= half)
+						break;
+				}
+				this->summary[summaryCnt++] = (tracker_summary){
+					.id = t->id,
+					.entry = t->entry, .exit = t->last,
+					.count = t->count,
+					.speedMedian = median, .speedMax = t->speedMax,
+					.laneX = t->sumX / t->count,
+					.entryY = t->entryY, .exitY = t->y
+				};
+			}
+		}
+
+		*t = this->tracks[--this->activeCnt]; //Swap with last, do not increase i so the swapped one will be checked
+	}
+
+	*count = summaryCnt;
+	return this->summary;
+}
+
+void tracker_destroy(const Tracker this) {
+	if (!this)
+		return;
+
+	free(this->summary);
+	free(this->tracks);
+	free(this);
+}
\ No newline at end of file
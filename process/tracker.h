@@ -0,0 +1,72 @@
+/** Class - Tracker.class.
+ * Associate speed samples of different frames into per-vehicle tracks.
+ * Samples are matched by road-domain location (rx, ry), a spatial hash is used so each sample only checks tracks nearby.
+ * Each track is given an unique ID. When a track is not updated for a while, it is closed and a summary record is generated.
+ */
+
+#ifndef INCLUDE_TRACKER_H
+#define INCLUDE_TRACKER_H
+
+#include <inttypes.h>
+
+#include "th_output.h"
+
+/** Tracker class object data structure
+ */
+typedef struct Tracker_ClassDataStructure* Tracker;
+
+/** Summary of a closed track (one vehicle)
+ */
+typedef struct Tracker_Summary {
+	uint32_t id; //Track ID
+	int entry, exit; //Frame number of first and last sample
+	uint32_t count; //Number of samples associated to this track
+	int16_t speedMedian, speedMax; //Speed (km/h)
+	float laneX; //Road-domain x-coord, avg of all samples
+	float entryY, exitY; //Road-domain y-coord of first and last sample
+} tracker_summary;
+
+/** Init a tracker object, allocate memory for the track pool and the spatial hash.
+ * @param gateX Max road-domain x-coord (lateral) displacement (meter) between a sample and its track
+ * @param gateY Max road-domain y-coord displacement (meter) of an object in one frame
+ * @param timeout A track is closed if it has not been updated for this number of frames
+ * @param minCount Tracks with less samples are considered as noise and will not be reported
+ * @param statue If not NULL, return error message in case this function fail
+ * @return $this(Opaque) tracker class object upon success. If fail, free all resource and return NULL
+ */
+Tracker tracker_init(const float gateX, const float gateY, const unsigned int timeout, const unsigned int minCount, char** const statue);
+
+/** Associate samples of a frame to tracks.
+ * Each sample is associated to the closest active track in gate; if none, a new track is created.
+ * Frames must be passed in ascending order.
+ * @param this This tracker class object
+ * @param frame Frame number of the samples
+ * @param count Number of samples
+ * @param data An array of @param count samples
+ * @param ids If not NULL, return the track ID of each sample
+ */
+void tracker_update(const Tracker this, const int frame, const unsigned int count, const output_data* const data, uint32_t* const ids);
+
+/** Set the mark flag of an active track, the flag is cleared when the track is closed.
+ * Use this to do something only once per vehicle (e.g. report a violation).
+ * @param this This tracker class object
+ * @param id Track ID, returned by tracker_update()
+ * @return Previous mark flag (1 or 0); if the track is not active, return -1
+ */
+int tracker_mark(const Tracker this, const uint32_t id);
+
+/** Close tracks that have not been updated since @param frame - timeout.
+ * The returned buffer is owned by this tracker and is valid until next call of any tracker method.
+ * @param this This tracker class object
+ * @param frame Current frame number, pass INT_MAX to close all tracks (flush)
+ * @param count Pass-by-reference, number of summaries returned
+ * @return An array of summaries of closed tracks
+ */
+const tracker_summary* tracker_expire(const Tracker this, const int frame, unsigned int* const count);
+
+/** Destroy this tracker class object, frees resources.
+ * @param this This tracker class object
+ */
+void tracker_destroy(const Tracker this);
+
+#endif /* #ifndef INCLUDE_TRACKER_H */
\ No newline at end of file